@@ -0,0 +1,66 @@
+#pragma once
+// Minimal in-tree benchmark harness with the Google Benchmark surface the suites need
+// (State range-for, Arg(), counters, DoNotOptimize) and its JSON output format, so
+// compare.py also accepts results produced by the real library.
+//   static void BM_Foo(bench::State& st){ for (auto _ : st) { ...; } st.SetItemsProcessed(st.iterations()); }
+//   BENCHMARK(BM_Foo)->Arg(4)->Arg(16);
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+class State {
+ public:
+  struct __attribute__((unused)) Value {};   // `for (auto _ : st)` without unused warnings
+  struct Iterator {
+    uint64_t left;
+    bool operator!=(const Iterator& o) const { return left != o.left; }
+    void operator++(){ --left; }
+    Value operator*() const { return Value(); }
+  };
+
+  State(uint64_t iterations, int64_t arg) : _iters(iterations), _arg(arg) {}
+  Iterator begin();   // starts the clock
+  Iterator end(){ return Iterator{0}; }
+
+  int64_t range(size_t = 0) const { return _arg; }
+  uint64_t iterations() const { return _iters; }
+  void SetItemsProcessed(int64_t n){ _items = n; }
+  void SetBytesProcessed(int64_t n){ _bytes = n; }
+  void SetLabel(const std::string& l){ _label = l; }
+  void SkipWithError(const char* msg){ _error = msg ? msg : "error"; }
+
+  // read by the runner
+  int64_t _items = 0, _bytes = 0;
+  std::string _label, _error;
+  uint64_t _startNs = 0;
+
+ private:
+  uint64_t _iters;
+  int64_t _arg;
+};
+
+using Fn = void (*)(State&);
+
+struct Benchmark {
+  Benchmark(const char* name, Fn fn);
+  Benchmark* Arg(int64_t a){ args.push_back(a); return this; }
+  std::string name;
+  Fn fn;
+  std::vector<int64_t> args;
+};
+
+template <class T>
+inline void DoNotOptimize(T const& value){ asm volatile("" : : "r,m"(value) : "memory"); }
+inline void ClobberMemory(){ asm volatile("" : : : "memory"); }
+
+uint64_t nowNs();
+int runAll(int argc, char** argv);
+
+}  // namespace bench
+
+#define BENCH_CAT_(a, b) a##b
+#define BENCH_CAT(a, b) BENCH_CAT_(a, b)
+#define BENCHMARK(fn) \
+  static ::bench::Benchmark* BENCH_CAT(bench_reg_, __LINE__) __attribute__((unused)) = (new ::bench::Benchmark(#fn, fn))
@@ -0,0 +1,55 @@
+#include "bench.h"
+#include "fixtures.h"
+#include "announce_cache.h"
+
+// Uncached announce: describe() of every tool into a growing doc, then serialize
+static void BM_BuildAnnounce(bench::State& st){
+  BenchRegistry r((int)st.range());
+  size_t bytes = 0;
+  for (auto _ : st) {
+    String s = r.reg.buildAnnounce("bench-device", kBenchHttpBase);
+    bytes = s.length();
+    bench::DoNotOptimize(s.c_str());
+  }
+  st.SetBytesProcessed((int64_t)(st.iterations() * bytes));
+  st.SetLabel(std::to_string(bytes) + " B");
+}
+BENCHMARK(BM_BuildAnnounce)->Arg(4)->Arg(16)->Arg(64);
+
+// Boot-time cache build (no NVS): describe() once + schema hash
+static void BM_AnnounceCacheBuild(bench::State& st){
+  BenchRegistry r((int)st.range());
+  for (auto _ : st) {
+    AnnounceCache c;
+    bench::DoNotOptimize(c.build(r.reg, "bench-fw"));
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_AnnounceCacheBuild)->Arg(4)->Arg(16)->Arg(64);
+
+// Cached paths used at runtime: retained pointer announce and /announce.json splice
+static void BM_AnnouncePointer(bench::State& st){
+  BenchRegistry r(16);
+  AnnounceCache c;
+  c.build(r.reg, "bench-fw");
+  for (auto _ : st) {
+    String s = c.pointerJson("bench-device", kBenchHttpBase);
+    bench::DoNotOptimize(s.c_str());
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_AnnouncePointer);
+
+static void BM_AnnounceFullCached(bench::State& st){
+  BenchRegistry r((int)st.range());
+  AnnounceCache c;
+  c.build(r.reg, "bench-fw");
+  size_t bytes = 0;
+  for (auto _ : st) {
+    String s = c.fullJson("bench-device", kBenchHttpBase);
+    bytes = s.length();
+    bench::DoNotOptimize(s.c_str());
+  }
+  st.SetBytesProcessed((int64_t)(st.iterations() * bytes));
+}
+BENCHMARK(BM_AnnounceFullCached)->Arg(16)->Arg(64);
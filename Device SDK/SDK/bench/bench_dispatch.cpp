@@ -0,0 +1,157 @@
+#include "bench.h"
+#include "fixtures.h"
+#include "rule_engine.h"
+
+// Name lookup alone (FNV-1a index), last tool registered
+static void BM_RegistryFind(bench::State& st){
+  BenchRegistry r((int)st.range());
+  char name[24];
+  snprintf(name, sizeof(name), "bench.tool_%02d", (int)st.range() - 1);
+  for (auto _ : st) bench::DoNotOptimize(r.reg.find(name));
+  st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_RegistryFind)->Arg(4)->Arg(16)->Arg(64);
+
+// dispatch() on a parsed command: lookup, invoke, URL resolve
+static void BM_Dispatch(bench::State& st){
+  BenchRegistry r((int)st.range());
+  DynamicJsonDocument cmd(EXEC_ARGS_DOC_SIZE);
+  deserializeJson(cmd, benchCommand("bench.tool_00"));
+  for (auto _ : st) {
+    ObservationBuilder out;
+    bench::DoNotOptimize(r.reg.dispatch(cmd, out));
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_Dispatch)->Arg(4)->Arg(64);
+
+// What ToolRuntime::handle() does per JSON command: parse, dispatch, serialize the reply
+static void BM_ParseDispatchSerializeJson(bench::State& st){
+  BenchRegistry r(8);
+  const String payload = benchCommand("bench.tool_03");
+  CountingPrint sink;
+  for (auto _ : st) {
+    DocLease lease(EXEC_ARGS_DOC_SIZE);
+    deserializeJson(lease.doc(), payload.c_str(), payload.length());
+    ObservationBuilder out(r.reg.replyBytes(lease.doc()["tool"] | ""));
+    r.reg.dispatch(lease.doc(), out);
+    serializeJson(out.doc, sink);
+  }
+  st.SetItemsProcessed(st.iterations());
+  st.SetBytesProcessed((int64_t)(st.iterations() * payload.length()));
+}
+BENCHMARK(BM_ParseDispatchSerializeJson);
+
+// Same over MessagePack (cmd.mp / events.mp)
+static void BM_ParseDispatchSerializeMsgPack(bench::State& st){
+  BenchRegistry r(8);
+  DynamicJsonDocument tmp(512);
+  deserializeJson(tmp, benchCommand("bench.tool_03"));
+  std::vector<uint8_t> payload(measureMsgPack(tmp));
+  serializeMsgPack(tmp, payload.data(), payload.size());
+  CountingPrint sink;
+  for (auto _ : st) {
+    DocLease lease(EXEC_ARGS_DOC_SIZE);
+    deserializeMsgPack(lease.doc(), (const uint8_t*)payload.data(), payload.size());   // copy: payload is reused
+    ObservationBuilder out(r.reg.replyBytes(lease.doc()["tool"] | ""));
+    r.reg.dispatch(lease.doc(), out);
+    serializeMsgPack(out.doc, sink);
+  }
+  st.SetItemsProcessed(st.iterations());
+  st.SetBytesProcessed((int64_t)(st.iterations() * payload.size()));
+}
+BENCHMARK(BM_ParseDispatchSerializeMsgPack);
+
+// Retried request_id: answered from the ResultCache without invoking the tool
+static void BM_DispatchCachedRetry(bench::State& st){
+  BenchRegistry r(8);
+  DynamicJsonDocument cmd(EXEC_ARGS_DOC_SIZE);
+  deserializeJson(cmd, benchCommand("bench.tool_03", "bench-retry-1"));
+  std::string expected;   // MsgPack is binary: std::string, not Arduino String
+  { ObservationBuilder first; r.reg.dispatch(cmd, first); serializeMsgPack(first.doc, expected); }
+  const uint32_t hits0 = r.reg.cacheStats().hits;
+  for (auto _ : st) {
+    ObservationBuilder out;
+    bench::DoNotOptimize(r.reg.dispatch(cmd, out));
+  }
+  st.SetItemsProcessed(st.iterations());
+
+  // every retry was a hit, and the slot still replays the original reply
+  ObservationBuilder again;
+  const bool ok = r.reg.dispatch(cmd, again);
+  std::string replay;
+  serializeMsgPack(again.doc, replay);
+  if (r.reg.cacheStats().hits - hits0 != st.iterations() + 1) st.SkipWithError("retry missed the cache");
+  else if (!ok || replay != expected) st.SkipWithError("cached reply changed between retries");
+}
+BENCHMARK(BM_DispatchCachedRetry);
+
+// device.command_batch of n sequential steps: one parse, one combined reply
+static void BM_DispatchBatch(bench::State& st){
+  BenchRegistry r(8);
+  DynamicJsonDocument cmd(EXEC_ARGS_DOC_SIZE);
+  cmd["type"] = "device.command_batch";
+  cmd["cache"] = false;
+  JsonArray steps = cmd.createNestedArray("steps");
+  for (int i = 0; i < (int)st.range(); i++) {
+    JsonObject s = steps.createNestedObject();
+    s["tool"] = i & 1 ? "bench.tool_01" : "bench.tool_00";
+    s["args"]["channel"] = i;
+    s["args"]["level"] = 0.5;
+  }
+  for (auto _ : st) {
+    ObservationBuilder out(r.reg.replyBytes(cmd));
+    bench::DoNotOptimize(r.reg.dispatch(cmd, out));
+  }
+  st.SetItemsProcessed(st.iterations() * st.range());
+}
+BENCHMARK(BM_DispatchBatch)->Arg(1)->Arg(3)->Arg(8);
+
+// EventTool subscribe path (op routing in EventTool::invoke)
+static void BM_DispatchEventSubscribe(bench::State& st){
+  BenchRegistry r(8);
+  DynamicJsonDocument cmd(EXEC_ARGS_DOC_SIZE);
+  deserializeJson(cmd, "{\"type\":\"device.command\",\"tool\":\"bench.event\",\"args\":{\"op\":\"subscribe\",\"debounce_ms\":20}}");
+  for (auto _ : st) {
+    ObservationBuilder out;
+    bench::DoNotOptimize(r.reg.dispatch(cmd, out));
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_DispatchEventSubscribe);
+
+// Rule matching per emitted event (RuleEngine::observe), n rules of which one matches
+static void BM_RuleObserve(bench::State& st){
+  BenchRegistry r(8);
+  RuleEngine rules(r.reg);
+  DynamicJsonDocument msg(4096);
+  msg["type"] = "device.rules";
+  JsonArray arr = msg.createNestedArray("rules");
+  for (int i = 0; i < (int)st.range(); i++) {
+    JsonObject rule = arr.createNestedObject();
+    rule["id"] = String("r") + String(i);
+    JsonObject when = rule.createNestedObject("when");
+    when["source"] = "bench.event";
+    when["event"] = i ? "edge.other" : "edge";
+    when["field"] = "value"; when["op"] = ">="; when["value"] = 0.5;
+    rule["do"]["tool"] = "bench.tool_00";
+  }
+  bool loaded;
+  { ObservationBuilder reply; loaded = rules.load(msg, reply); }
+  ObservationBuilder ev;
+  ev.doc["source"] = "bench.event";
+  JsonObject a = ev.addAsset();
+  a["event_type"] = "edge";
+  a["value"] = 1;
+  uint32_t now = 0;
+  for (auto _ : st) {
+    rules.observe(ev, now += 1000);
+    rules.run(now, nullptr);
+  }
+  st.SetItemsProcessed(st.iterations());
+  const RuleEngine::Stats& rs = rules.stats();
+  if (!loaded) st.SkipWithError("rules did not load");
+  else if (rs.failed) st.SkipWithError("rule action failed");
+  else if ((int64_t)rs.fired != st.iterations()) st.SkipWithError("matching rule did not fire every event");
+}
+BENCHMARK(BM_RuleObserve)->Arg(1)->Arg(16);
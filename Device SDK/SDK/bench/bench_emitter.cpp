@@ -0,0 +1,143 @@
+#include "bench.h"
+#include "fixtures.h"
+#include "mqtt_emitter.h"
+#include "async_mqtt_transport.h"
+#include "batching_emitter.h"
+#include "outbox_emitter.h"
+#include "tool_runtime.h"
+#include <algorithm>
+
+static void eventObservation(ObservationBuilder& ob, int i){
+  ob.doc["source"] = "bench.event";
+  ob.doc["event_type"] = "edge";
+  ob.success("rising");
+  JsonObject a = ob.addAsset();
+  a["kind"] = "signal";
+  a["value"] = i;
+}
+
+// AsyncMqttTransport over the shim socket; without FreeRTOS its pass runs inline (loop(),
+// or reserve() when the tx ring is full), so every publish is written within the benchmark
+struct BenchMqtt {
+  PubSubClient client;
+  AsyncMqttTransport mqtt{client};
+  DeviceTopics topics{"bench-device"};
+  BenchMqtt(){
+    MqttTransport::Config c;
+    c.host = "bench";
+    c.client_id = "bench-device";
+    mqtt.begin(c);
+    mqtt.loop(millis());   // connect
+  }
+  void flush(){ mqtt.loop(millis()); }
+};
+
+// Event straight through MqttObservationEmitter → publishDoc → tx ring → shim socket
+static void BM_MqttEmitter(bench::State& st){
+  BenchMqtt m;
+  MqttObservationEmitter em(m.mqtt, m.topics, kBenchHttpBase);
+  em.set_format(st.range() ? WireFormat::MsgPack : WireFormat::Json);
+  ObservationBuilder ob;
+  eventObservation(ob, 1);
+  for (auto _ : st) bench::DoNotOptimize(em.emit(ob));
+  m.flush();
+  st.SetItemsProcessed((int64_t)m.client.messages());
+  st.SetBytesProcessed((int64_t)m.client.bytes());
+  st.SetLabel(st.range() ? "msgpack" : "json");
+}
+BENCHMARK(BM_MqttEmitter)->Arg(0)->Arg(1);
+
+// Batching window: n events coalesced into one observation_batch publish
+static void BM_BatchingEmitter(bench::State& st){
+  BenchMqtt m;
+  MqttObservationEmitter em(m.mqtt, m.topics, kBenchHttpBase);
+  BatchingEmitter::Config cfg;
+  cfg.window_ms = 1000000;   // flushed explicitly below
+  BatchingEmitter batch(em, cfg);
+  ObservationBuilder ob;
+  const int n = (int)st.range();
+  for (auto _ : st) {
+    for (int i = 0; i < n; i++) { ob.reset(); eventObservation(ob, i); batch.emit(ob); }
+    batch.flush();
+  }
+  m.flush();
+  st.SetItemsProcessed((int64_t)(st.iterations() * n));
+  st.SetBytesProcessed((int64_t)m.client.bytes());
+}
+BENCHMARK(BM_BatchingEmitter)->Arg(4)->Arg(16);
+
+// Offline: events parked in the outbox, replayed by poll() once the broker is back
+static void BM_OutboxReplay(bench::State& st){
+  BenchMqtt m;
+  MqttObservationEmitter em(m.mqtt, m.topics, kBenchHttpBase);
+  OutboxEmitter outbox(em);
+  ObservationBuilder ob;
+  const int n = (int)std::min<int64_t>(st.range(), OUTBOX_SLOTS);
+  uint32_t now = 0;
+  for (auto _ : st) {
+    m.client.setConnected(false);
+    m.flush();               // transport sees the drop
+    for (int i = 0; i < n; i++) { ob.reset(); eventObservation(ob, i); outbox.emit(ob); }
+    m.mqtt.retryNow();
+    m.flush();               // reconnect without waiting out the backoff
+    while (outbox.pending()) outbox.poll(now += 1000);
+  }
+  m.flush();
+  st.SetItemsProcessed((int64_t)m.client.messages());
+}
+BENCHMARK(BM_OutboxReplay)->Arg(8);
+
+// Whole command path in cooperative mode: submitCommand → step (parse, dispatch) → drain → publish
+static void BM_RuntimeRoundTrip(bench::State& st){
+  BenchRegistry r(8);
+  ToolExecutor exec;
+  ToolRuntime rt(r.reg, exec);
+  BenchMqtt m;
+  const String payload = benchCommand("bench.tool_03");
+  for (auto _ : st) {
+    rt.submitCommand((const uint8_t*)payload.c_str(), payload.length(), WireFormat::Json);
+    rt.step(millis());
+    rt.drain([&](ToolRuntime::Kind, WireFormat fmt, const ObservationBuilder& ob){
+      publishDoc(m.mqtt, m.topics.events.c_str(), ob.doc, fmt);
+    });
+  }
+  m.flush();
+  st.SetItemsProcessed((int64_t)m.client.messages());
+  if (m.client.messages() != st.iterations()) st.SkipWithError("reply missing");
+}
+BENCHMARK(BM_RuntimeRoundTrip);
+
+// device.command_batch through the runtime: the combined reply (spilled past RUNTIME_OBS_BYTES
+// when it has to be) must reach the sink with every step in it
+static void BM_RuntimeBatch(bench::State& st){
+  BenchRegistry r(8);
+  ToolExecutor exec;
+  ToolRuntime rt(r.reg, exec);
+  DynamicJsonDocument cmd(EXEC_ARGS_DOC_SIZE);
+  cmd["type"] = "device.command_batch";
+  cmd["request_id"] = "bench-batch";
+  cmd["cache"] = false;
+  JsonArray steps = cmd.createNestedArray("steps");
+  for (int i = 0; i < (int)st.range(); i++) {
+    JsonObject s = steps.createNestedObject();
+    s["tool"] = i & 1 ? "bench.tool_01" : "bench.tool_00";
+    s["args"]["channel"] = i;
+    s["args"]["level"] = 0.5;
+  }
+  String payload;
+  serializeJson(cmd, payload);
+  int64_t replies = 0, complete = 0;
+  for (auto _ : st) {
+    rt.submitCommand((const uint8_t*)payload.c_str(), payload.length(), WireFormat::Json);
+    rt.step(millis());
+    rt.drain([&](ToolRuntime::Kind k, WireFormat, const ObservationBuilder& ob){
+      if (k != ToolRuntime::Kind::Reply) return;
+      replies++;
+      if (ob.doc["result"]["steps"].size() == (size_t)st.range()) complete++;
+    });
+  }
+  st.SetItemsProcessed(replies * st.range());
+  if (replies != st.iterations() || rt.stats().obs_dropped) st.SkipWithError("batch reply missing");
+  else if (complete != replies) st.SkipWithError("batch reply lost steps");
+}
+BENCHMARK(BM_RuntimeBatch)->Arg(3)->Arg(8);
@@ -0,0 +1,147 @@
+#include "bench.h"
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <regex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace bench {
+
+static std::vector<Benchmark*>& registry(){ static std::vector<Benchmark*> r; return r; }
+
+Benchmark::Benchmark(const char* n, Fn f) : name(n), fn(f) { registry().push_back(this); }
+
+uint64_t nowNs(){
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+State::Iterator State::begin(){ _startNs = nowNs(); return Iterator{_iters}; }
+
+struct Result {
+  std::string name, label, error;
+  uint64_t iterations = 0;
+  double ns = 0;            // per iteration
+  double items = 0, bytes = 0;   // per second
+};
+
+static Result runOnce(Benchmark& b, int64_t arg, uint64_t iters){
+  State st(iters, arg);
+  b.fn(st);
+  const uint64_t end = nowNs();
+  Result r;
+  r.iterations = iters;
+  r.error = st._error;
+  r.label = st._label;
+  const double secs = st._startNs ? (double)(end - st._startNs) / 1e9 : 0;
+  r.ns = iters ? secs * 1e9 / (double)iters : 0;
+  if (secs > 0) { r.items = (double)st._items / secs; r.bytes = (double)st._bytes / secs; }
+  return r;
+}
+
+// grow the iteration count until one run takes min_time, then keep that run
+static Result measure(Benchmark& b, int64_t arg, double minTime){
+  uint64_t iters = 1;
+  for (;;) {
+    Result r = runOnce(b, arg, iters);
+    const double secs = r.ns * (double)iters / 1e9;
+    if (!r.error.empty() || secs >= minTime || iters >= 1000000000ull) return r;
+    double mult = secs > 0 ? minTime * 1.4 / secs : 10;
+    mult = std::min(10.0, std::max(mult, 1.5));
+    iters = (uint64_t)((double)iters * mult) + 1;
+  }
+}
+
+static std::string jsonEscape(const std::string& s){
+  std::string o;
+  for (char c : s) { if (c == '"' || c == '\\') o += '\\'; o += c; }
+  return o;
+}
+
+static bool flag(const char* a, const char* name, const char** val){
+  size_t n = strlen(name);
+  if (strncmp(a, name, n) != 0 || a[n] != '=') return false;
+  *val = a + n + 1;
+  return true;
+}
+
+int runAll(int argc, char** argv){
+  std::string filter = ".", out;
+  double minTime = 0.5;
+  int reps = 1;
+  for (int i = 1; i < argc; i++) {
+    const char* v = nullptr;
+    if (flag(argv[i], "--benchmark_filter", &v)) filter = v;
+    else if (flag(argv[i], "--benchmark_min_time", &v)) minTime = atof(v);
+    else if (flag(argv[i], "--benchmark_repetitions", &v)) reps = std::max(1, atoi(v));
+    else if (flag(argv[i], "--benchmark_out", &v)) out = v;
+    else if (flag(argv[i], "--benchmark_out_format", &v)) { if (strcmp(v, "json") != 0) { fprintf(stderr, "only json output\n"); return 2; } }
+    else if (strcmp(argv[i], "--benchmark_list_tests") == 0) {
+      for (auto* b : registry()) {
+        if (b->args.empty()) printf("%s\n", b->name.c_str());
+        for (auto a : b->args) printf("%s/%lld\n", b->name.c_str(), (long long)a);
+      }
+      return 0;
+    } else {
+      fprintf(stderr, "usage: %s [--benchmark_filter=<regex>] [--benchmark_min_time=<s>]\n"
+                      "          [--benchmark_repetitions=<n>] [--benchmark_out=<file.json>]\n", argv[0]);
+      return 2;
+    }
+  }
+  const std::regex re(filter);
+
+  std::vector<Result> results;
+  printf("%-44s %14s %12s %14s\n", "Benchmark", "Time", "Iterations", "Rate");
+  printf("%s\n", std::string(88, '-').c_str());
+  for (auto* b : registry()) {
+    std::vector<int64_t> args = b->args;
+    const bool plain = args.empty();
+    if (plain) args.push_back(0);
+    for (auto a : args) {
+      const std::string name = plain ? b->name : b->name + "/" + std::to_string(a);
+      if (!std::regex_search(name, re)) continue;
+      // median of the repetitions: one noisy run does not move the baseline
+      std::vector<Result> rs;
+      for (int i = 0; i < reps; i++) rs.push_back(measure(*b, a, minTime));
+      std::sort(rs.begin(), rs.end(), [](const Result& x, const Result& y){ return x.ns < y.ns; });
+      Result r = rs[rs.size() / 2];
+      r.name = name;
+      if (!r.error.empty()) { printf("%-44s ERROR: %s\n", name.c_str(), r.error.c_str()); continue; }
+      char rate[32] = "";
+      if (r.bytes > 0)      snprintf(rate, sizeof(rate), "%.1f MB/s", r.bytes / 1e6);
+      else if (r.items > 0) snprintf(rate, sizeof(rate), "%.3g it/s", r.items);
+      printf("%-44s %11.0f ns %12llu %14s %s\n", name.c_str(), r.ns, (unsigned long long)r.iterations,
+             rate, r.label.c_str());
+      results.push_back(r);
+    }
+  }
+
+  if (!out.empty()) {
+    FILE* f = fopen(out.c_str(), "w");
+    if (!f) { perror(out.c_str()); return 1; }
+    char date[32];
+    time_t t = time(nullptr);
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&t));
+    fprintf(f, "{\n  \"context\": {\"date\": \"%s\", \"executable\": \"%s\", \"library\": \"mcp-bench\"},\n"
+               "  \"benchmarks\": [\n", date, jsonEscape(argv[0]).c_str());
+    for (size_t i = 0; i < results.size(); i++) {
+      const Result& r = results[i];
+      fprintf(f, "    {\"name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %llu, "
+                 "\"real_time\": %.2f, \"cpu_time\": %.2f, \"time_unit\": \"ns\"",
+              jsonEscape(r.name).c_str(), (unsigned long long)r.iterations, r.ns, r.ns);
+      if (r.items > 0) fprintf(f, ", \"items_per_second\": %.2f", r.items);
+      if (r.bytes > 0) fprintf(f, ", \"bytes_per_second\": %.2f", r.bytes);
+      if (!r.label.empty()) fprintf(f, ", \"label\": \"%s\"", jsonEscape(r.label).c_str());
+      fprintf(f, "}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+  }
+  return 0;
+}
+
+}  // namespace bench
+
+int main(int argc, char** argv){ return bench::runAll(argc, argv); }
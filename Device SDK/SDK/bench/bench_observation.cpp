@@ -0,0 +1,83 @@
+#include "bench.h"
+#include "fixtures.h"
+
+static void fillReply(ObservationBuilder& ob, int assets, bool relative){
+  ob.setRequestId("bench-req-0001");
+  ob.success("captured 2 images");
+  for (int i = 0; i < assets; i++) {
+    JsonObject a = ob.addAsset();
+    a["kind"] = "image";
+    a["mime"] = "image/jpeg";
+    a["width"] = 640; a["height"] = 480;
+    if (relative) a["url"] = "/last.jpg?rid=bench-req-0001";
+    else          ob.setAssetUrl(a, "/last.jpg?rid=bench-req-0001");
+  }
+}
+
+// Pooled builder lease + reset() (every command and event pays this)
+static void BM_ObservationBuilderLease(bench::State& st){
+  for (auto _ : st) {
+    ObservationBuilder ob;
+    bench::DoNotOptimize(ob.doc.memoryUsage());
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_ObservationBuilderLease);
+
+// Absolute URLs written at build time (setAssetUrl) vs patched afterwards (resolveUrls)
+static void BM_ObservationSetAssetUrl(bench::State& st){
+  ObservationBuilder::setHttpBase(kBenchHttpBase);
+  for (auto _ : st) {
+    ObservationBuilder ob;
+    fillReply(ob, (int)st.range(), false);
+    bench::DoNotOptimize(ob.doc.memoryUsage());
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_ObservationSetAssetUrl)->Arg(1)->Arg(4);
+
+static void BM_ObservationResolveUrls(bench::State& st){
+  ObservationBuilder::setHttpBase(kBenchHttpBase);
+  for (auto _ : st) {
+    ObservationBuilder ob;
+    fillReply(ob, (int)st.range(), true);
+    ob.resolveUrls();
+    bench::DoNotOptimize(ob.doc.memoryUsage());
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_ObservationResolveUrls)->Arg(1)->Arg(4);
+
+// Serialization of a finished reply, straight to a Print (what publishDoc streams)
+static void BM_ObservationSerializeJson(bench::State& st){
+  ObservationBuilder::setHttpBase(kBenchHttpBase);
+  ObservationBuilder ob;
+  fillReply(ob, (int)st.range(), false);
+  CountingPrint sink;
+  for (auto _ : st) serializeJson(ob.doc, sink);
+  st.SetBytesProcessed((int64_t)sink.n);
+}
+BENCHMARK(BM_ObservationSerializeJson)->Arg(1)->Arg(4);
+
+static void BM_ObservationSerializeMsgPack(bench::State& st){
+  ObservationBuilder::setHttpBase(kBenchHttpBase);
+  ObservationBuilder ob;
+  fillReply(ob, (int)st.range(), false);
+  CountingPrint sink;
+  for (auto _ : st) serializeMsgPack(ob.doc, sink);
+  st.SetBytesProcessed((int64_t)sink.n);
+}
+BENCHMARK(BM_ObservationSerializeMsgPack)->Arg(1)->Arg(4);
+
+// Legacy String round trip (ToolRegistry::dispatch(cmd, String&) / ob.toJson())
+static void BM_ObservationToJsonString(bench::State& st){
+  ObservationBuilder::setHttpBase(kBenchHttpBase);
+  ObservationBuilder ob;
+  fillReply(ob, 1, false);
+  for (auto _ : st) {
+    String s = ob.toJson();
+    bench::DoNotOptimize(s.c_str());
+  }
+  st.SetItemsProcessed(st.iterations());
+}
+BENCHMARK(BM_ObservationToJsonString);
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Compare two benchmark result files (mcp_bench or Google Benchmark JSON).
+
+    compare.py baseline.json bench.json [--threshold 10]
+
+Prints the per-benchmark time change and exits 1 if any benchmark got slower than
+the threshold (percent). Benchmarks missing on either side are listed, not failed.
+"""
+import argparse
+import json
+import os
+import sys
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    out = {}
+    for b in data.get("benchmarks", []):
+        # only the per-iteration rows (aggregate rows carry run_type "aggregate")
+        if b.get("run_type", "iteration") != "iteration" or b.get("error_occurred"):
+            continue
+        out[b["name"]] = float(b["real_time"])
+    return out
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("baseline")
+    ap.add_argument("current")
+    ap.add_argument("--threshold", type=float, default=10.0, help="allowed slowdown in percent")
+    args = ap.parse_args()
+
+    if not os.path.exists(args.baseline):
+        print(f"no baseline at {args.baseline}; record one with the bench-baseline target")
+        return 0
+    base, cur = load(args.baseline), load(args.current)
+
+    regressions = []
+    print(f"{'Benchmark':44} {'base ns':>12} {'now ns':>12} {'change':>9}")
+    for name in sorted(base.keys() & cur.keys()):
+        b, c = base[name], cur[name]
+        delta = (c - b) / b * 100.0 if b > 0 else 0.0
+        mark = ""
+        if delta > args.threshold:
+            mark = "  << slower"
+            regressions.append(name)
+        elif delta < -args.threshold:
+            mark = "  faster"
+        print(f"{name:44} {b:12.0f} {c:12.0f} {delta:+8.1f}%{mark}")
+    for name in sorted(base.keys() - cur.keys()):
+        print(f"{name:44} (missing in current run)")
+    for name in sorted(cur.keys() - base.keys()):
+        print(f"{name:44} (new, no baseline)")
+
+    if regressions:
+        print(f"\n{len(regressions)} benchmark(s) slower than {args.threshold:.0f}%: {', '.join(regressions)}")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,93 @@
+#pragma once
+// Tools and helpers shared by the suites. Schemas and replies are sized like the shipped
+// modules (camera, LED, event tools) so announce/dispatch numbers track real firmware.
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <memory>
+#include <vector>
+#include "registry.h"
+#include "event_tool.h"
+
+// Action tool: enum/number parameters, text reply plus one relative-URL asset
+class BenchTool : public ITool {
+ public:
+  explicit BenchTool(int i){ snprintf(_name, sizeof(_name), "bench.tool_%02d", i); }
+  bool init() override { return true; }
+  const char* name() const override { return _name; }
+  void describe(JsonObject& tool) override {
+    tool["name"] = name();
+    tool["description"] = "Benchmark fixture: set a level on a channel (mode: steady|blink|fade)";
+    JsonObject params = tool.createNestedObject("parameters");
+    params["type"] = "object";
+    JsonObject props = params.createNestedObject("properties");
+    props["channel"]["type"] = "integer";
+    props["level"]["type"] = "number";
+    props["level"]["description"] = "0..1";
+    JsonArray mode = props.createNestedObject("mode").createNestedArray("enum");
+    mode.add("steady"); mode.add("blink"); mode.add("fade");
+    JsonArray req = params.createNestedArray("required");
+    req.add("channel"); req.add("level");
+  }
+  bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
+    int ch = args["channel"] | 0;
+    float level = args["level"] | 0.0f;
+    char text[48];
+    snprintf(text, sizeof(text), "channel %d set to %.2f", ch, level);
+    out.success(text);
+    JsonObject a = out.addAsset();
+    a["kind"] = "image";
+    a["mime"] = "image/jpeg";
+    a["url"] = "/last.jpg?rid=bench";   // relative: resolveUrls() patches it
+    return true;
+  }
+ private:
+  char _name[24];
+};
+
+// Event tool with a filter parameter and one signal
+class BenchEventTool : public EventTool {
+ public:
+  BenchEventTool() : EventTool("bench.event", "Benchmark fixture: edge events on a pin") {}
+ protected:
+  bool onSubscribe(JsonObjectConst, ObservationBuilder& out) override { out.success("subscribed"); return true; }
+  bool onUnsubscribe(JsonObjectConst, ObservationBuilder& out) override { out.success("unsubscribed"); return true; }
+  void buildExtraParameters(JsonObject& props) override { props["debounce_ms"]["type"] = "integer"; }
+  void buildSignals(JsonObject& sigs) override { sigs["edge"]["type"] = "string"; }
+};
+
+// Registry with n action tools (+ one event tool), kept alive for the whole process
+struct BenchRegistry {
+  ToolRegistry reg;
+  std::vector<std::unique_ptr<ITool>> tools;
+  explicit BenchRegistry(int n){
+    for (int i = 0; i < n; i++) { tools.emplace_back(new BenchTool(i)); reg.add(tools.back().get()); }
+    tools.emplace_back(new BenchEventTool());
+    reg.add(tools.back().get());
+    reg.initAll();
+  }
+};
+
+inline const char* kBenchHttpBase = "http://192.168.0.42";
+
+// Command as the bridge sends it; no request_id unless asked (generated ids skip the result cache)
+inline String benchCommand(const char* tool, const char* rid = nullptr){
+  DynamicJsonDocument cmd(512);
+  cmd["type"] = "device.command";
+  cmd["tool"] = tool;
+  if (rid) cmd["request_id"] = rid;
+  JsonObject args = cmd.createNestedObject("args");
+  args["channel"] = 3;
+  args["level"] = 0.75;
+  args["mode"] = "fade";
+  String s;
+  serializeJson(cmd, s);
+  return s;
+}
+
+// Print sink that only counts (serialization cost without transport)
+struct CountingPrint : Print {
+  size_t n = 0;
+  size_t write(uint8_t) override { return ++n, 1; }
+  size_t write(const uint8_t*, size_t len) override { n += len; return len; }
+  using Print::write;
+};
@@ -0,0 +1,61 @@
+#include "Arduino.h"
+#include <chrono>
+#include <thread>
+
+HostSerial Serial;
+
+static const auto kStart = std::chrono::steady_clock::now();
+
+unsigned long millis(){
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - kStart).count();
+}
+
+unsigned long micros(){
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - kStart).count();
+}
+
+void delay(unsigned long ms){ std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+#if defined(__GLIBC__) && !(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38))
+size_t strlcpy(char* dst, const char* src, size_t size){
+  size_t n = strlen(src);
+  if (size) {
+    size_t c = n < size - 1 ? n : size - 1;
+    memcpy(dst, src, c);
+    dst[c] = 0;
+  }
+  return n;
+}
+#endif
+
+size_t Print::printf(const char* fmt, ...){
+  char buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return 0;
+  if ((size_t)n < sizeof(buf)) return write((const uint8_t*)buf, (size_t)n);
+  std::string big((size_t)n + 1, '\0');
+  va_start(ap, fmt);
+  vsnprintf(&big[0], big.size(), fmt, ap);
+  va_end(ap);
+  return write((const uint8_t*)big.data(), (size_t)n);
+}
+
+static bool serialEnabled(){
+  static const bool on = [](){ const char* e = getenv("MCP_HOST_SERIAL"); return e && e[0] == '1'; }();
+  return on;
+}
+
+size_t HostSerial::write(uint8_t c){
+  if (serialEnabled()) fputc(c, stderr);
+  return 1;
+}
+
+size_t HostSerial::write(const uint8_t* data, size_t len){
+  if (serialEnabled()) fwrite(data, 1, len, stderr);
+  return len;
+}
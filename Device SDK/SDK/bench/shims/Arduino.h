@@ -0,0 +1,112 @@
+#pragma once
+// Host shim of the Arduino core subset used by mcp-sdk / event-sdk (bench/ only).
+// Not a port: just enough String/Print/Serial/time for the SDK to build and run on a PC.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <string>
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+inline void yield() {}
+inline long random(long max){ return max > 0 ? rand() % max : 0; }
+
+#if defined(__GLIBC__) && !(__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38))
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* data, size_t len){
+    size_t n = 0;
+    while (len--) n += write(*data++);
+    return n;
+  }
+  size_t write(const char* s){ return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+  size_t print(const char* s){ return write(s); }
+  size_t print(char c){ return write((uint8_t)c); }
+  size_t print(int v){ return printf("%d", v); }
+  size_t print(unsigned v){ return printf("%u", v); }
+  size_t print(long v){ return printf("%ld", v); }
+  size_t print(unsigned long v){ return printf("%lu", v); }
+  size_t println(){ return write((uint8_t)'\n'); }
+  template <typename T> size_t println(T v){ size_t n = print(v); return n + println(); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+// Serial output is dropped unless MCP_HOST_SERIAL=1 is set in the environment (→ stderr)
+class HostSerial : public Print {
+ public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* data, size_t len) override;
+  using Print::write;
+};
+extern HostSerial Serial;
+
+class String {
+ public:
+  String() {}
+  String(const char* s) : _s(s ? s : "") {}
+  String(const std::string& s) : _s(s) {}
+  explicit String(char c) : _s(1, c) {}
+  explicit String(int v) : _s(std::to_string(v)) {}
+  explicit String(unsigned v) : _s(std::to_string(v)) {}
+  explicit String(long v) : _s(std::to_string(v)) {}
+  explicit String(unsigned long v) : _s(std::to_string(v)) {}
+
+  const char* c_str() const { return _s.c_str(); }
+  unsigned int length() const { return (unsigned int)_s.size(); }
+  bool isEmpty() const { return _s.empty(); }
+  bool reserve(unsigned int n){ _s.reserve(n); return true; }
+  bool concat(const char* s){ if (s) _s += s; return true; }
+  bool concat(const char* s, unsigned int n){ if (s) _s.append(s, n); return true; }
+  bool concat(char c){ _s += c; return true; }
+  bool concat(const String& s){ _s += s._s; return true; }
+
+  String& operator+=(const char* s){ concat(s); return *this; }
+  String& operator+=(const String& s){ concat(s); return *this; }
+  String& operator+=(char c){ concat(c); return *this; }
+
+  bool operator==(const String& o) const { return _s == o._s; }
+  bool operator==(const char* o) const { return _s == (o ? o : ""); }
+  bool operator!=(const String& o) const { return !(*this == o); }
+  bool operator!=(const char* o) const { return !(*this == o); }
+  bool operator<(const String& o) const { return _s < o._s; }
+  char operator[](unsigned int i) const { return i < _s.size() ? _s[i] : 0; }
+  char charAt(unsigned int i) const { return (*this)[i]; }
+
+  bool startsWith(const String& p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+  bool endsWith(const String& p) const {
+    return _s.size() >= p._s.size() && _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0;
+  }
+  int indexOf(char c, unsigned int from = 0) const { size_t i = _s.find(c, from); return i == std::string::npos ? -1 : (int)i; }
+  int indexOf(const String& s, unsigned int from = 0) const { size_t i = _s.find(s._s, from); return i == std::string::npos ? -1 : (int)i; }
+  String substring(unsigned int from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+  String substring(unsigned int from, unsigned int to) const {
+    return from < to && from < _s.size() ? String(_s.substr(from, to - from)) : String();
+  }
+  void remove(unsigned int idx){ if (idx < _s.size()) _s.erase(idx); }
+  void remove(unsigned int idx, unsigned int count){ if (idx < _s.size()) _s.erase(idx, count); }
+  long toInt() const { return strtol(_s.c_str(), nullptr, 10); }
+
+ private:
+  std::string _s;
+};
+
+// Arduino's `String + x` yields a StringSumHelper; ArduinoJson adapts both types
+class StringSumHelper : public String {
+ public:
+  StringSumHelper(const String& s) : String(s) {}
+};
+
+inline StringSumHelper operator+(const String& a, const String& b){ String r(a); r += b; return r; }
+inline StringSumHelper operator+(const String& a, const char* b){ String r(a); r += b; return r; }
+inline StringSumHelper operator+(const char* a, const String& b){ String r(a); r += b; return r; }
+inline StringSumHelper operator+(const String& a, char b){ String r(a); r += b; return r; }
@@ -0,0 +1,46 @@
+#pragma once
+// Host shim of the ESP32 Preferences (NVS) API: in-memory, process lifetime
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+ public:
+  bool begin(const char* ns, bool readOnly = false){ _ns = &store()[ns]; _ro = readOnly; return true; }
+  void end(){ _ns = nullptr; }
+  bool clear(){ if (!_ns || _ro) return false; _ns->clear(); return true; }
+  bool remove(const char* key){ return _ns && !_ro && _ns->erase(key) > 0; }
+  bool isKey(const char* key){ return _ns && _ns->count(key); }
+
+  size_t putBytes(const char* key, const void* v, size_t len){
+    if (!_ns || _ro) return 0;
+    const uint8_t* p = (const uint8_t*)v;
+    (*_ns)[key].assign(p, p + len);
+    return len;
+  }
+  size_t getBytesLength(const char* key){ return isKey(key) ? (*_ns)[key].size() : 0; }
+  size_t getBytes(const char* key, void* buf, size_t maxLen){
+    if (!isKey(key)) return 0;
+    auto& v = (*_ns)[key];
+    size_t n = v.size() < maxLen ? v.size() : maxLen;
+    memcpy(buf, v.data(), n);
+    return n;
+  }
+  size_t putUInt(const char* key, uint32_t v){ return putBytes(key, &v, sizeof(v)); }
+  uint32_t getUInt(const char* key, uint32_t def = 0){ uint32_t v = def; return getBytes(key, &v, sizeof(v)) == sizeof(v) ? v : def; }
+  size_t putUChar(const char* key, uint8_t v){ return putBytes(key, &v, 1); }
+  uint8_t getUChar(const char* key, uint8_t def = 0){ uint8_t v = def; return getBytes(key, &v, 1) ? v : def; }
+  size_t putString(const char* key, const String& v){ return putBytes(key, v.c_str(), v.length()); }
+  String getString(const char* key, const String& def = String()){
+    if (!isKey(key)) return def;
+    auto& v = (*_ns)[key];
+    return String(std::string(v.begin(), v.end()));
+  }
+
+ private:
+  using Namespace = std::map<std::string, std::vector<uint8_t>>;
+  static std::map<std::string, Namespace>& store(){ static std::map<std::string, Namespace> s; return s; }
+  Namespace* _ns = nullptr;
+  bool _ro = false;
+};
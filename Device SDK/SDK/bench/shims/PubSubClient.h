@@ -0,0 +1,67 @@
+#pragma once
+// Host shim of PubSubClient: no network, every publish lands in counters (and optionally a
+// copy of the last payload), so emitter benchmarks measure the SDK side only.
+// The broker is always reachable: connect() succeeds, setConnected(false) drops the link.
+#include <Arduino.h>
+#include <functional>
+#include <string>
+
+class PubSubClient : public Print {
+ public:
+  void setConnected(bool c){ _connected = c; }
+  bool connected(){ return _connected; }
+  void keepLast(bool k){ _keep = k; }
+
+  void setServer(const char*, uint16_t) {}
+  void setCallback(std::function<void(char*, uint8_t*, unsigned int)>) {}
+  void setKeepAlive(uint16_t) {}
+  bool setBufferSize(uint16_t) { return true; }
+  bool connect(const char*, const char*, const char*, const char*, uint8_t, bool, const char*, bool){
+    _connected = true;
+    return true;
+  }
+  bool subscribe(const char*, uint8_t){ return _connected; }
+  bool loop(){ return _connected; }
+  void disconnect(){ _connected = false; }
+  int state() const { return _connected ? 0 : -1; }
+
+  bool beginPublish(const char* topic, unsigned int plength, bool retained){
+    (void)retained;
+    if (!_connected) return false;
+    _topic = topic ? topic : "";
+    _expected = plength;
+    _written = 0;
+    if (_keep) _last.clear();
+    return true;
+  }
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* data, size_t len) override {
+    _written += len;
+    if (_keep) _last.append((const char*)data, len);
+    return len;
+  }
+  int endPublish(){
+    _messages++;
+    _bytes += _written;
+    return _written == _expected ? 1 : 0;
+  }
+  bool publish(const char* topic, const uint8_t* payload, unsigned int len, bool retained = false){
+    return beginPublish(topic, len, retained) && write(payload, len) == len && endPublish() == 1;
+  }
+  bool publish(const char* topic, const char* payload, bool retained = false){
+    return publish(topic, (const uint8_t*)payload, (unsigned int)strlen(payload), retained);
+  }
+
+  unsigned long messages() const { return _messages; }
+  unsigned long long bytes() const { return _bytes; }
+  const std::string& lastTopic() const { return _topic; }
+  const std::string& lastPayload() const { return _last; }
+
+ private:
+  bool _connected = true;
+  bool _keep = false;
+  std::string _topic, _last;
+  size_t _expected = 0, _written = 0;
+  unsigned long _messages = 0;
+  unsigned long long _bytes = 0;
+};
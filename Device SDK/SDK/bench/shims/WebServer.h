@@ -0,0 +1,53 @@
+#pragma once
+// Host shim of the ESP32 WebServer: tools may register handlers (ITool::register_http);
+// they are recorded and can be invoked by name, nothing listens on a socket.
+#include <Arduino.h>
+#include <functional>
+#include <map>
+#include <string>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_POST };
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+class WebServer {
+ public:
+  using THandlerFunction = std::function<void(void)>;
+  explicit WebServer(int port = 80) { (void)port; }
+
+  void on(const char* uri, THandlerFunction fn){ _handlers[uri] = fn; }
+  void on(const char* uri, HTTPMethod, THandlerFunction fn){ on(uri, fn); }
+  void onNotFound(THandlerFunction fn){ _notFound = fn; }
+  void begin() {}
+  void handleClient() {}
+
+  // drives a registered handler with the given query args
+  bool request(const char* uri, std::map<std::string, std::string> args = {}){
+    auto it = _handlers.find(uri);
+    _args = std::move(args);
+    _code = 0; _body.clear();
+    if (it != _handlers.end()) it->second();
+    else if (_notFound) _notFound();
+    else return false;
+    return true;
+  }
+
+  String arg(const char* name){ auto it = _args.find(name); return it == _args.end() ? String() : String(it->second); }
+  bool hasArg(const char* name){ return _args.count(name) > 0; }
+  String header(const char*){ return String(); }
+  void sendHeader(const char*, const String&, bool = false) {}
+  void setContentLength(size_t) {}
+  void send(int code, const char* = nullptr, const String& body = String()){ _code = code; _body = body.c_str(); }
+  void send_P(int code, const char*, const char* body, size_t len){ _code = code; _body.assign(body, len); }
+  void sendContent(const char* data, size_t len){ _body.append(data, len); }
+  void sendContent(const String& s){ _body += s.c_str(); }
+
+  int lastCode() const { return _code; }
+  const std::string& lastBody() const { return _body; }
+
+ private:
+  std::map<std::string, THandlerFunction> _handlers;
+  THandlerFunction _notFound;
+  std::map<std::string, std::string> _args;
+  int _code = 0;
+  std::string _body;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <ArduinoJson.h>
+#include "mqtt_transport.h"
+#include "tool.h"
+#include "asset_source.h"
+#include "metrics.h"
+#include "mcp_log.h"
+#include "transports/topics.h"   // DeviceTopics::assets
+
+// Streams the transport:"mqtt" assets of an observation as sequenced chunks
+// (contract in asset_source.h). Each chunk is copied into a transport publish buffer, so the
+// source is closed as soon as its chunks are queued.
+// Call on the network task right before publishing the observation itself, so the receiver
+// normally holds the bytes by the time it reads the asset entry. Returns assets sent.
+inline uint8_t pushMqttAssets(MqttTransport& mqtt, const DeviceTopics& topics, const ObservationBuilder& ob){
+  JsonArrayConst assets = ob.doc["result"]["assets"];
+  uint8_t sent = 0;
+  for (JsonObjectConst a : assets) {
+    if (strcmp(a["transport"] | "", "mqtt") != 0) continue;
+    const char* id = a["asset_id"] | "";
+    if (!id[0] || !mqtt.connected()) continue;
+    char topic[MQTT_TOPIC_MAX];
+    if ((size_t)snprintf(topic, sizeof(topic), "%s%s", topics.assets.c_str(), id) >= sizeof(topic)) continue;
+
+    AssetRef ref;
+    IAssetSource* src = AssetSources::open(id, ref);
+    const uint32_t total = src ? (uint32_t)ref.len : 0;
+    const uint16_t count = src ? (uint16_t)((total + ASSET_CHUNK_BYTES - 1) / ASSET_CHUNK_BYTES) : 0;
+    bool ok = true;
+    uint16_t seq = 0;
+    do {   // count == 0 still sends one header-only "gone" marker
+      const uint32_t off = (uint32_t)seq * ASSET_CHUNK_BYTES;
+      const size_t n = total - off < ASSET_CHUNK_BYTES ? total - off : ASSET_CHUNK_BYTES;
+      uint8_t hdr[16] = { 'M','C','P','A',
+        (uint8_t)seq, (uint8_t)(seq >> 8), (uint8_t)count, (uint8_t)(count >> 8),
+        (uint8_t)off, (uint8_t)(off >> 8), (uint8_t)(off >> 16), (uint8_t)(off >> 24),
+        (uint8_t)total, (uint8_t)(total >> 8), (uint8_t)(total >> 16), (uint8_t)(total >> 24) };
+      const size_t len = sizeof(hdr) + (count ? n : 0);
+      uint8_t* buf = mqtt.reserve(len);
+      ok = buf != nullptr;
+      if (ok) {
+        memcpy(buf, hdr, sizeof(hdr));
+        if (count) memcpy(buf + sizeof(hdr), ref.data + off, n);
+        ok = mqtt.publishReserved(topic, len, MQTT_EVENTS_QOS, false);
+      }
+    } while (ok && ++seq < count);
+    if (src) src->closeAsset(ref);
+
+    if (ok) METRIC_COUNT("mcp_mqtt_publish_bytes_total", "asset", total);
+    MCP_LOGD("ASSET", "%s %s (%u bytes, %u chunks)", id,
+             !src ? "gone" : ok ? "queued" : "push failed", (unsigned)total, (unsigned)count);
+    if (src && ok) sent++;
+  }
+  return sent;
+}
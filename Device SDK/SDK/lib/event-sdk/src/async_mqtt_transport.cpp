@@ -0,0 +1,210 @@
+#include "async_mqtt_transport.h"
+#include <string.h>
+#include "metrics.h"
+#include "mcp_log.h"
+
+// Tx buffers: PSRAM when present, rounded up so small size changes reuse the slot's buffer
+static uint8_t* txAlloc(size_t& n){
+  n = (n + 255) & ~(size_t)255;
+#if defined(ESP32)
+  if (psramFound()) if (void* p = ps_malloc(n)) return (uint8_t*)p;
+#endif
+  return (uint8_t*)malloc(n);
+}
+
+bool AsyncMqttTransport::subscribe(const char* topic, uint8_t qos){
+  if (_started || _nsubs >= MQTT_MAX_SUBS || !topic) return false;
+  _subs[_nsubs].topic = topic;
+  _subs[_nsubs].qos = qos;
+  _nsubs++;
+  return true;
+}
+
+bool AsyncMqttTransport::begin(const Config& cfg){
+  if (_started || !cfg.host || !cfg.client_id) return false;
+  _host = cfg.host;
+  _clientId = cfg.client_id;
+  _willTopic = cfg.will_topic ? cfg.will_topic : "";
+  _willPayload = cfg.will_payload ? cfg.will_payload : "";
+  _cfg = cfg;
+
+  _mqtt.setServer(_host.c_str(), cfg.port);
+  _mqtt.setCallback([this](char* topic, uint8_t* payload, unsigned int len){ received(topic, payload, len); });
+  _mqtt.setKeepAlive(cfg.keepalive_s);
+  _mqtt.setBufferSize(MQTT_RX_BYTES + MQTT_TOPIC_MAX + 8);   // inbound only: publishes stream past it
+  _retryAt = millis();
+  _started = true;
+
+#if defined(ESP32)
+  _threaded = xTaskCreatePinnedToCore(&_taskLoop, "MqttTask", MQTT_TASK_STACK, this, 1,
+                                      &_task, MQTT_TASK_CORE) == pdPASS;
+#endif
+  if (_threaded) Serial.printf("[MQTT] client task on core %d\n", MQTT_TASK_CORE);
+  else           Serial.println("[MQTT] client runs from loop()");
+  return true;
+}
+
+void AsyncMqttTransport::disconnect(){
+  _stop = true;
+  wake();
+  if (!_threaded) service(millis());
+}
+
+// ---- network side ----
+void AsyncMqttTransport::loop(uint32_t now_ms){
+  if (!_threaded) service(now_ms);
+  if (_lostEvt.exchange(false))
+    MCP_LOGW("MQTT", "connection lost, retry in %lums", (unsigned long)_stats.backoff_ms);
+  if (_connectedEvt.exchange(false) && _onConnect) _onConnect();
+  while (Rx* r = _rx.front()) {
+    if (_onMessage) _onMessage(r->topic, r->data, r->len);
+    _rx.pop();
+  }
+}
+
+uint8_t* AsyncMqttTransport::reserve(size_t len){
+  Tx* m = _tx.beginPush();
+#if defined(ESP32)
+  // MqttTask empties the ring as fast as the socket takes it; give it a moment, unless it is
+  // offline (nothing is sent until the reconnect) or already failed to keep up
+  if (!m && _threaded && connected() && !_txStalled.load(std::memory_order_relaxed)) {
+    for (uint32_t w = millis(); !m && millis() - w < MQTT_TX_WAIT_MS; m = _tx.beginPush()) {
+      wake();
+      vTaskDelay(1);
+    }
+    if (!m) {
+      _txStalled.store(true, std::memory_order_relaxed);
+      MCP_LOGW("MQTT", "tx ring full for %ums, publishes fail until it drains", (unsigned)MQTT_TX_WAIT_MS);
+    }
+  }
+#endif
+  if (!m && !_threaded) { service(millis()); m = _tx.beginPush(); }
+  if (m && m->cap < len + 1) {
+    free(m->data);
+    size_t cap = len + 1;
+    m->data = txAlloc(cap);
+    m->cap = m->data ? cap : 0;
+  }
+  if (!m || !m->data) {
+    _stats.tx_dropped++;
+    METRIC_COUNT("mcp_mqtt_publish_total", "full", 1);
+    return nullptr;
+  }
+  return m->data;
+}
+
+bool AsyncMqttTransport::publishReserved(const char* topic, size_t len, uint8_t /*qos*/, bool retain){
+  Tx* m = _tx.beginPush();   // the slot reserve() handed out
+  if (!m || !m->data || len >= m->cap || strlen(topic) >= sizeof(m->topic)) {
+    _stats.tx_dropped++;
+    return false;
+  }
+  strcpy(m->topic, topic);
+  m->len = len;
+  m->retain = retain;
+  _tx.commitPush();
+  wake();
+  return true;
+}
+
+// ---- MqttTask side ----
+void AsyncMqttTransport::received(const char* topic, const uint8_t* payload, unsigned int len){
+  Rx* r = len <= MQTT_RX_BYTES && strlen(topic) < MQTT_TOPIC_MAX ? _rx.beginPush() : nullptr;
+  if (!r) {
+    _stats.rx_dropped++;
+    MCP_LOGW("MQTT", "RX dropped %s (%u bytes, queue %u/%u)",
+             topic, len, (unsigned)_rx.size(), (unsigned)_rx.capacity());
+    return;
+  }
+  strcpy(r->topic, topic);
+  memcpy(r->data, payload, len);
+  r->len = (uint16_t)len;
+  _rx.commitPush();
+}
+
+bool AsyncMqttTransport::flushTx(){
+  while (Tx* m = _tx.front()) {
+    const bool ok = _mqtt.beginPublish(m->topic, m->len, m->retain) &&
+                    _mqtt.write(m->data, m->len) == m->len &&
+                    _mqtt.endPublish() == 1;
+    if (!ok && !_mqtt.connected()) return false;   // stays queued for the next connection
+    METRIC_COUNT("mcp_mqtt_publish_total", ok ? "ok" : "fail", 1);
+    if (!ok) _stats.tx_failed++;
+    _tx.pop();
+    _txStalled.store(false, std::memory_order_relaxed);
+  }
+  return true;
+}
+
+bool AsyncMqttTransport::connect(){
+  const bool ok = _mqtt.connect(_clientId.c_str(), nullptr, nullptr,
+                                _willTopic.length() ? _willTopic.c_str() : nullptr, 0,
+                                _cfg.will_retain, _willPayload.c_str(), _cfg.clean_session);
+  METRIC_COUNT("mcp_mqtt_connect_total", ok ? "ok" : "fail", 1);
+  if (!ok) return false;
+  // a resumed session still has them; subscribing again is harmless and covers a broker restart
+  bool subOk = true;
+  for (uint8_t i=0; i<_nsubs; i++) subOk = _mqtt.subscribe(_subs[i].topic.c_str(), _subs[i].qos) && subOk;
+  MCP_LOGI("MQTT", "connected to %s:%u as %s, %u subscription(s) %s", _host.c_str(), (unsigned)_cfg.port,
+           _clientId.c_str(), (unsigned)_nsubs, subOk ? "ok" : "FAILED");
+  return true;
+}
+
+void AsyncMqttTransport::service(uint32_t now_ms){
+  if (!_started) return;
+  if (_stop) {
+    if (_mqtt.connected()) { flushTx(); _mqtt.disconnect(); }
+    _wasUp = false;
+    _up.store(false, std::memory_order_release);
+    return;
+  }
+
+  if (_wasUp && _mqtt.connected()) {
+    _kick = false;
+    _mqtt.loop();                 // keepalive + inbound (-> received())
+    flushTx();
+    if (_mqtt.connected()) return;
+  }
+  if (_wasUp) {
+    _wasUp = false;
+    _up.store(false, std::memory_order_release);
+    _stats.disconnects++;
+    _stats.backoff_ms = _backoff.next();
+    _retryAt = now_ms + _stats.backoff_ms;
+    _lostEvt = true;
+  }
+  if (!_kick && (int32_t)(now_ms - _retryAt) < 0) return;
+  _kick = false;
+
+  if (!connect()) {
+    _stats.failures++;
+    _stats.backoff_ms = _backoff.next();
+    _retryAt = millis() + _stats.backoff_ms;   // the attempt itself may have taken seconds
+    MCP_LOGW("MQTT", "connect failed (state=%d), retry in %lums", _mqtt.state(), (unsigned long)_stats.backoff_ms);
+    return;
+  }
+  _backoff.reset();
+  _stats.backoff_ms = 0;
+  _stats.connects++;
+  _wasUp = true;
+  _up.store(true, std::memory_order_release);
+  _connectedEvt = true;
+  flushTx();                      // whatever was queued while the link was down
+}
+
+void AsyncMqttTransport::wake(){
+#if defined(ESP32)
+  if (_task) xTaskNotifyGive(_task);
+#endif
+}
+
+#if defined(ESP32)
+void AsyncMqttTransport::_taskLoop(void* pv){
+  AsyncMqttTransport* self = static_cast<AsyncMqttTransport*>(pv);
+  for (;;) {
+    self->service(millis());
+    // publishReserved()/retryNow() wake us early
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(MQTT_TASK_IDLE_MS));
+  }
+}
+#endif
@@ -0,0 +1,105 @@
+#pragma once
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <atomic>
+#include "mqtt_transport.h"
+#include "spsc_queue.h"
+
+#if defined(ESP32)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+#endif
+
+#ifndef MQTT_TASK_CORE
+#define MQTT_TASK_CORE 0          // with NetTask; connect/write stalls then only cost this task
+#endif
+#ifndef MQTT_TASK_STACK
+#define MQTT_TASK_STACK 6144
+#endif
+#ifndef MQTT_TASK_IDLE_MS
+#define MQTT_TASK_IDLE_MS 10      // longest sleep between loop() passes while connected
+#endif
+#ifndef MQTT_TX_SLOTS
+#define MQTT_TX_SLOTS 8           // power of two
+#endif
+#ifndef MQTT_TX_WAIT_MS
+#define MQTT_TX_WAIT_MS 50        // reserve() waits this long for a free slot (once per stall) before failing
+#endif
+#ifndef MQTT_RX_SLOTS
+#define MQTT_RX_SLOTS 4           // power of two
+#endif
+#ifndef MQTT_RX_BYTES
+#define MQTT_RX_BYTES 2048        // largest command payload, keep = RUNTIME_CMD_BYTES (larger: rx_dropped)
+#endif
+#ifndef MQTT_MAX_SUBS
+#define MQTT_MAX_SUBS 4
+#endif
+
+// MqttTransport over PubSubClient, with PubSubClient owned by a task of its own:
+//   network task --reserve/publishReserved--> [tx ring] --> MqttTask: connect, loop(), write
+//   MqttTask (PubSubClient callback) --> [rx ring] --> network task: loop() -> onMessage
+// Connecting (DNS, TCP, CONNECT/CONNACK) blocks only MqttTask; between attempts it backs off
+// exponentially. The session is persistent (clean_session=false) and the subscriptions are
+// QoS1, so commands published while the device was away arrive after the reconnect.
+// Tx slots own grow-only buffers (PSRAM when present), so a publish is as large as its payload;
+// what is queued when the link drops is sent after the next connect. While the ring is full
+// and MqttTask is stuck (half-open socket) or offline, reserve() fails at once instead of
+// stalling the caller MQTT_TX_WAIT_MS for every publish; the first pop clears the stall.
+// Inbound messages are copied into MQTT_RX_BYTES slots: a larger command is dropped. PubSubClient publishes
+// QoS0 only: delivery of replies/events across outages comes from the OutboxEmitter.
+// Without FreeRTOS (host builds) there is no MqttTask and loop() runs its pass inline.
+class AsyncMqttTransport : public MqttTransport {
+ public:
+  explicit AsyncMqttTransport(PubSubClient& mqtt) : _mqtt(mqtt) {}
+
+  bool subscribe(const char* topic, uint8_t qos) override;
+  bool begin(const Config& cfg) override;
+  void loop(uint32_t now_ms) override;
+  bool connected() const override { return _up.load(std::memory_order_acquire); }
+  void retryNow() override { _kick = true; wake(); }
+  void disconnect() override;
+
+  uint8_t* reserve(size_t len) override;
+  bool publishReserved(const char* topic, size_t len, uint8_t qos, bool retain) override;
+
+  bool threaded() const { return _threaded; }
+  size_t pendingTx() const { return _tx.size(); }
+#if defined(ESP32)
+  TaskHandle_t task() const { return _task; }
+#endif
+
+ private:
+  struct Tx { char topic[MQTT_TOPIC_MAX]; uint8_t* data = nullptr; size_t cap = 0, len = 0; bool retain = false; };
+  struct Rx { char topic[MQTT_TOPIC_MAX]; uint16_t len; uint8_t data[MQTT_RX_BYTES]; };
+  struct Sub { String topic; uint8_t qos; };
+
+  void service(uint32_t now_ms);   // MqttTask's pass
+  bool connect();
+  bool flushTx();
+  void received(const char* topic, const uint8_t* payload, unsigned int len);
+  void wake();
+
+  PubSubClient& _mqtt;
+  String _host, _clientId, _willTopic, _willPayload;   // PubSubClient keeps the pointers
+  Config _cfg;
+  Sub _subs[MQTT_MAX_SUBS];
+  uint8_t _nsubs = 0;
+
+  SpscQueue<Tx, MQTT_TX_SLOTS> _tx;
+  SpscQueue<Rx, MQTT_RX_SLOTS> _rx;
+  MqttBackoff _backoff;
+
+  std::atomic<bool> _up{false};
+  std::atomic<bool> _connectedEvt{false}, _lostEvt{false};
+  volatile bool _kick = false;
+  volatile bool _stop = false;
+  std::atomic<bool> _txStalled{false};   // a reserve() wait timed out, MqttTask has not popped since
+  bool _started = false;
+  bool _wasUp = false;              // MqttTask side
+  uint32_t _retryAt = 0;
+  bool _threaded = false;
+#if defined(ESP32)
+  TaskHandle_t _task = nullptr;
+  static void _taskLoop(void* pv);
+#endif
+};
@@ -0,0 +1,152 @@
+#pragma once
+#include "obs_emitter.h"
+#include "mcp_log.h"
+
+#ifndef EVENT_BATCH_WINDOW_MS
+#define EVENT_BATCH_WINDOW_MS 0      // 0 = batching off (opt-in)
+#endif
+#ifndef EVENT_BATCH_MAX_BYTES
+#define EVENT_BATCH_MAX_BYTES 1536   // flush before the batch doc grows past this
+#endif
+
+// Opt-in batching layer on top of another emitter (usually MqttObservationEmitter).
+// Event assets collected within window_ms are coalesced into one device.observation_batch:
+//   { "type":"device.observation_batch", "ok":true,
+//     "result": { "text":"<n> events", "assets":[ {...asset, "source":tool, "ts_ms":uptime, "text":..}, ...] } }
+// - Delivery::Urgent observations and command replies (request_id set) bypass the window
+// - Delivery::Latest replaces a pending asset with the same source + event_type
+// - one batch for all sources, not one per source: every asset carries its "source", and a
+//   single pending doc keeps the RAM and publish count flat however many tools emit
+// - everything is deep-copied (keys and strings too): the source observation, its doc and
+//   any String its text or assets point at are gone by the time the batch is flushed
+// Put it in front of OutboxEmitter so a batch that cannot be published is queued as one item.
+class BatchingEmitter : public IObservationEmitter {
+public:
+  struct Config {
+    uint32_t window_ms = EVENT_BATCH_WINDOW_MS;
+    size_t   max_bytes = EVENT_BATCH_MAX_BYTES;
+  };
+
+  explicit BatchingEmitter(IObservationEmitter& inner, const Config& cfg = Config())
+  : inner_(inner), cfg_(cfg) { startBatch(); }
+
+  bool ready() const override { return inner_.ready(); }
+
+  bool emit(const ObservationBuilder& ob) override {
+    if (cfg_.window_ms == 0 || ob.delivery() == ObservationBuilder::Delivery::Urgent ||
+        !ob.doc["request_id"].isNull()) {
+      flush();              // keep ordering: pending events go out first
+      return inner_.emit(ob);
+    }
+    if (!add(ob)) {
+      // the batch doc ran out mid-copy: the pending batch is intact (the partial copy was
+      // rolled back), send it and start over; never ship an asset with fields missing
+      flush();
+      if (!add(ob)) {
+        MCP_LOGW("BATCH", "observation from %s exceeds an empty batch, sent alone", ob.doc["source"] | "?");
+        startBatch();
+        return inner_.emit(ob);
+      }
+    }
+    if (measureJson(batch_.doc) >= cfg_.max_bytes || batch_.doc.overflowed()) flush();
+    return true;
+  }
+
+  void poll(uint32_t now_ms) override {
+    if (count_ && (now_ms - opened_ms_) >= cfg_.window_ms) flush();
+    inner_.poll(now_ms);
+  }
+
+  bool flush() {
+    if (!count_) return true;
+    char txt[24]; snprintf(txt, sizeof(txt), "%u events", (unsigned)count_);
+    batch_.setText(String(txt));
+    bool ok = inner_.emit(batch_);
+    startBatch();
+    return ok;
+  }
+
+  size_t pending() const { return count_; }
+
+private:
+  void startBatch() {
+    batch_.reset();
+    batch_.doc["type"] = "device.observation_batch";
+    batch_.doc["ok"] = true;
+    count_ = 0;
+  }
+
+  // index among the first `before` assets, or -1
+  int findLatest(const char* source, const char* evType, size_t before) {
+    if (!source || !evType) return -1;
+    for (size_t i = 0; i < before; i++) {
+      JsonObject a = batch_.assets[i];
+      const char* s = a["source"] | "";
+      const char* e = a["event_type"] | "";
+      if (strcmp(s, source) == 0 && strcmp(e, evType) == 0) return (int)i;
+    }
+    return -1;
+  }
+
+  // All-or-nothing: the observation's assets are appended, and only once every copy fit are
+  // the Latest assets they supersede removed. false = doc exhausted, batch left as it was.
+  bool add(const ObservationBuilder& ob) {
+    const char* source = ob.doc["source"] | "";
+    const char* text = ob.doc["result"]["text"] | "";
+    const bool latest = ob.delivery() == ObservationBuilder::Delivery::Latest;
+    JsonArrayConst in = ob.doc["result"]["assets"];
+    const size_t before = batch_.assets.size();
+    for (JsonObjectConst src : in) {
+      JsonObject dst = batch_.addAsset();
+      if (!dst.isNull()) {
+        copyDeep(dst, src);
+        dst["source"] = String(source);
+        dst["ts_ms"] = millis();
+        if (text[0] && !src.containsKey("text")) dst["text"] = String(text);
+      }
+      if (dst.isNull() || batch_.doc.overflowed()) {
+        while (batch_.assets.size() > before) batch_.assets.remove(batch_.assets.size() - 1);
+        return false;
+      }
+    }
+    size_t added = batch_.assets.size() - before, superseded = 0;
+    if (latest) {
+      for (size_t i = before; i < batch_.assets.size(); ) {
+        const int old = findLatest(source, batch_.assets[i]["event_type"] | (const char*)nullptr, before - superseded);
+        if (old < 0) { i++; continue; }
+        batch_.assets.remove(old);   // everything after it shifts down by one
+        superseded++;
+      }
+    }
+    if (!count_ && added) opened_ms_ = millis();
+    count_ += added - superseded;
+    return true;
+  }
+
+  // JsonObject::set() keeps `const char*` keys and strings as pointers into the source;
+  // going through String forces the copy into the batch doc
+  static void copyDeep(JsonObject dst, JsonObjectConst src) {
+    for (JsonPairConst kv : src) {
+      const String key(kv.key().c_str());
+      JsonVariantConst v = kv.value();
+      if      (v.is<JsonObjectConst>()) copyDeep(dst.createNestedObject(key), v.as<JsonObjectConst>());
+      else if (v.is<JsonArrayConst>())  copyDeep(dst.createNestedArray(key), v.as<JsonArrayConst>());
+      else if (v.is<const char*>())     dst[key] = String(v.as<const char*>());
+      else                              dst[key] = v;
+    }
+  }
+  static void copyDeep(JsonArray dst, JsonArrayConst src) {
+    for (JsonVariantConst v : src) {
+      if      (v.is<JsonObjectConst>()) copyDeep(dst.createNestedObject(), v.as<JsonObjectConst>());
+      else if (v.is<JsonArrayConst>())  copyDeep(dst.createNestedArray(), v.as<JsonArrayConst>());
+      else if (v.is<const char*>())     dst.add(String(v.as<const char*>()));
+      else                              dst.add(v);
+    }
+  }
+
+  IObservationEmitter& inner_;
+  Config cfg_;
+  ObservationBuilder batch_;
+  size_t count_ = 0;
+  uint32_t opened_ms_ = 0;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include "tool.h"
 #include "obs_emitter.h"
+#include "mcp_log.h"
 
 // Minimal base for EVENT-only tools.
 // Provides: describe() with kind=event, subscribe/unsubscribe routing, emit helper, and optional tick().
@@ -39,44 +40,34 @@ public:
   }
 
   bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
-    Serial.printf("[EventTool] invoke called for '%s'\n", name());
-    Serial.print("[EventTool] args.size=");
-    Serial.println(args.size());
-    Serial.print("[EventTool] args content: ");
-    serializeJson(args, Serial);
-    Serial.println();
+    MCP_LOGD("EventTool", "invoke called for '%s', args.size=%u", name(), (unsigned)args.size());
     
     // Use containsKey() and getMember() for JsonObjectConst
     if (!args.containsKey("op")) {
-      Serial.println("[EventTool] ERROR: 'op' key not found!");
+      MCP_LOGW("EventTool", "'%s': 'op' key not found", name());
       out.error("bad_request", "op is required"); 
       return false;
     }
     
     const char* op = args["op"].as<const char*>();
     if (!op) {
-      Serial.println("[EventTool] ERROR: op is null after as<const char*>()!");
+      MCP_LOGW("EventTool", "'%s': op is not a string", name());
       out.error("bad_request", "op is required"); 
       return false;
     }
     
-    Serial.printf("[EventTool] op=%s\n", op);
+    MCP_LOGD("EventTool", "op=%s", op);
     
-    if (strcmp(op, "subscribe") == 0) {
-      Serial.println("[EventTool] Calling onSubscribe...");
-      return onSubscribe(args, out);
-    }
-    if (strcmp(op, "unsubscribe") == 0) {
-      Serial.println("[EventTool] Calling onUnsubscribe...");
-      return onUnsubscribe(args, out);
-    }
+    if (strcmp(op, "subscribe") == 0)   return onSubscribe(args, out);
+    if (strcmp(op, "unsubscribe") == 0) return onUnsubscribe(args, out);
     
-    Serial.printf("[EventTool] ERROR: unsupported op '%s'\n", op);
+    MCP_LOGW("EventTool", "'%s': unsupported op '%s'", name(), op);
     out.error("bad_op", "unsupported op"); 
     return false;
   }
 
-  // Optional periodic work (e.g., debounce/timers). Call from registry_tick_all().
+  // Optional periodic work (e.g., debounce/timers), run by TickScheduler. Override
+  // nextTickMs() too: the ITool default is TICK_IDLE, so tick() alone never runs.
   virtual void tick(uint32_t /*now_ms*/) {}
 
 protected:
@@ -87,8 +78,10 @@ protected:
   virtual void buildExtraParameters(JsonObject& /*props*/) {}
   virtual void buildSignals(JsonObject& /*signals*/) {}
 
-  // Emit helper
-  void emitNow(const ObservationBuilder& ob){
+  // Emit helper (resolves any relative asset URLs first, tags the source tool)
+  void emitNow(ObservationBuilder& ob){
+    ob.resolveUrls();
+    if (ob.doc["source"].isNull()) ob.doc["source"] = name();
     if (auto* e = get_global_emitter()) e->emit(ob);
   }
 
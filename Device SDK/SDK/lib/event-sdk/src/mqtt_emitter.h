@@ -1,44 +1,32 @@
 #pragma once
 #include <ArduinoJson.h>
-#include <PubSubClient.h>
 #include "obs_emitter.h"
-#include "transports/topics.h"   // topicEvents(device_id) helper
+#include "mqtt_publish.h"
+#include "transports/topics.h"   // DeviceTopics
 
 // Emits ObservationBuilder payloads to MQTT /events topic.
+// Asset URLs are already absolute (ObservationBuilder::setAssetUrl / resolveUrls), so the
+// doc is serialized exactly once, directly into the publish. Topics are built once
+// (DeviceTopics) and must outlive the emitter.
 class MqttObservationEmitter : public IObservationEmitter {
 public:
-  MqttObservationEmitter(PubSubClient& mqtt, const String& device_id, const String& http_base)
-  : mqtt_(mqtt), device_id_(device_id), http_base_(http_base) {}
+  MqttObservationEmitter(MqttTransport& mqtt, const DeviceTopics& topics, const String& http_base)
+  : mqtt_(mqtt), topics_(topics) { set_http_base(http_base); }
 
-  void set_http_base(const String& http_base){ http_base_ = http_base; }
-  void set_device_id(const String& did){ device_id_ = did; }
+  void set_http_base(const String& http_base){ ObservationBuilder::setHttpBase(http_base); }
+  // MsgPack once the bridge commands us on cmd.mp; events then go to events.mp
+  void set_format(WireFormat f){ format_ = f; }
+  WireFormat format() const { return format_; }
 
-  void emit(const ObservationBuilder& ob) override {
-    String eventsJson = ob.toJson();
-    patchAssetUrls(eventsJson);
-    mqtt_.publish(topicEvents(device_id_).c_str(), eventsJson.c_str());
-  }
+  bool ready() const override { return mqtt_.connected(); }
 
-private:
-  void patchAssetUrls(String& eventsJson){
-    StaticJsonDocument<2048> tmp;
-    auto err = deserializeJson(tmp, eventsJson);
-    if (err == DeserializationError::Ok) {
-      JsonArray assets = tmp["result"]["assets"];
-      if (!assets.isNull()) {
-        for (JsonObject a : assets) {
-          const char* url = a["url"] | nullptr;
-          if (url && url[0] == '/') {
-            a["url"] = http_base_ + String(url);
-          }
-        }
-        String patched; serializeJson(tmp, patched);
-        eventsJson = patched;
-      }
-    }
+  bool emit(const ObservationBuilder& ob) override {
+    const String& topic = format_ == WireFormat::MsgPack ? topics_.eventsMp : topics_.events;
+    return publishDoc(mqtt_, topic.c_str(), ob.doc, format_);
   }
 
-  PubSubClient& mqtt_;
-  String device_id_;
-  String http_base_;
+private:
+  MqttTransport& mqtt_;
+  const DeviceTopics& topics_;
+  WireFormat format_ = WireFormat::Json;
 };
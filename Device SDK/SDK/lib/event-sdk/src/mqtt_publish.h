@@ -0,0 +1,26 @@
+#pragma once
+#include <ArduinoJson.h>
+#include "mqtt_transport.h"
+#include "metrics.h"
+
+// Wire encoding of cmd/events payloads (negotiated per device, see announce "encodings")
+enum class WireFormat : uint8_t { Json, MsgPack };
+
+// Serialize a document straight into the transport's publish buffer (reserve/publishReserved):
+// one pass, no intermediate String, and no ceiling on the payload size.
+inline bool publishDoc(MqttTransport& mqtt, const char* topic, const JsonDocument& doc,
+                       WireFormat fmt, bool retained=false, uint8_t qos=MQTT_EVENTS_QOS){
+  if (!mqtt.connected()) return false;
+  const size_t len = fmt == WireFormat::MsgPack ? measureMsgPack(doc) : measureJson(doc);
+  uint8_t* buf = mqtt.reserve(len);
+  if (!buf) return false;
+  if (fmt == WireFormat::MsgPack) serializeMsgPack(doc, buf, len + 1);
+  else                            serializeJson(doc, (char*)buf, len + 1);   // + NUL
+  const bool ok = mqtt.publishReserved(topic, len, qos, retained);
+  if (ok) METRIC_COUNT("mcp_mqtt_publish_bytes_total", "doc", len);
+  return ok;
+}
+
+inline bool publishJson(MqttTransport& mqtt, const char* topic, const JsonDocument& doc, bool retained=false){
+  return publishDoc(mqtt, topic, doc, WireFormat::Json, retained);
+}
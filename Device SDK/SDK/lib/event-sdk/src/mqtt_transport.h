@@ -0,0 +1,96 @@
+#pragma once
+#include <Arduino.h>
+#include <functional>
+#include <string.h>
+
+#ifndef MQTT_KEEPALIVE_S
+#define MQTT_KEEPALIVE_S 60
+#endif
+#ifndef MQTT_BACKOFF_MIN_MS
+#define MQTT_BACKOFF_MIN_MS 1000     // first retry after a failed or lost connection
+#endif
+#ifndef MQTT_BACKOFF_MAX_MS
+#define MQTT_BACKOFF_MAX_MS 60000    // the doubling delay stops here
+#endif
+#ifndef MQTT_TOPIC_MAX
+#define MQTT_TOPIC_MAX 128           // incl. NUL, longest topic a publish or received message may use
+#endif
+#ifndef MQTT_EVENTS_QOS
+#define MQTT_EVENTS_QOS 1            // replies/events/status (clients that only publish QoS0 ignore it)
+#endif
+
+// Reconnect delay: MIN, 2*MIN, 4*MIN ... MAX, each -25%..+25% so a fleet that lost the
+// same broker does not come back in lockstep. reset() after a successful connect.
+class MqttBackoff {
+ public:
+  uint32_t next(){
+    _delay = !_delay ? MQTT_BACKOFF_MIN_MS : _delay >= MQTT_BACKOFF_MAX_MS / 2 ? MQTT_BACKOFF_MAX_MS : _delay * 2;
+    return _delay - _delay / 4 + (uint32_t)random(_delay / 2 + 1);
+  }
+  void reset(){ _delay = 0; }
+  uint32_t current() const { return _delay; }
+ private:
+  uint32_t _delay = 0;
+};
+
+// Broker connection as seen by main.cpp and the emitters (MqttObservationEmitter, publishDoc,
+// pushMqttAssets). Every call comes from the network task; an implementation keeps the
+// blocking parts (DNS, TCP connect, socket writes) somewhere else.
+// - subscribe() before begin(): the topics are (re)subscribed after every connect
+// - begin() only stores the parameters; connecting and reconnecting (with MqttBackoff) run
+//   in the background, retryNow() skips the remaining delay (e.g. Wi-Fi is back)
+// - loop() delivers received messages and the connect callback on the caller's task
+// - publishing: reserve(len) hands out a buffer of at least len+1 bytes, publishReserved()
+//   queues its first len bytes. Buffers grow with the payload: no fixed size ceiling for
+//   publishes (received messages are bounded by the implementation, e.g. MQTT_RX_BYTES)
+class MqttTransport {
+ public:
+  struct Config {
+    const char* host = nullptr;
+    uint16_t port = 1883;
+    const char* client_id = nullptr;    // keep stable: the broker files the session under it
+    const char* will_topic = nullptr;
+    const char* will_payload = nullptr;
+    bool will_retain = true;
+    uint16_t keepalive_s = MQTT_KEEPALIVE_S;
+    bool clean_session = false;         // persistent: QoS1 commands sent while we are away are kept
+  };
+  struct Stats {
+    uint32_t connects = 0, failures = 0, disconnects = 0;
+    uint32_t tx_dropped = 0, tx_failed = 0, rx_dropped = 0;   // no slot/memory, write failed, rx ring full
+    uint32_t backoff_ms = 0;            // current reconnect delay (0 = connected or never failed)
+  };
+  using MessageHandler = std::function<void(const char* topic, const uint8_t* payload, size_t len)>;
+  using ConnectHandler = std::function<void()>;
+
+  virtual ~MqttTransport() {}
+
+  virtual bool subscribe(const char* topic, uint8_t qos) = 0;
+  virtual bool begin(const Config& cfg) = 0;
+  virtual void loop(uint32_t now_ms) = 0;
+  virtual bool connected() const = 0;
+  virtual void retryNow() = 0;
+  virtual void disconnect() = 0;      // flushes what is queued, then stays offline
+
+  virtual uint8_t* reserve(size_t len) = 0;   // nullptr: no room right now
+  virtual bool publishReserved(const char* topic, size_t len, uint8_t qos, bool retain) = 0;
+
+  bool publish(const char* topic, const uint8_t* data, size_t len, uint8_t qos = MQTT_EVENTS_QOS, bool retain = false){
+    uint8_t* buf = reserve(len);
+    if (!buf) return false;
+    if (len) memcpy(buf, data, len);
+    return publishReserved(topic, len, qos, retain);
+  }
+  bool publish(const char* topic, const char* text, bool retain = false){
+    return publish(topic, (const uint8_t*)text, strlen(text), MQTT_EVENTS_QOS, retain);
+  }
+
+  void onMessage(MessageHandler h){ _onMessage = h; }
+  void onConnect(ConnectHandler h){ _onConnect = h; }
+  const Stats& stats() const { return _stats; }
+
+ protected:
+  MessageHandler _onMessage;
+  ConnectHandler _onConnect;
+  Stats _stats;
+};
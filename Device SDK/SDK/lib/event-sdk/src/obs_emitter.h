@@ -4,7 +4,12 @@
 // Common emitter interface for pushing observations to the outside world (/events).
 struct IObservationEmitter {
   virtual ~IObservationEmitter() {}
-  virtual void emit(const ObservationBuilder& ob) = 0;
+  // true once the observation was handed to the transport (or accepted by a queue/batch)
+  virtual bool emit(const ObservationBuilder& ob) = 0;
+  // whether emit() can reach the outside world right now (transport connected)
+  virtual bool ready() const { return true; }
+  // optional periodic work (flush windows, retries); called from loop()
+  virtual void poll(uint32_t /*now_ms*/) {}
 };
 
 // Global emitter registration
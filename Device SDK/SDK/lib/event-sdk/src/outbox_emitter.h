@@ -0,0 +1,141 @@
+#pragma once
+#include <ArduinoJson.h>
+#include "obs_emitter.h"
+
+#ifndef OUTBOX_SLOTS
+#define OUTBOX_SLOTS 16            // observations held while the transport is down
+#endif
+#ifndef OUTBOX_SLOT_BYTES
+#define OUTBOX_SLOT_BYTES 768      // MsgPack-encoded size limit per observation
+#endif
+#ifndef OUTBOX_SOURCE_QUOTA
+#define OUTBOX_SOURCE_QUOTA 6      // max queued per tool (source); 0 = no quota
+#endif
+#ifndef OUTBOX_DRAIN_PER_POLL
+#define OUTBOX_DRAIN_PER_POLL 4    // replayed per drain step after reconnect
+#endif
+#ifndef OUTBOX_DRAIN_INTERVAL_MS
+#define OUTBOX_DRAIN_INTERVAL_MS 50
+#endif
+
+// Store-and-forward layer in front of the transport emitter (usually MqttObservationEmitter).
+// - emit(): passes straight through while the transport is up and nothing is pending;
+//   otherwise (disconnected, or the publish failed) the observation is MsgPack-encoded
+//   into a fixed slot, so strings are owned and no allocation happens per event
+// - poll(): once the inner emitter is ready again, replays in order at a bounded rate
+// - drop policy: per-source quota first (that tool's oldest goes), then oldest overall;
+//   observations larger than a slot are dropped and counted
+// Slot storage is one block, taken from PSRAM when available.
+class OutboxEmitter : public IObservationEmitter {
+public:
+  struct Config {
+    uint8_t  source_quota     = OUTBOX_SOURCE_QUOTA;
+    uint8_t  drain_per_poll   = OUTBOX_DRAIN_PER_POLL;
+    uint32_t drain_interval_ms= OUTBOX_DRAIN_INTERVAL_MS;
+  };
+
+  struct Stats {
+    uint32_t queued = 0;          // currently waiting
+    uint32_t enqueued = 0;        // total ever queued
+    uint32_t replayed = 0;        // delivered from the queue
+    uint32_t dropped_oldest = 0;  // evicted because the queue was full
+    uint32_t dropped_quota = 0;   // evicted by the per-source quota
+    uint32_t dropped_oversize = 0;// did not fit a slot (or storage missing)
+    uint32_t dropped() const { return dropped_oldest + dropped_quota + dropped_oversize; }
+  };
+
+  explicit OutboxEmitter(IObservationEmitter& inner, const Config& cfg = Config())
+  : inner_(inner), cfg_(cfg) {}
+
+  ~OutboxEmitter(){ free(store_); }
+
+  bool ready() const override { return inner_.ready(); }
+
+  bool emit(const ObservationBuilder& ob) override {
+    if (!count_ && inner_.ready() && inner_.emit(ob)) return true;
+    return enqueue(ob);
+  }
+
+  void poll(uint32_t now_ms) override {
+    inner_.poll(now_ms);
+    if (!count_ || !inner_.ready()) return;
+    if ((now_ms - lastDrain_) < cfg_.drain_interval_ms) return;
+    lastDrain_ = now_ms;
+    for (uint8_t n = 0; n < cfg_.drain_per_poll && count_; n++) {
+      Slot& s = slots_[order_[0]];
+      replay_.reset();
+      // const input: decoded by copy, so a replay that fails leaves the slot intact for the next poll
+      if (deserializeMsgPack(replay_.doc, (const uint8_t*)slotData(order_[0]), s.len) == DeserializationError::Ok &&
+          !inner_.emit(replay_)) return;   // transport went away again; keep it queued
+      removeAt(0);
+      stats_.replayed++;
+    }
+  }
+
+  const Stats& stats() const { return stats_; }
+  size_t pending() const { return count_; }
+
+private:
+  struct Slot { uint16_t len = 0; uint32_t src = 0; };
+
+  // FNV-1a of the tool name, enough to tell sources apart for the quota
+  static uint32_t hashSource(const char* s){
+    uint32_t h = 2166136261u;
+    while (s && *s) { h ^= (uint8_t)*s++; h *= 16777619u; }
+    return h;
+  }
+
+  bool allocate(){
+    if (store_) return true;
+    const size_t bytes = (size_t)OUTBOX_SLOTS * OUTBOX_SLOT_BYTES;
+#if defined(ESP32)
+    if (psramFound()) store_ = (uint8_t*)ps_malloc(bytes);
+#endif
+    if (!store_) store_ = (uint8_t*)malloc(bytes);
+    return store_ != nullptr;
+  }
+
+  uint8_t* slotData(uint8_t i){ return store_ + (size_t)i * OUTBOX_SLOT_BYTES; }
+
+  void removeAt(uint8_t pos){
+    for (uint8_t i = pos; i + 1 < count_; i++) order_[i] = order_[i + 1];
+    count_--;
+    stats_.queued = count_;
+  }
+
+  bool enqueue(const ObservationBuilder& ob){
+    if (!allocate() || measureMsgPack(ob.doc) > OUTBOX_SLOT_BYTES) { stats_.dropped_oversize++; return false; }
+    const uint32_t src = hashSource(ob.doc["source"] | "");
+
+    if (cfg_.source_quota) {
+      uint8_t same = 0, oldest = 0xFF;
+      for (uint8_t i = 0; i < count_; i++)
+        if (slots_[order_[i]].src == src) { if (oldest == 0xFF) oldest = i; same++; }
+      if (same >= cfg_.source_quota) { removeAt(oldest); stats_.dropped_quota++; }
+    }
+    if (count_ == OUTBOX_SLOTS) { removeAt(0); stats_.dropped_oldest++; }
+
+    // free slot = one not referenced by order_
+    bool used[OUTBOX_SLOTS] = {};
+    for (uint8_t i = 0; i < count_; i++) used[order_[i]] = true;
+    uint8_t idx = 0;
+    while (used[idx]) idx++;
+
+    slots_[idx].len = (uint16_t)serializeMsgPack(ob.doc, slotData(idx), OUTBOX_SLOT_BYTES);
+    slots_[idx].src = src;
+    order_[count_++] = idx;
+    stats_.queued = count_;
+    stats_.enqueued++;
+    return true;
+  }
+
+  IObservationEmitter& inner_;
+  Config cfg_;
+  uint8_t* store_ = nullptr;
+  Slot slots_[OUTBOX_SLOTS];
+  uint8_t order_[OUTBOX_SLOTS] = {};   // slot indices, oldest first
+  uint8_t count_ = 0;
+  uint32_t lastDrain_ = 0;
+  ObservationBuilder replay_;           // decode target for replays
+  Stats stats_;
+};
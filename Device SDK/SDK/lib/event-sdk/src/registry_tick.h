@@ -2,6 +2,7 @@
 #include "registry.h"
 #include "event_tool.h"
 
+// Legacy: ticks every tool on every call. Prefer TickScheduler (tick_scheduler.h).
 inline void registry_tick_all(ToolRegistry& reg, uint32_t now_ms){
   for (auto* t : reg.list()){
     t->tick(now_ms);
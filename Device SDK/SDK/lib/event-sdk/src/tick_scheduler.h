@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include "registry.h"
+
+#ifndef LOOP_IDLE_MAX_MS
+#define LOOP_IDLE_MAX_MS 10   // longest loop() sleep while waiting for the next deadline
+#endif
+
+// Deadline-driven replacement for registry_tick_all().
+// Each tool reports nextTickMs(); a min-heap keyed on that deadline means only due tools
+// are ticked, and idleMs() tells loop() how long it may sleep.
+// - tools keeping the ITool default (TICK_IDLE) are never ticked; one returning now_ms is
+//   ticked on every run(), like registry_tick_all()
+// - after anything that may change a tool's schedule (command dispatch, finished job),
+//   call invalidate(): the heap is rebuilt from nextTickMs() on the next run()
+class TickScheduler {
+public:
+  explicit TickScheduler(ToolRegistry& reg) : reg_(reg) {}
+
+  void invalidate(){ dirty_ = true; }
+
+  void run(uint32_t now_ms){
+    if (dirty_) rebuild(now_ms);
+    while (!heap_.empty() && due(heap_.front().at, now_ms)) {
+      std::pop_heap(heap_.begin(), heap_.end(), Later());
+      ITool* t = heap_.back().tool;
+      heap_.pop_back();
+      t->tick(now_ms);
+      push(t, now_ms);
+    }
+  }
+
+  // ms until the earliest deadline, capped at max_ms (0 = something is due now)
+  uint32_t idleMs(uint32_t now_ms, uint32_t max_ms = LOOP_IDLE_MAX_MS) const {
+    if (dirty_) return 0;
+    if (heap_.empty()) return max_ms;
+    int32_t d = (int32_t)(heap_.front().at - now_ms);
+    if (d <= 0) return 0;
+    return (uint32_t)d < max_ms ? (uint32_t)d : max_ms;
+  }
+
+private:
+  struct Entry { uint32_t at; ITool* tool; };
+  // wrap-safe "a is later than b" => std heap keeps the earliest deadline at front()
+  struct Later { bool operator()(const Entry& a, const Entry& b) const { return (int32_t)(a.at - b.at) > 0; } };
+
+  static bool due(uint32_t at, uint32_t now_ms){ return (int32_t)(now_ms - at) >= 0; }
+
+  void push(ITool* t, uint32_t now_ms){
+    uint32_t at = t->nextTickMs(now_ms);
+    if (at == TICK_IDLE) return;
+    // a tool that stays due (default / legacy polling) runs again on the next pass, not in this one
+    if (due(at, now_ms)) at = now_ms + 1;
+    if (at == TICK_IDLE) at = 0;   // millis() wrap: step over the sentinel
+    heap_.push_back({at, t});
+    std::push_heap(heap_.begin(), heap_.end(), Later());
+  }
+
+  void rebuild(uint32_t now_ms){
+    heap_.clear();
+    for (auto* t : reg_.list()) {
+      uint32_t at = t->nextTickMs(now_ms);
+      if (at != TICK_IDLE) heap_.push_back({at, t});
+    }
+    std::make_heap(heap_.begin(), heap_.end(), Later());
+    dirty_ = false;
+  }
+
+  ToolRegistry& reg_;
+  std::vector<Entry> heap_;
+  bool dirty_ = true;
+};
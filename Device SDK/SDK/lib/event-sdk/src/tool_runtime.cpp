@@ -0,0 +1,183 @@
+#include "tool_runtime.h"
+#include <string.h>
+#include "metrics.h"
+#include "mcp_log.h"
+#include "trace.h"
+
+static uint8_t* spillAlloc(size_t n){
+#if defined(ESP32)
+  if (psramFound()) if (void* p = ps_malloc(n)) return (uint8_t*)p;
+#endif
+  return (uint8_t*)malloc(n);
+}
+
+bool ToolRuntime::begin(){
+#if defined(ESP32) && !CONFIG_FREERTOS_UNICORE
+  if (_task) return true;
+  _threaded = xTaskCreatePinnedToCore(&_taskLoop, "ToolTask", RUNTIME_TOOL_STACK, this, 1,
+                                      &_task, RUNTIME_TOOL_CORE) == pdPASS;
+#endif
+  if (_threaded) Serial.printf("[RUNTIME] tool task on core %d\n", RUNTIME_TOOL_CORE);
+  else           Serial.println("[RUNTIME] cooperative (single core)");
+  return _threaded;
+}
+
+// ---- network side ----
+bool ToolRuntime::submitCommand(const uint8_t* payload, size_t len, WireFormat fmt){
+  Cmd* c = len <= RUNTIME_CMD_BYTES ? _cmds.beginPush() : nullptr;
+  if (!c) {
+    _stats.cmd_dropped++;
+    MCP_TRACE_EVT(CmdDrop, nullptr, nullptr, len);
+    MCP_LOGW("RUNTIME", "command dropped (%u bytes, queue %u/%u)",
+             (unsigned)len, (unsigned)_cmds.size(), (unsigned)_cmds.capacity());
+    return false;
+  }
+  memcpy(c->data, payload, len);
+  c->len = (uint16_t)len;
+  c->fmt = fmt;
+  _cmds.commitPush();
+#if defined(ESP32)
+  if (_task) xTaskNotifyGive(_task);
+#endif
+  return true;
+}
+
+void ToolRuntime::deliver(const Obs& o, ObservationBuilder& ob, const Sink& sink){
+  ob.reset();
+  // const input: strings are copied into ob, so sinks that keep them (BatchingEmitter)
+  // never point into a slot that is recycled right after pop()
+  const uint8_t* bytes = o.spill ? o.spill : o.data;
+  const DeserializationError err = deserializeMsgPack(ob.doc, bytes, o.len);
+  if (err) { MCP_LOGW("RUNTIME", "observation decode failed: %s", err.c_str()); return; }
+  ob.setDelivery(o.delivery);
+  if (sink) sink(o.kind, o.fmt, ob);
+}
+
+void ToolRuntime::drain(const Sink& sink){
+  while (Obs* o = _obs.front()) {
+    if (o->spill) {
+      // rare: a doc of its own (heap when no pooled one is big enough)
+      ObservationBuilder big((size_t)o->len * 2 + 512);
+      deliver(*o, big, sink);
+      free(o->spill);
+      o->spill = nullptr;
+    } else {
+      deliver(*o, _out, sink);
+    }
+    _obs.pop();
+  }
+}
+
+// ---- tool side ----
+bool ToolRuntime::push(Kind k, WireFormat fmt, const ObservationBuilder& ob){
+  const size_t len = measureMsgPack(ob.doc);
+  uint8_t* spill = nullptr;
+  if (len > RUNTIME_OBS_BYTES) {
+    spill = len <= RUNTIME_OBS_SPILL_BYTES ? spillAlloc(len) : nullptr;
+    if (!spill) return pushTooLarge(k, fmt, ob, len);
+  }
+  Obs* o = _obs.beginPush();
+#if defined(ESP32)
+  // network task drains every pass; give it a moment before dropping
+  for (uint32_t w = millis(); !o && _threaded && millis() - w < RUNTIME_PUSH_WAIT_MS; o = _obs.beginPush())
+    vTaskDelay(1);
+#endif
+  if (!o) {
+    free(spill);
+    _stats.obs_dropped++;
+    MCP_TRACE_EVT(ObsDrop, ob.doc["request_id"] | "", "full", 0);
+    return false;
+  }
+  o->spill = spill;
+  o->len = (uint16_t)(spill ? serializeMsgPack(ob.doc, spill, len) : serializeMsgPack(ob.doc, o->data, RUNTIME_OBS_BYTES));
+  o->kind = k;
+  o->fmt = fmt;
+  o->delivery = ob.delivery();
+  _obs.commitPush();
+  return true;
+}
+
+// Replies the queue cannot carry still answer their request_id; events are only counted
+bool ToolRuntime::pushTooLarge(Kind k, WireFormat fmt, const ObservationBuilder& ob, size_t len){
+  const char* rid = ob.doc["request_id"] | "";
+  _stats.obs_dropped++;
+  MCP_TRACE_EVT(ObsDrop, rid, "too_large", len);
+  MCP_LOGW("RUNTIME", "observation %s too large (%u bytes)", rid, (unsigned)len);
+  if (k != Kind::Reply || !rid[0]) return false;
+  ObservationBuilder err(DOC_POOL_SMALL_BYTES);
+  err.setRequestId(rid);          // ob (and so rid) outlives this push
+  err.error("too_large", "reply exceeds RUNTIME_OBS_SPILL_BYTES or no memory for it");
+  return push(k, fmt, err);
+}
+
+void ToolRuntime::handle(const Cmd& c){
+  // a batch (up to RUNTIME_CMD_BYTES) does not parse into the small class
+  DocLease lease(c.len > EXEC_ARGS_DOC_SIZE / 2 ? DOC_POOL_LARGE_BYTES : EXEC_ARGS_DOC_SIZE);
+  JsonDocument& cmd = lease.doc();
+  DeserializationError err = c.fmt == WireFormat::MsgPack ? deserializeMsgPack(cmd, c.data, c.len)
+                                                          : deserializeJson(cmd, c.data, c.len);
+  if (err) {
+    _stats.parse_errors++;
+    MCP_TRACE_EVT(ParseError, nullptr, nullptr, c.len);
+    MCP_LOGW("RUNTIME", "%s parse error: %s", c.fmt == WireFormat::MsgPack ? "MsgPack" : "JSON", err.c_str());
+    return;
+  }
+  MCP_TRACE_EVT(Parsed, cmd["request_id"] | "", nullptr, c.len);
+  MCP_LOGD("RUNTIME", "Type=%s, Tool=%s", cmd["type"] | "unknown", cmd["tool"] | "unknown");
+
+  if (_rules && strcmp(cmd["type"] | "", "device.rules") == 0) {
+    ObservationBuilder reply;
+    _rules->load(cmd, reply);
+    push(Kind::Reply, c.fmt, reply);
+    return;
+  }
+
+  // Dispatch to tool registry (asset URLs come back already resolved); pooled reply sized per tool
+  ObservationBuilder reply(_reg.replyBytes(cmd));
+  bool dispatched = _reg.dispatch(cmd, reply);
+  _sched.invalidate();   // subscribe/unsubscribe etc. may move a tool's deadline
+  if (!dispatched) MCP_LOGD("RUNTIME", "Dispatch failed (tool not found or error)");
+
+  // Queued job without ack requested: result follows via executor.pump()
+  if (reply.suppressed()) return;
+  push(Kind::Reply, c.fmt, reply);   // serialized while cmd (request_id) is still alive
+}
+
+void ToolRuntime::step(uint32_t now_ms){
+  while (Cmd* c = _cmds.front()) { handle(*c); _cmds.pop(); }
+
+  // Observations of finished long-running jobs
+  _exec.pump([this](const ObservationBuilder& ob){
+    _reg.complete(ob);   // retries of this request_id are now answered from the cache
+    push(Kind::Event, WireFormat::Json, ob);
+    _sched.invalidate();
+  });
+
+  // Tick tools whose deadline has passed (especially EVENT tools)
+  _sched.run(now_ms);
+
+  // Rule actions triggered by those ticks' emissions; results go upstream as events
+  if (_rules) _rules->run(now_ms, [this](const ObservationBuilder& ob){
+    push(Kind::Event, WireFormat::Json, ob);
+    _sched.invalidate();
+  });
+}
+
+uint32_t ToolRuntime::idleMs(uint32_t now_ms) const {
+  if (!_cmds.empty() || (_rules && _rules->pending())) return 0;
+  return _sched.idleMs(now_ms);
+}
+
+#if defined(ESP32)
+void ToolRuntime::_taskLoop(void* pv){
+  ToolRuntime* self = static_cast<ToolRuntime*>(pv);
+  for (;;) {
+    uint32_t t0 = micros();
+    self->step(millis());
+    METRIC_OBSERVE("mcp_loop_us", "tool", micros() - t0);
+    // sleep until the next tick deadline; submitCommand() wakes us early
+    TickType_t idle = pdMS_TO_TICKS(self->idleMs(millis()));
+    ulTaskNotifyTake(pdTRUE, idle ? idle : 1);
+  }
+}
+#endif
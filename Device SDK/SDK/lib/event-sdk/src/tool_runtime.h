@@ -0,0 +1,122 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include "registry.h"
+#include "executor.h"
+#include "spsc_queue.h"
+#include "obs_emitter.h"
+#include "mqtt_publish.h"     // WireFormat
+#include "tick_scheduler.h"
+#include "rule_engine.h"
+
+#if defined(ESP32)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+#endif
+
+#ifndef RUNTIME_TOOL_CORE
+#define RUNTIME_TOOL_CORE 1       // tool task; the network task takes the other core
+#endif
+#ifndef RUNTIME_TOOL_STACK
+#define RUNTIME_TOOL_STACK 12288
+#endif
+#ifndef RUNTIME_CMD_SLOTS
+#define RUNTIME_CMD_SLOTS 4       // power of two
+#endif
+#ifndef RUNTIME_CMD_BYTES
+#define RUNTIME_CMD_BYTES 2048    // raw cmd payload (JSON or MsgPack) per slot: the largest command accepted
+#endif
+#ifndef RUNTIME_OBS_SLOTS
+#define RUNTIME_OBS_SLOTS 8       // power of two
+#endif
+#ifndef RUNTIME_OBS_BYTES
+#define RUNTIME_OBS_BYTES 1024    // MsgPack-encoded observation per slot
+#endif
+#ifndef RUNTIME_OBS_SPILL_BYTES
+#define RUNTIME_OBS_SPILL_BYTES 16384   // larger ones go to a heap buffer up to this; beyond: too_large reply
+#endif
+#ifndef RUNTIME_PUSH_WAIT_MS
+#define RUNTIME_PUSH_WAIT_MS 50   // tool task waits this long for a free observation slot
+#endif
+
+// Splits the firmware into a network side and a tool side joined by two SPSC queues:
+//   network (MQTT callback) --submitCommand()--> [cmd queue] --> tool task: parse, dispatch,
+//   executor.pump(), TickScheduler --reply/events--> [obs queue] --drain()--> network: publish
+// Threading contract: ToolRegistry, the tools (invoke/tick/EventTool state) and the global
+// emitter seen by tools are only ever used from the tool task; the MqttTransport only from
+// the network task. Observations cross as MsgPack, so no pointer into tool memory escapes.
+// begin() starts the tool task pinned to RUNTIME_TOOL_CORE on dual-core chips; on single-core
+// builds (ESP32-C3) it stays cooperative and the caller runs step() from loop().
+// Observations over RUNTIME_OBS_BYTES (batch replies, big tool results) travel in a heap
+// buffer (PSRAM when present) the network side frees; a reply that cannot be carried at all is
+// answered with error "too_large" under its request_id, so the requester never just times out.
+// Optional RuleEngine (setRules): sees every tool emission, gets device.rules messages, and
+// its actions run in step() right after the tick that triggered them.
+class ToolRuntime {
+ public:
+  enum class Kind : uint8_t { Reply, Event };
+  using Sink = std::function<void(Kind, WireFormat, const ObservationBuilder&)>;
+
+  struct Stats { uint32_t cmd_dropped = 0, obs_dropped = 0, parse_errors = 0; };
+
+  ToolRuntime(ToolRegistry& reg, ToolExecutor& exec) : _reg(reg), _exec(exec), _sched(reg), _emitter(*this) {}
+
+  bool begin();                 // true = threaded
+  void setRules(RuleEngine* r){ _rules = r; }   // before begin()
+  bool threaded() const { return _threaded; }
+#if defined(ESP32)
+  TaskHandle_t task() const { return _task; }
+#endif
+
+  // --- network side ---
+  bool submitCommand(const uint8_t* payload, size_t len, WireFormat fmt);
+  void drain(const Sink& sink); // replies and events produced by the tool side
+
+  // --- tool side ---
+  void step(uint32_t now_ms);   // one pass: commands, finished jobs, due ticks
+  uint32_t idleMs(uint32_t now_ms) const;
+  IObservationEmitter& toolEmitter(){ return _emitter; }   // becomes the global emitter
+
+  const Stats& stats() const { return _stats; }
+  size_t pendingCmds() const { return _cmds.size(); }
+  size_t pendingObs() const { return _obs.size(); }
+
+ private:
+  struct Cmd { uint16_t len; WireFormat fmt; uint8_t data[RUNTIME_CMD_BYTES]; };
+  struct Obs {
+    uint16_t len; Kind kind; WireFormat fmt; ObservationBuilder::Delivery delivery;
+    uint8_t* spill;                 // set: the bytes are there (owned, freed by drain), not in data
+    uint8_t data[RUNTIME_OBS_BYTES];
+  };
+
+  // Tools emit through this: the observation is queued for the network task
+  struct QueueEmitter : IObservationEmitter {
+    explicit QueueEmitter(ToolRuntime& rt) : rt(rt) {}
+    bool emit(const ObservationBuilder& ob) override {
+      if (rt._rules) rt._rules->observe(ob, millis());   // local reflexes before the upstream copy
+      return rt.push(Kind::Event, WireFormat::Json, ob);
+    }
+    ToolRuntime& rt;
+  };
+
+  bool push(Kind k, WireFormat fmt, const ObservationBuilder& ob);
+  bool pushTooLarge(Kind k, WireFormat fmt, const ObservationBuilder& ob, size_t len);
+  void deliver(const Obs& o, ObservationBuilder& ob, const Sink& sink);
+  void handle(const Cmd& c);
+
+  ToolRegistry& _reg;
+  ToolExecutor& _exec;
+  TickScheduler _sched;
+  RuleEngine* _rules = nullptr;
+  QueueEmitter _emitter;
+  SpscQueue<Cmd, RUNTIME_CMD_SLOTS> _cmds;
+  SpscQueue<Obs, RUNTIME_OBS_SLOTS> _obs;
+  ObservationBuilder _out;      // network side decode target
+  bool _threaded = false;
+  Stats _stats;
+#if defined(ESP32)
+  TaskHandle_t _task = nullptr;
+  static void _taskLoop(void* pv);
+#endif
+};
@@ -0,0 +1,154 @@
+#include "led_bus.h"
+#include <string.h>
+
+LedBus& LedBus::instance(){
+  static LedBus inst;
+  return inst;
+}
+
+#if defined(ESP32)
+void LedBus::_lock()   { portENTER_CRITICAL(&_mux); }
+void LedBus::_unlock() { portEXIT_CRITICAL(&_mux); }
+void LedBus::wake()    { if (_task) xTaskNotifyGive(_task); else renderOnce(); }
+#else
+void LedBus::_lock()   {}
+void LedBus::_unlock() {}
+void LedBus::wake()    { renderOnce(); }
+#endif
+
+bool LedBus::begin(){
+  if (_inited) return true;
+  memset(_front, 0, sizeof(_front));
+  memset(_back, 0, sizeof(_back));
+  FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(_front, NUM_LEDS);
+  FastLED.setBrightness(255);   // per-layer brightness is applied while compositing
+  FastLED.show();
+  _inited = true;
+#if defined(ESP32)
+  xTaskCreatePinnedToCore(&_taskLoop, "LedBusTask", 3072, this, 1, &_task, LED_BUS_CORE);
+#endif
+  return true;
+}
+
+LedBus::Layer* LedBus::slotFor(const char* id){
+  Layer* free = nullptr;
+  for (auto& l : _layers) {
+    if (l.id && strcmp(l.id, id) == 0) return &l;
+    if (!l.id && !free) free = &l;
+  }
+  return free;
+}
+
+bool LedBus::submit(const Layer& in){
+  if (!_inited) begin();
+  _lock();
+  Layer* l = slotFor(in.id);
+  if (l) {
+    // field-wise: the pixel block is only used by pixels(), which writes it in place
+    l->id = in.id; l->z = in.z; l->bright = in.bright; l->alpha = in.alpha;
+    l->anim = in.anim; l->a = in.a; l->b = in.b; l->durMs = in.durMs; l->start = in.start;
+  }
+  _unlock();
+  if (!l) { Serial.printf("[LED] no free layer for '%s'\n", in.id); return false; }
+  wake();
+  return true;
+}
+
+bool LedBus::solid(const char* id, uint8_t z, CRGB c, uint8_t bright, uint8_t alpha){
+  Layer l; l.id=id; l.z=z; l.bright=bright; l.alpha=alpha; l.anim=Anim::Solid; l.a=c;
+  return submit(l);
+}
+
+bool LedBus::blink(const char* id, uint8_t z, CRGB c, uint16_t periodMs, uint8_t bright, uint8_t alpha){
+  Layer l; l.id=id; l.z=z; l.bright=bright; l.alpha=alpha; l.anim=Anim::Blink; l.a=c;
+  l.durMs = periodMs ? periodMs : 1000; l.start=millis();
+  return submit(l);
+}
+
+bool LedBus::fade(const char* id, uint8_t z, CRGB from, CRGB to, uint16_t durMs, uint8_t bright, uint8_t alpha){
+  Layer l; l.id=id; l.z=z; l.bright=bright; l.alpha=alpha; l.anim=Anim::Fade; l.a=from; l.b=to;
+  l.durMs=durMs; l.start=millis();
+  return submit(l);
+}
+
+bool LedBus::pixels(const char* id, uint8_t z, const CRGB* px, uint8_t bright, uint8_t alpha){
+  if (!_inited) begin();
+  // avoid a full Layer temporary: write straight into the slot
+  _lock();
+  Layer* l = slotFor(id);
+  if (l) {
+    l->id=id; l->z=z; l->bright=bright; l->alpha=alpha; l->anim=Anim::Pixels;
+    memcpy(l->px, px, sizeof(l->px));
+  }
+  _unlock();
+  if (!l) { Serial.printf("[LED] no free layer for '%s'\n", id); return false; }
+  wake();
+  return true;
+}
+
+void LedBus::remove(const char* id){
+  _lock();
+  for (auto& l : _layers) if (l.id && strcmp(l.id, id) == 0) l.id = nullptr;
+  _unlock();
+  wake();
+}
+
+bool LedBus::compose(uint32_t now, bool& animating){
+  animating = false;
+  CRGB* out = _back;   // only the render task touches the back buffer
+  memset(_back, 0, sizeof(_back));
+
+  _lock();
+  // bottom-up by z; layer count is tiny, so a selection pass per z level is enough
+  int lastZ = -1;
+  for (;;) {
+    int z = 256;
+    for (auto& l : _layers) if (l.id && l.z > lastZ && l.z < z) z = l.z;
+    if (z == 256) break;
+    for (auto& l : _layers) {
+      if (!l.id || l.z != z) continue;
+      CRGB flat; bool perPixel = false;
+      switch (l.anim) {
+        case Anim::Solid:  flat = l.a; break;
+        case Anim::Blink:  flat = ((now - l.start) % l.durMs) < (l.durMs / 2u) ? l.a : CRGB::Black; animating = true; break;
+        case Anim::Fade: {
+          uint32_t el = now - l.start;
+          if (!l.durMs || el >= l.durMs) flat = l.b;
+          else { flat = blend(l.a, l.b, (uint8_t)((el * 255UL) / l.durMs)); animating = true; }
+        } break;
+        case Anim::Pixels: perPixel = true; break;
+      }
+      for (uint8_t i = 0; i < NUM_LEDS; ++i) {
+        CRGB c = perPixel ? l.px[i] : flat;
+        c.nscale8_video(l.bright);
+        out[i] = l.alpha == 255 ? c : blend(out[i], c, l.alpha);
+      }
+    }
+    lastZ = z;
+  }
+  _unlock();
+
+  return memcmp(_back, _front, sizeof(_back)) != 0;
+}
+
+bool LedBus::renderOnce(){
+  bool animating;
+  if (compose(millis(), animating)) {
+    // the only writer of _front; FastLED streams it out via RMT
+    memcpy(_front, _back, sizeof(_front));
+    FastLED.show();
+    _frames = _frames + 1;
+  }
+  return animating;
+}
+
+#if defined(ESP32)
+void LedBus::_taskLoop(void* pv){
+  LedBus* self = static_cast<LedBus*>(pv);
+  for (;;) {
+    bool animating = self->renderOnce();
+    // static frame: sleep until the next submit; animation: next frame
+    ulTaskNotifyTake(pdTRUE, animating ? pdMS_TO_TICKS(LED_BUS_FRAME_MS) : portMAX_DELAY);
+  }
+}
+#endif
@@ -0,0 +1,87 @@
+#pragma once
+#include <Arduino.h>
+#include <FastLED.h>
+
+#if defined(ESP32)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+#endif
+
+#ifndef LED_PIN
+#define LED_PIN     6
+#endif
+#ifndef NUM_LEDS
+#define NUM_LEDS    12
+#endif
+#ifndef LED_TYPE
+#define LED_TYPE    WS2812B
+#endif
+#ifndef COLOR_ORDER
+#define COLOR_ORDER GRB
+#endif
+#ifndef LED_BUS_LAYERS
+#define LED_BUS_LAYERS 4      // concurrent layers (one per LED tool is typical)
+#endif
+#ifndef LED_BUS_FRAME_MS
+#define LED_BUS_FRAME_MS 16   // frame period while an animation is running
+#endif
+#ifndef LED_BUS_CORE
+#define LED_BUS_CORE 0        // render task core (keeps transmits off the loop() core)
+#endif
+
+// Single owner of the WS2812B strip: the only place that calls FastLED.addLeds()/show().
+// Tools submit layers (solid / blink / fade / raw pixels) keyed by an owner id; a render
+// task composites them bottom-up by z (alpha-blended) into a back buffer and transmits
+// only when the composed frame differs from the one on the wire. FastLED drives the
+// strip through the ESP32 RMT peripheral, and the wait happens on the render task,
+// so neither loop() nor the MQTT callback ever blocks on the strip.
+// Without FreeRTOS, rendering happens inline on each submit.
+class LedBus {
+public:
+  enum class Anim : uint8_t { Solid, Blink, Fade, Pixels };
+
+  static LedBus& instance();
+
+  bool begin();   // idempotent; every LED tool may call it
+
+  // `id` must outlive the layer (string literal); re-submitting an id replaces that layer
+  bool solid(const char* id, uint8_t z, CRGB c, uint8_t bright=255, uint8_t alpha=255);
+  bool blink(const char* id, uint8_t z, CRGB c, uint16_t periodMs, uint8_t bright=255, uint8_t alpha=255);
+  bool fade (const char* id, uint8_t z, CRGB from, CRGB to, uint16_t durMs, uint8_t bright=255, uint8_t alpha=255);
+  bool pixels(const char* id, uint8_t z, const CRGB* px, uint8_t bright=255, uint8_t alpha=255);
+  void remove(const char* id);
+
+  uint32_t frames() const { return _frames; }   // transmits so far
+
+private:
+  struct Layer {
+    const char* id = nullptr;
+    uint8_t z = 0, bright = 255, alpha = 255;
+    Anim anim = Anim::Solid;
+    CRGB a, b;                 // solid/blink colour, fade from→to
+    uint16_t durMs = 0;        // blink period / fade duration
+    uint32_t start = 0;
+    CRGB px[NUM_LEDS];         // Anim::Pixels
+  };
+
+  LedBus() {}
+  Layer* slotFor(const char* id);   // existing or free layer, nullptr if full (call locked)
+  bool submit(const Layer& l);
+  bool compose(uint32_t now, bool& animating);   // back buffer; true if it differs from front
+  bool renderOnce();   // compose + transmit if changed; true while animating
+  void wake();
+
+  bool _inited = false;
+  Layer _layers[LED_BUS_LAYERS];
+  CRGB _front[NUM_LEDS];   // handed to FastLED (what is on the strip)
+  CRGB _back[NUM_LEDS];    // composed frame
+  volatile uint32_t _frames = 0;
+
+#if defined(ESP32)
+  TaskHandle_t _task = nullptr;
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+  static void _taskLoop(void* pv);
+#endif
+  void _lock();
+  void _unlock();
+};
@@ -0,0 +1,99 @@
+#include "announce_cache.h"
+#include <memory>
+#if defined(ESP32)
+  #include "esp_ota_ops.h"   // esp_ota_get_app_elf_sha256
+#endif
+
+static uint32_t fnv1a(uint32_t h, const char* s){
+  while(*s){ h^=(uint8_t)*s++; h*=16777619u; }
+  return h;
+}
+
+bool AnnounceCache::_loadNvs(Preferences& nvs){
+  if(!nvs.begin("mcp_ann", true)) return false;
+  bool ok = nvs.getUInt("key", 0)==_key && nvs.isKey("tools");
+  if(ok){
+    size_t n = nvs.getBytesLength("tools");
+    std::unique_ptr<char[]> buf(new char[n+1]);
+    ok = nvs.getBytes("tools", buf.get(), n)==n;
+    if(ok){ buf[n]=0; _tools=buf.get(); }
+  }
+  nvs.end();
+  return ok;
+}
+
+void AnnounceCache::clearNvs(Preferences& nvs){
+  if(!nvs.begin("mcp_ann", false)) return;
+  nvs.clear();
+  nvs.end();
+}
+
+void AnnounceCache::_saveNvs(Preferences& nvs) const {
+  if(!nvs.begin("mcp_ann", false)) return;
+  nvs.putUInt("key", _key);
+  nvs.putBytes("tools", _tools.c_str(), _tools.length());
+  nvs.end();
+}
+
+bool AnnounceCache::build(ToolRegistry& reg, const char* fw_version, Preferences* nvs){
+  _fw = fw_version;
+  _count = reg.list().size();
+  _key = fnv1a(2166136261u, fw_version);
+#if defined(ESP32)
+  // the image's ELF SHA-256 (stored in the app header at build time, no flash hashing):
+  // any rebuild invalidates the copy, even one that forgot to bump FW_VERSION
+  char elf[17] = {0};
+  esp_ota_get_app_elf_sha256(elf, sizeof(elf));
+  _key = fnv1a(_key, elf);
+#endif
+  for(auto* t:reg.list()){ _key = fnv1a(_key, "/"); _key = fnv1a(_key, t->name()); }
+
+  bool fromNvs = nvs && _loadNvs(*nvs);
+  if(!fromNvs){
+    // grow until every describe() fits (the old fixed 1 KB doc silently truncated)
+    for(size_t cap=1024; cap<=ANNOUNCE_DOC_MAX; cap*=2){
+      DynamicJsonDocument doc(cap);
+      JsonArray arr=doc.to<JsonArray>();
+      for(auto* t:reg.list()){ JsonObject o=arr.createNestedObject(); t->describe(o); }
+      if(doc.overflowed()) continue;
+      _tools=""; serializeJson(doc,_tools);
+      break;
+    }
+    if(!ready()){ Serial.println("[ANNOUNCE] schema exceeds ANNOUNCE_DOC_MAX"); return false; }
+    if(nvs) _saveNvs(*nvs);
+  }
+
+  snprintf(_hash, sizeof(_hash), "%08lx", (unsigned long)fnv1a(fnv1a(2166136261u, fw_version), _tools.c_str()));
+  Serial.printf("[ANNOUNCE] schema %s: %u tools, %u bytes%s\n", _hash, (unsigned)_count,
+                (unsigned)_tools.length(), fromNvs ? " (NVS)" : "");
+  return true;
+}
+
+String AnnounceCache::pointerJson(const String& device_id, const String& http_base) const {
+  StaticJsonDocument<512> doc;
+  doc["type"]="device.announce";
+  doc["device_id"]=device_id;
+  doc["http_base"]=http_base;
+  doc["version"]=_fw;
+  doc["schema_hash"]=(const char*)_hash;
+  doc["schema_url"]=http_base + "/announce.json";
+  doc["tools_count"]=_count;
+  JsonArray enc=doc.createNestedArray("encodings");   // cmd/events wire formats (cmd.mp / events.mp)
+  enc.add("json"); enc.add("msgpack");
+  JsonArray at=doc.createNestedArray("asset_transports");   // "mqtt": chunks on mcp/dev/<id>/assets/<asset_id>
+  at.add("http"); at.add("mqtt");
+  doc["rules_max"]=RULES_MAX;   // device.rules capacity (0 = no on-device reflexes)
+  doc["batch_max"]=BATCH_MAX_STEPS;   // steps per device.command_batch
+  String s; serializeJson(doc,s); return s;
+}
+
+String AnnounceCache::fullJson(const String& device_id, const String& http_base) const {
+  // header is tiny; splice the cached tools array in without re-parsing it
+  String s = pointerJson(device_id, http_base);
+  s.remove(s.length()-1);
+  s.reserve(s.length() + _tools.length() + 16);
+  s += ",\"tools\":";
+  s += _tools;
+  s += "}";
+  return s;
+}
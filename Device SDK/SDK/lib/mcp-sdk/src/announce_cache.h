@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "registry.h"
+#include "rule_engine.h"   // RULES_MAX
+
+#ifndef ANNOUNCE_DOC_MAX
+#define ANNOUNCE_DOC_MAX 32768   // upper bound while growing the describe() doc
+#endif
+
+// Tool schema built once at boot and reused for every announce.
+// - the tools array is serialized once; its doc grows until describe() no longer overflows
+// - schema_hash = FNV-1a(fw_version + tools JSON), so any schema/firmware change shows up
+// - optional NVS copy keyed by (fw_version, firmware image, tool names): later boots of the
+//   same build skip describe() entirely; clearNvs() drops it (factory reset)
+// The retained MQTT announce only carries {device_id, schema_hash, schema_url}; the full
+// schema is served from /announce.json.
+class AnnounceCache {
+ public:
+  bool build(ToolRegistry& reg, const char* fw_version, Preferences* nvs=nullptr);
+  static void clearNvs(Preferences& nvs);
+  bool ready() const { return _tools.length() > 0; }
+  const char* hash() const { return _hash; }
+  size_t toolCount() const { return _count; }
+
+  // Small retained announce (pointer to the schema)
+  String pointerJson(const String& device_id, const String& http_base) const;
+  // Full announce incl. tools (served by /announce.json)
+  String fullJson(const String& device_id, const String& http_base) const;
+
+ private:
+  String _tools;        // serialized "tools" array
+  char _hash[9] = {0};
+  uint32_t _key = 0;    // fw + image hash + tool names, validates the NVS copy
+  size_t _count = 0;
+  String _fw;
+  bool _loadNvs(Preferences& nvs);
+  void _saveNvs(Preferences& nvs) const;
+};
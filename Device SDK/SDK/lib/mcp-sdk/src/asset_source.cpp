@@ -0,0 +1,39 @@
+#include "asset_source.h"
+#include <stdio.h>
+#if defined(ESP32)
+  #include "mbedtls/sha256.h"
+#endif
+
+namespace {
+  IAssetSource* g_sources[ASSET_MAX_SOURCES] = {};
+  uint8_t g_count = 0;
+}
+
+namespace AssetSources {
+
+bool add(IAssetSource* src){
+  if (!src || g_count >= ASSET_MAX_SOURCES) return false;
+  for (uint8_t i=0; i<g_count; i++) if (g_sources[i] == src) return true;
+  g_sources[g_count++] = src;
+  return true;
+}
+
+IAssetSource* open(const char* asset_id, AssetRef& ref){
+  if (!asset_id || !asset_id[0]) return nullptr;
+  for (uint8_t i=0; i<g_count; i++) if (g_sources[i]->openAsset(asset_id, ref)) return g_sources[i];
+  return nullptr;
+}
+
+bool sha256Hex(const uint8_t* data, size_t len, char out[65]){
+#if defined(ESP32)
+  uint8_t d[32];
+  mbedtls_sha256(data, len, d, 0);
+  for (int i=0; i<32; i++) snprintf(out + i*2, 3, "%02x", d[i]);
+  return true;
+#else
+  (void)data; (void)len; out[0] = 0;
+  return false;
+#endif
+}
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef ASSET_CHUNK_BYTES
+#define ASSET_CHUNK_BYTES 4096     // payload bytes per MQTT asset chunk
+#endif
+#ifndef ASSET_MAX_SOURCES
+#define ASSET_MAX_SOURCES 4
+#endif
+
+// Binary assets that can be pushed over MQTT (asset transport "mqtt") instead of being
+// fetched from the device by URL. Tools that own asset bytes (camera ring, ...) register
+// as a source; the network task opens the asset by id, streams it, then closes it.
+//
+// Chunk contract, topic mcp/dev/<device_id>/assets/<asset_id>, one message per chunk:
+//   "MCPA" | seq u16 | count u16 | offset u32 | total u32   (16-byte header, little endian)
+//   followed by up to ASSET_CHUNK_BYTES of data. count == 0 means the asset is gone.
+// The asset entry in the observation carries transport:"mqtt", size, chunks, chunk_bytes
+// and sha256 (hex of the whole asset); the receiver reassembles by offset and checks the digest.
+struct AssetRef {
+  const uint8_t* data = nullptr;
+  size_t len = 0;
+  const void* token = nullptr;   // source-private (e.g. the pinned frame)
+};
+
+struct IAssetSource {
+  virtual ~IAssetSource(){}
+  // Pin the bytes until closeAsset(); false if this source does not know the id (any more)
+  virtual bool openAsset(const char* asset_id, AssetRef& ref) = 0;
+  virtual void closeAsset(AssetRef& ref) = 0;
+};
+
+namespace AssetSources {
+  bool add(IAssetSource* src);
+  // First source that can open asset_id, or nullptr
+  IAssetSource* open(const char* asset_id, AssetRef& ref);
+  // Writes 64 hex chars + NUL; false where no SHA-256 implementation is available
+  bool sha256Hex(const uint8_t* data, size_t len, char out[65]);
+}
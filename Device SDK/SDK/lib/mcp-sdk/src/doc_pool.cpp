@@ -0,0 +1,87 @@
+#include "doc_pool.h"
+#include <new>
+#include "mcp_log.h"
+
+#if defined(ESP32)
+  #define POOL_LOCK()   portENTER_CRITICAL(&_mux)
+  #define POOL_UNLOCK() portEXIT_CRITICAL(&_mux)
+#else
+  #define POOL_LOCK()
+  #define POOL_UNLOCK()
+#endif
+
+// log the 1st, 2nd, 4th, 8th ... occurrence: a steady miss/overflow rate costs no UART time
+static bool logNth(uint32_t n){ return (n & (n - 1)) == 0; }
+
+void* DocPool::Allocator::allocate(size_t n){
+#if defined(ESP32)
+  if (psramFound()) if (void* p = ps_malloc(n)) return p;
+#endif
+  return malloc(n);
+}
+
+DocPool::DocPool(){
+  for (int i=0; i<DOC_POOL_SMALL + DOC_POOL_LARGE; i++)
+    _slots[i].cap = i < DOC_POOL_SMALL ? DOC_POOL_SMALL_BYTES : DOC_POOL_LARGE_BYTES;
+}
+
+JsonDocument* DocPool::acquire(size_t minBytes){
+  Slot* s = nullptr;
+  POOL_LOCK();
+  for (auto& sl : _slots) {   // small class first, so the first fit is the smallest
+    if (sl.used || sl.cap < minBytes) continue;
+    sl.used = true;
+    s = &sl;
+    if (++_stats.in_use > _stats.high_water) _stats.high_water = _stats.in_use;
+    break;
+  }
+  if (!s) _stats.misses++;
+  uint32_t misses = _stats.misses;
+  POOL_UNLOCK();
+
+  if (s) {
+    // allocated outside the lock; only this lease can see the slot until release()
+    if (!s->doc) s->doc = new (std::nothrow) Doc(s->cap);
+    if (s->doc && s->doc->capacity()) return s->doc;
+    delete s->doc; s->doc = nullptr;
+    POOL_LOCK(); s->used = false; _stats.in_use--; misses = ++_stats.misses; POOL_UNLOCK();
+  }
+  if (logNth(misses)) MCP_LOGW("POOL", "no pooled doc for %u bytes, using heap (miss #%lu)",
+                               (unsigned)minBytes, (unsigned long)misses);
+  Doc* d = new (std::nothrow) Doc(minBytes);
+  if (d && d->capacity()) return d;
+  delete d;
+  // out of memory: every write to the shared empty doc fails (overflowed), nothing crashes
+  POOL_LOCK(); _stats.heap_failed++; POOL_UNLOCK();
+  MCP_LOGW("POOL", "no heap for a %u byte doc", (unsigned)minBytes);
+  return &_empty;
+}
+
+void DocPool::release(JsonDocument* doc){
+  if (!doc || doc == &_empty) return;
+  const bool over = doc->overflowed();
+  const size_t cap = doc->capacity();
+  doc->clear();
+  bool pooled = false;
+  POOL_LOCK();
+  if (over) _stats.overflows++;
+  const uint32_t overflows = _stats.overflows;
+  for (auto& sl : _slots) {
+    if (sl.doc != doc) continue;
+    sl.used = false;
+    _stats.in_use--;
+    pooled = true;
+    break;
+  }
+  POOL_UNLOCK();
+  if (over && logNth(overflows))
+    MCP_LOGW("POOL", "doc overflowed (capacity %u, overflow #%lu)", (unsigned)cap, (unsigned long)overflows);
+  if (!pooled) delete static_cast<Doc*>(doc);   // heap fallback
+}
+
+DocPool::Stats DocPool::stats() const {
+  POOL_LOCK();
+  Stats s = _stats;
+  POOL_UNLOCK();
+  return s;
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#if defined(ESP32)
+  #include "freertos/FreeRTOS.h"
+#endif
+
+#ifndef DOC_POOL_SMALL_BYTES
+#define DOC_POOL_SMALL_BYTES 768    // cmd docs (EXEC_ARGS_DOC_SIZE), status
+#endif
+#ifndef DOC_POOL_SMALL
+#define DOC_POOL_SMALL 4
+#endif
+#ifndef DOC_POOL_LARGE_BYTES
+#define DOC_POOL_LARGE_BYTES 2048   // ObservationBuilder default
+#endif
+#ifndef DOC_POOL_LARGE
+#define DOC_POOL_LARGE 8            // replies, event locals, executor jobs, emitter scratch
+#endif
+
+// Preallocated JSON documents shared by commands, replies and events, so none of them
+// sit on a task stack (the cmd + reply + event docs used to cost ~4.8 KB per command).
+// - two size classes; acquire(n) hands out the smallest free doc with capacity >= n
+// - a slot's buffer is allocated on its first use (PSRAM when available) and kept forever,
+//   so steady state does no heap traffic; peak concurrency decides what is actually used
+// - bigger than the large class or pool exhausted → plain heap doc, counted as a miss
+// - no heap either → a shared zero-capacity doc (writes fail as overflowed), never nullptr
+// - release() counts docs that overflowed (truncated output); misses and overflows are
+//   logged (MCP_LOGW) at the 1st, 2nd, 4th ... occurrence only, the totals are in stats()
+// Safe from any task.
+class DocPool {
+ public:
+  struct Allocator {
+    void* allocate(size_t n);
+    void deallocate(void* p){ free(p); }
+    void* reallocate(void* p, size_t n){ return realloc(p, n); }
+  };
+  using Doc = BasicJsonDocument<Allocator>;
+
+  struct Stats {
+    uint16_t in_use = 0;
+    uint16_t high_water = 0;   // max docs leased at once
+    uint32_t misses = 0;       // served from the heap instead
+    uint32_t overflows = 0;    // docs released with overflowed() set
+    uint32_t heap_failed = 0;  // misses the heap could not serve either (got the empty doc)
+  };
+
+  static DocPool& instance(){ static DocPool p; return p; }
+
+  JsonDocument* acquire(size_t minBytes);
+  void release(JsonDocument* doc);
+  Stats stats() const;
+
+ private:
+  struct Slot { Doc* doc = nullptr; size_t cap = 0; bool used = false; };
+  DocPool();
+
+  Slot _slots[DOC_POOL_SMALL + DOC_POOL_LARGE];
+  Doc _empty{0};
+  Stats _stats;
+#if defined(ESP32)
+  mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+};
+
+// RAII lease of a pooled document
+class DocLease {
+ public:
+  explicit DocLease(size_t minBytes) : _doc(DocPool::instance().acquire(minBytes)) {}
+  ~DocLease(){ DocPool::instance().release(_doc); }
+  DocLease(const DocLease&) = delete;
+  DocLease& operator=(const DocLease&) = delete;
+  JsonDocument& doc(){ return *_doc; }
+  const JsonDocument& doc() const { return *_doc; }
+ private:
+  JsonDocument* _doc;
+};
@@ -0,0 +1,128 @@
+#include "executor.h"
+#include <new>
+#include "metrics.h"
+#include "mcp_log.h"
+#include "trace.h"
+
+#if defined(ESP32)
+
+bool ToolExecutor::begin(uint8_t workers, uint32_t stackBytes, uint8_t prio){
+  if (_started) return true;
+  _todo = xQueueCreate(EXEC_MAX_JOBS, sizeof(Job*));
+  _done = xQueueCreate(EXEC_MAX_JOBS, sizeof(Job*));
+  if (!_todo || !_done) return false;
+  uint8_t created=0;
+  if (workers > EXEC_MAX_WORKERS) workers = EXEC_MAX_WORKERS;
+  for (uint8_t i=0; i<workers; i++){
+    char nm[16]; snprintf(nm, sizeof(nm), "ToolExec%u", (unsigned)i);
+    if (xTaskCreate(&_workerLoop, nm, stackBytes, this, prio, &_workers[i]) != pdPASS) break;
+    created++;
+  }
+  _started = created>0;
+  return _started;
+}
+
+uint8_t ToolExecutor::inflight(const ITool* t) const {
+  uint8_t n=0;
+  portENTER_CRITICAL(&_mux);
+  for (auto* j : _slots) if (j && j->tool==t) n++;
+  portEXIT_CRITICAL(&_mux);
+  return n;
+}
+
+uint32_t ToolExecutor::stackHighWater() const {
+  uint32_t m = 0;
+  for (auto h : _workers) if (h) { uint32_t w = uxTaskGetStackHighWaterMark(h); if (!m || w < m) m = w; }
+  return m;
+}
+
+ToolExecutor::Submit ToolExecutor::submit(ITool* t, JsonObjectConst args, const char* rid,
+                                          ObservationBuilder::AssetTransport transport, size_t replyBytes){
+  if (!_started) return Submit::Unavailable;
+  uint8_t limit = t->maxConcurrency();
+  if (limit && inflight(t) >= limit) return Submit::Busy;
+
+  Job* j = new (std::nothrow) Job(replyBytes);
+  if (!j) return Submit::Full;
+  j->tool = t;
+  strlcpy(j->rid, rid, sizeof(j->rid));
+  if (!args.isNull()) j->args.doc().set(args);
+  j->ob.setRequestId(j->rid);
+  j->ob.setAssetTransport(transport);
+  j->ob.bindCancel(&j->cancel);
+
+  int slot=-1;
+  portENTER_CRITICAL(&_mux);
+  for (int i=0; i<EXEC_MAX_JOBS; i++) if (!_slots[i]) { _slots[i]=j; slot=i; break; }
+  portEXIT_CRITICAL(&_mux);
+  if (slot<0) { delete j; return Submit::Full; }
+
+  if (xQueueSend(_todo, &j, 0) != pdTRUE){
+    portENTER_CRITICAL(&_mux); _slots[slot]=nullptr; portEXIT_CRITICAL(&_mux);
+    delete j;
+    return Submit::Full;
+  }
+  return Submit::Queued;
+}
+
+bool ToolExecutor::cancel(const char* rid){
+  bool found=false;
+  portENTER_CRITICAL(&_mux);
+  for (auto* j : _slots){
+    if (j && !j->done && strcmp(j->rid, rid)==0){ j->cancel=true; found=true; break; }
+  }
+  portEXIT_CRITICAL(&_mux);
+  return found;
+}
+
+void ToolExecutor::_run(Job* j){
+  if (j->cancel) {
+    j->ob.error("cancelled", "cancelled before start");
+  } else {
+    JsonObjectConst args = j->args.doc().isNull() ? JsonObjectConst() : j->args.doc().as<JsonObjectConst>();
+    uint32_t t0 = micros();
+    bool ok = j->tool->invoke(args, j->ob);
+    uint32_t us = micros() - t0;
+    METRIC_OBSERVE("mcp_tool_latency_us", j->tool->name(), us);
+    MCP_TRACE_EVT(JobEnd, j->rid, j->tool->name(), us);
+    if (!ok) METRIC_COUNT("mcp_tool_errors_total", j->tool->name(), 1);
+    // tool may have returned early on cancel without filling an error
+    if (!ok && j->cancel && j->ob.doc["error"].isNull()) j->ob.error("cancelled", "cancelled by request");
+  }
+  j->done = true;
+  xQueueSend(_done, &j, portMAX_DELAY);
+}
+
+void ToolExecutor::_workerLoop(void* pv){
+  ToolExecutor* self = static_cast<ToolExecutor*>(pv);
+  for (;;) {
+    Job* j = nullptr;
+    if (xQueueReceive(self->_todo, &j, portMAX_DELAY) == pdTRUE && j) self->_run(j);
+  }
+}
+
+void ToolExecutor::pump(const Sink& sink){
+  if (!_started) return;
+  Job* j = nullptr;
+  while (xQueueReceive(_done, &j, 0) == pdTRUE && j){
+    MCP_LOGD("EXEC", "job %s (%s) finished", j->rid, j->tool->name());
+    j->ob.resolveUrls();
+    if (sink) sink(j->ob);
+    portENTER_CRITICAL(&_mux);
+    for (auto& s : _slots) if (s==j) { s=nullptr; break; }
+    portEXIT_CRITICAL(&_mux);
+    delete j;
+  }
+}
+
+#else  // no FreeRTOS: executor stays unavailable, registry dispatches inline
+
+bool ToolExecutor::begin(uint8_t, uint32_t, uint8_t){ return false; }
+uint8_t ToolExecutor::inflight(const ITool*) const { return 0; }
+uint32_t ToolExecutor::stackHighWater() const { return 0; }
+ToolExecutor::Submit ToolExecutor::submit(ITool*, JsonObjectConst, const char*, ObservationBuilder::AssetTransport, size_t){ return Submit::Unavailable; }
+bool ToolExecutor::cancel(const char*){ return false; }
+void ToolExecutor::_run(Job*){}
+void ToolExecutor::pump(const Sink&){}
+
+#endif
@@ -0,0 +1,65 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include "tool.h"
+
+#if defined(ESP32)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+  #include "freertos/queue.h"
+#endif
+
+#ifndef EXEC_MAX_JOBS
+#define EXEC_MAX_JOBS 6        // queued + running jobs across all tools
+#endif
+#ifndef EXEC_MAX_WORKERS
+#define EXEC_MAX_WORKERS 4
+#endif
+#ifndef EXEC_ARGS_DOC_SIZE
+#define EXEC_ARGS_DOC_SIZE 768 // matches the cmd doc in ToolRuntime::handle (DocPool small class)
+#endif
+
+// Runs long-running tools (ITool::longRunning()) on FreeRTOS worker task(s).
+// - submit() copies args and queues the job by request_id (called from the MQTT callback)
+// - workers call invoke() with a cancel flag bound to the ObservationBuilder
+// - pump() hands finished observations back on the caller's thread (loop()),
+//   so the MQTT transport is only ever touched from one task.
+class ToolExecutor {
+ public:
+  using Sink = std::function<void(const ObservationBuilder&)>;
+  enum class Submit : uint8_t { Queued, Busy, Full, Unavailable };
+
+  bool begin(uint8_t workers=1, uint32_t stackBytes=8192, uint8_t prio=1);
+  bool running() const { return _started; }
+
+  Submit submit(ITool* t, JsonObjectConst args, const char* rid,
+                ObservationBuilder::AssetTransport transport = ObservationBuilder::defaultTransport(),
+                size_t replyBytes = DOC_POOL_LARGE_BYTES);
+  bool cancel(const char* rid);        // false if no such job
+  void pump(const Sink& sink);         // emit + free finished jobs
+  uint8_t inflight(const ITool* t) const;
+  uint32_t stackHighWater() const;     // least free stack (bytes) over the workers, 0 = none
+
+ private:
+  struct Job {
+    explicit Job(size_t replyBytes) : args(EXEC_ARGS_DOC_SIZE), ob(replyBytes) {}
+    ITool* tool = nullptr;
+    char rid[48] = {0};
+    DocLease args;             // pooled, like the reply
+    ObservationBuilder ob;
+    volatile bool cancel = false;
+    volatile bool done = false;
+  };
+
+  bool _started = false;
+  Job* _slots[EXEC_MAX_JOBS] = {};
+#if defined(ESP32)
+  QueueHandle_t _todo = nullptr;   // Job* waiting for a worker
+  QueueHandle_t _done = nullptr;   // Job* finished, drained by pump()
+  TaskHandle_t _workers[EXEC_MAX_WORKERS] = {};
+  mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+  static void _workerLoop(void* pv);
+#endif
+  void _run(Job* j);
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <Arduino.h>
+
+// Compile-time log levels. Anything above MCP_LOG_LEVEL is removed by the preprocessor,
+// so per-command chatter costs nothing in release builds:
+//   MCP_LOGD("REGISTRY", "Dispatch tool='%s'", name);   // -> "[REGISTRY] Dispatch tool='...'"
+// Serial writes block on the UART (115200 baud ≈ 11.5 bytes/ms); keep hot paths at DEBUG
+// and use the trace ring (trace.h) to follow a command end to end.
+#define MCP_LOG_NONE  0
+#define MCP_LOG_ERROR 1
+#define MCP_LOG_WARN  2
+#define MCP_LOG_INFO  3
+#define MCP_LOG_DEBUG 4
+
+#ifndef MCP_LOG_LEVEL
+#define MCP_LOG_LEVEL MCP_LOG_INFO
+#endif
+
+#define MCP_LOG_PRINT(tag, fmt, ...) Serial.printf("[" tag "] " fmt "\n", ##__VA_ARGS__)
+
+#if MCP_LOG_LEVEL >= MCP_LOG_ERROR
+  #define MCP_LOGE(tag, fmt, ...) MCP_LOG_PRINT(tag, fmt, ##__VA_ARGS__)
+#else
+  #define MCP_LOGE(tag, fmt, ...) do {} while (0)
+#endif
+#if MCP_LOG_LEVEL >= MCP_LOG_WARN
+  #define MCP_LOGW(tag, fmt, ...) MCP_LOG_PRINT(tag, fmt, ##__VA_ARGS__)
+#else
+  #define MCP_LOGW(tag, fmt, ...) do {} while (0)
+#endif
+#if MCP_LOG_LEVEL >= MCP_LOG_INFO
+  #define MCP_LOGI(tag, fmt, ...) MCP_LOG_PRINT(tag, fmt, ##__VA_ARGS__)
+#else
+  #define MCP_LOGI(tag, fmt, ...) do {} while (0)
+#endif
+#if MCP_LOG_LEVEL >= MCP_LOG_DEBUG
+  #define MCP_LOGD(tag, fmt, ...) MCP_LOG_PRINT(tag, fmt, ##__VA_ARGS__)
+#else
+  #define MCP_LOGD(tag, fmt, ...) do {} while (0)
+#endif
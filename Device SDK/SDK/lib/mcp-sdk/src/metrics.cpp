@@ -0,0 +1,122 @@
+#include "metrics.h"
+
+#if defined(ESP32)
+  #define METRICS_LOCK()   portENTER_CRITICAL(&_mux)
+  #define METRICS_UNLOCK() portEXIT_CRITICAL(&_mux)
+#else
+  #define METRICS_LOCK()
+  #define METRICS_UNLOCK()
+#endif
+
+constexpr uint32_t Metrics::kBounds[METRICS_BUCKETS - 1];
+
+void Metrics::observe(const char* family, const char* label, uint32_t us){
+  uint8_t b = 0;
+  while (b < METRICS_BUCKETS - 1 && us > kBounds[b]) b++;
+  METRICS_LOCK();
+  for (auto& h : _hist) {
+    if (!h.family) { h.family = family; h.label = label; }
+    else if (!same(h.family, family) || !same(h.label, label)) continue;
+    h.buckets[b]++;
+    h.count++;
+    h.sum += us;
+    if (us > h.max) h.max = us;
+    break;
+  }
+  METRICS_UNLOCK();
+}
+
+void Metrics::count(const char* family, const char* label, uint32_t n){
+  METRICS_LOCK();
+  for (auto& c : _ctr) {
+    if (!c.family) { c.family = family; c.label = label; }
+    else if (!same(c.family, family) || !same(c.label, label)) continue;
+    c.value += n;
+    break;
+  }
+  METRICS_UNLOCK();
+}
+
+bool Metrics::gauge(const char* name, GaugeFn fn){
+  bool ok = false;
+  METRICS_LOCK();
+  for (auto& g : _gauges) if (!g.name || same(g.name, name)) { g.name = name; g.fn = fn; ok = true; break; }
+  METRICS_UNLOCK();
+  return ok;
+}
+
+// Upper bound of the bucket holding the 90th percentile (max for the +Inf bucket)
+uint32_t Metrics::p90(const Hist& h) const {
+  if (!h.count) return 0;
+  uint32_t want = (h.count * 9 + 9) / 10, acc = 0;
+  for (uint8_t b = 0; b < METRICS_BUCKETS - 1; b++) {
+    acc += h.buckets[b];
+    if (acc >= want) return kBounds[b] < h.max ? kBounds[b] : h.max;
+  }
+  return h.max;
+}
+
+// Series sit in first-use order, so one family's labels may be interleaved with others
+// (e.g. {fail} created after a later family); the exposition format wants every family once:
+// one # TYPE line, then all of its series.
+template <typename T, size_t N>
+static bool seenBefore(const T (&rows)[N], size_t i, bool (*same)(const char*, const char*)){
+  for (size_t j = 0; j < i; j++) if (same(rows[j].family, rows[i].family)) return true;
+  return false;
+}
+
+void Metrics::render(Print& out) const {
+  for (size_t i = 0; i < METRICS_MAX_HIST && _hist[i].family; i++) {
+    if (seenBefore(_hist, i, &same)) continue;
+    out.printf("# TYPE %s histogram\n", _hist[i].family);
+    for (size_t k = i; k < METRICS_MAX_HIST && _hist[k].family; k++) {
+      if (!same(_hist[k].family, _hist[i].family)) continue;
+      METRICS_LOCK(); Hist h = _hist[k]; METRICS_UNLOCK();   // consistent snapshot per series
+      uint32_t acc = 0;
+      for (uint8_t b = 0; b < METRICS_BUCKETS; b++) {
+        acc += h.buckets[b];
+        if (b < METRICS_BUCKETS - 1) out.printf("%s_bucket{label=\"%s\",le=\"%lu\"} %lu\n", h.family, h.label,
+                                                 (unsigned long)kBounds[b], (unsigned long)acc);
+        else                         out.printf("%s_bucket{label=\"%s\",le=\"+Inf\"} %lu\n", h.family, h.label,
+                                                 (unsigned long)acc);
+      }
+      out.printf("%s_sum{label=\"%s\"} %llu\n", h.family, h.label, (unsigned long long)h.sum);
+      out.printf("%s_count{label=\"%s\"} %lu\n", h.family, h.label, (unsigned long)h.count);
+    }
+  }
+  for (size_t i = 0; i < METRICS_MAX_COUNTERS && _ctr[i].family; i++) {
+    if (seenBefore(_ctr, i, &same)) continue;
+    out.printf("# TYPE %s counter\n", _ctr[i].family);
+    for (size_t k = i; k < METRICS_MAX_COUNTERS && _ctr[k].family; k++) {
+      const Counter& c = _ctr[k];
+      if (same(c.family, _ctr[i].family)) out.printf("%s{label=\"%s\"} %lu\n", c.family, c.label, (unsigned long)c.value);
+    }
+  }
+  for (const auto& g : _gauges) {
+    if (!g.name) break;
+    out.printf("# TYPE %s gauge\n%s %.0f\n", g.name, g.name, g.fn ? g.fn() : 0.0f);
+  }
+}
+
+void Metrics::toJson(JsonObject out) const {
+  JsonArray ha = out.createNestedArray("h");
+  for (const auto& src : _hist) {
+    if (!src.family) break;
+    METRICS_LOCK(); Hist h = src; METRICS_UNLOCK();
+    JsonArray r = ha.createNestedArray();
+    r.add(h.family); r.add(h.label); r.add(h.count);
+    r.add(h.count ? (uint32_t)(h.sum / h.count) : 0);
+    r.add(p90(h)); r.add(h.max);
+  }
+  JsonArray ca = out.createNestedArray("c");
+  for (const auto& c : _ctr) {
+    if (!c.family) break;
+    JsonArray r = ca.createNestedArray();
+    r.add(c.family); r.add(c.label); r.add(c.value);
+  }
+  JsonObject go = out.createNestedObject("g");
+  for (const auto& g : _gauges) {
+    if (!g.name) break;
+    go[g.name] = g.fn ? g.fn() : 0.0f;
+  }
+}
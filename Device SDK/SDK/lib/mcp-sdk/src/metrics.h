@@ -0,0 +1,74 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#if defined(ESP32)
+  #include "freertos/FreeRTOS.h"
+#endif
+
+#ifndef MCP_METRICS
+#define MCP_METRICS 1              // 0 = all METRIC_* calls compile away, /metrics not registered
+#endif
+#ifndef METRICS_MAX_HIST
+#define METRICS_MAX_HIST 24        // histogram series (family + label)
+#endif
+#ifndef METRICS_MAX_COUNTERS
+#define METRICS_MAX_COUNTERS 24
+#endif
+#ifndef METRICS_MAX_GAUGES
+#define METRICS_MAX_GAUGES 10
+#endif
+#define METRICS_BUCKETS 11         // incl. +Inf
+
+// In-RAM performance counters, rendered as Prometheus text (/metrics) or a compact JSON
+// object (device.metrics). Fixed tables, no allocation after the first use of a series.
+// family/label must be string literals or otherwise outlive the firmware (tool names are).
+//   METRIC_OBSERVE("mcp_tool_latency_us", tool->name(), us);   // histogram, microseconds
+//   METRIC_COUNT("mcp_mqtt_publish_total", "ok", 1);             // counter
+// Gauges are sampled at render time through a callback (queue depth, free heap, ...).
+// Safe from any task.
+class Metrics {
+ public:
+  using GaugeFn = float (*)();
+
+  static Metrics& instance(){ static Metrics m; return m; }
+
+  void observe(const char* family, const char* label, uint32_t us);
+  void count(const char* family, const char* label, uint32_t n);
+  bool gauge(const char* name, GaugeFn fn);
+
+  void render(Print& out) const;          // Prometheus text exposition format 0.0.4
+  void toJson(JsonObject out) const;      // {"h":[[family,label,count,avg_us,p90_us,max_us]],"c":[[family,label,n]],"g":{name:v}}
+
+  static constexpr uint32_t kBounds[METRICS_BUCKETS - 1] = {
+    100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000 };
+
+ private:
+  struct Hist {
+    const char* family = nullptr; const char* label = nullptr;
+    uint32_t buckets[METRICS_BUCKETS] = {};
+    uint32_t count = 0, max = 0;
+    uint64_t sum = 0;
+  };
+  struct Counter { const char* family = nullptr; const char* label = nullptr; uint32_t value = 0; };
+  struct Gauge { const char* name = nullptr; GaugeFn fn = nullptr; };
+
+  Metrics() {}
+  static bool same(const char* a, const char* b){ return a == b || (a && b && strcmp(a, b) == 0); }
+  uint32_t p90(const Hist& h) const;
+
+  Hist _hist[METRICS_MAX_HIST];
+  Counter _ctr[METRICS_MAX_COUNTERS];
+  Gauge _gauges[METRICS_MAX_GAUGES];
+#if defined(ESP32)
+  mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+};
+
+#if MCP_METRICS
+  #define METRIC_OBSERVE(family, label, us) Metrics::instance().observe((family), (label), (us))
+  #define METRIC_COUNT(family, label, n)    Metrics::instance().count((family), (label), (n))
+#else
+  #define METRIC_OBSERVE(family, label, us) do {} while (0)
+  #define METRIC_COUNT(family, label, n)    do {} while (0)
+#endif
@@ -1,53 +1,274 @@
 #include "registry.h"
 #include <Arduino.h>
+#include "metrics.h"
+#include "mcp_log.h"
+#include "trace.h"
 
 String ToolRegistry::buildAnnounce(const String& device_id, const String& http_base){
-  StaticJsonDocument<1024> doc;
-  doc["type"]="device.announce";
-  doc["device_id"]=device_id;
-  doc["http_base"]=http_base;
-  JsonArray arr=doc.createNestedArray("tools");
-  for(auto* t:tools){ JsonObject o=arr.createNestedObject(); t->describe(o); }
-  String s; serializeJson(doc,s); return s;
+  // Uncached full announce; the doc grows instead of truncating (see AnnounceCache for the boot-time cache)
+  for(size_t cap=1024;; cap*=2){
+    DynamicJsonDocument doc(cap);
+    doc["type"]="device.announce";
+    doc["device_id"]=device_id;
+    doc["http_base"]=http_base;
+    JsonArray arr=doc.createNestedArray("tools");
+    for(auto* t:tools){ JsonObject o=arr.createNestedObject(); t->describe(o); }
+    if(doc.overflowed() && cap<32768) continue;
+    String s; serializeJson(doc,s); return s;
+  }
+}
+
+bool ToolRegistry::initAll(){
+  bool ok=true;
+  docBytes.assign(tools.size(), 0);
+  for(size_t i=0;i<tools.size();i++){
+    ok=tools[i]->init() && ok;
+    DocLease d(DOC_POOL_LARGE_BYTES);
+    JsonObject o=d.doc().to<JsonObject>();
+    tools[i]->describe(o);
+    docBytes[i]=o["reply_doc_bytes"] | 0;
+  }
+  return ok;
+}
+
+size_t ToolRegistry::replyBytes(const ITool* t) const {
+  for(size_t i=0;t && i<tools.size() && i<docBytes.size();i++)
+    if(tools[i]==t && docBytes[i]) return docBytes[i];
+  return DOC_POOL_LARGE_BYTES;
+}
+
+size_t ToolRegistry::replyBytes(const JsonDocument& cmd) const {
+  if(strcmp(cmd["type"]|"","device.command_batch")==0) return BATCH_REPLY_BYTES;
+  return replyBytes(cmd["tool"]|"");
+}
+
+void ToolRegistry::reindex(){
+  size_t cap=4; while(cap < tools.size()*2) cap<<=1;
+  index.assign(cap, Slot{0,nullptr});
+  for(auto* t:tools){
+    uint32_t h=hashName(t->name());
+    size_t i=h&(cap-1);
+    while(index[i].tool) i=(i+1)&(cap-1);
+    index[i]=Slot{h,t};
+  }
 }
 
-bool ToolRegistry::dispatch(const JsonDocument& cmd, String& outEventsJson, const String& http_base){
+ITool* ToolRegistry::find(const char* name) const {
+  if(!name || index.empty()) return nullptr;
+  const uint32_t h=hashName(name);
+  const size_t mask=index.size()-1;
+  for(size_t i=h&mask; index[i].tool; i=(i+1)&mask){
+    if(index[i].hash==h && strcmp(index[i].tool->name(), name)==0) return index[i].tool;
+  }
+  return nullptr;
+}
+
+bool ToolRegistry::cancel(const JsonDocument& cmd, ObservationBuilder& out){
+  const char* rid=cmd["request_id"]|"";
+  out.setRequestId(rid);
+  if(executor && rid[0] && executor->cancel(rid)){
+    out.ack("cancelling");
+    return true;
+  }
+  out.error("not_found","no running job for request_id");
+  return false;
+}
+
+// Inline invoke with latency metric, trace and resolved asset URLs
+bool ToolRegistry::invoke(ITool* t, JsonObjectConst args, const char* rid, ObservationBuilder& out, uint32_t& us){
+  uint32_t t0 = micros();
+  bool ok = t->invoke(args, out);
+  us = micros() - t0;
+  METRIC_OBSERVE("mcp_tool_latency_us", t->name(), us);
+  if(!ok) METRIC_COUNT("mcp_tool_errors_total", t->name(), 1);
+  if(ok) MCP_TRACE_EVT(InvokeEnd, rid, t->name(), us);
+  else   MCP_TRACE_EVT(InvokeError, rid, t->name(), us);
+  MCP_LOGD("REGISTRY", "Tool '%s' returned %s (%uus)", t->name(), ok ? "true" : "false", (unsigned)us);
+  out.resolveUrls();
+  return ok;
+}
+
+bool ToolRegistry::batch(const JsonDocument& cmd, ObservationBuilder& out){
+  const char* rid=cmd["request_id"]|"";
+  char ridBuf[12];
+  const bool ridGiven=rid[0] && (cmd["cache"]|true);
+  if(!rid[0]){ snprintf(ridBuf, sizeof(ridBuf), "%lx", (unsigned long)millis()); out.setRequestId(String(ridBuf)); rid=ridBuf; }
+  else out.setRequestId(rid);
+  out.setAssetTransport(ObservationBuilder::parseTransport(cmd["asset_transport"].as<const char*>(), ObservationBuilder::defaultTransport()));
+
+  // retried batch: the combined reply again, no step runs twice
+  if(ridGiven && cache.lookup(rid, out)==ResultCache::State::Done){
+    MCP_TRACE_EVT(Cached, rid, "batch", 0);
+    return out.doc["ok"]|false;
+  }
+
+  JsonArrayConst steps=cmd["steps"];
+  if(steps.isNull() || steps.size()==0){ out.error("bad_request","steps is required"); return false; }
+  if(steps.size()>BATCH_MAX_STEPS){ out.error("bad_request","too many steps (see batch_max)"); return false; }
+  const bool parallel=strcmp(cmd["mode"]|"sequential","parallel")==0;
+  const bool stopOnError=!parallel && (cmd["stop_on_error"]|true);
+
+  JsonArray res=out.doc["result"].createNestedArray("steps");
+  String text;
+  int8_t outcome[BATCH_MAX_STEPS];   // 1 ok, 0 failed, -1 skipped: survives a compacted reply
+  uint8_t i=0, failed=0;
+  bool stopped=false;
+  const uint32_t t0=micros();
+  for(JsonObjectConst s : steps){
+    const uint8_t n=i++;
+    const char* toolName=s["tool"]|"";
+    JsonObject r=res.createNestedObject();
+    r["tool"]=toolName;   // cmd outlives the reply
+    if(stopped){ r["skipped"]=true; outcome[n]=-1; continue; }
+
+    char sub[48];
+    snprintf(sub, sizeof(sub), "%s/%u", rid, (unsigned)n);
+    JsonVariantConst v=s["args"];
+    JsonObjectConst args=v.isNull() ? JsonObjectConst() : v.as<JsonObjectConst>();
+    ITool* t=find(toolName);
+    bool ok=false;
+
+    if(!t){
+      MCP_TRACE_EVT(NotFound, sub, nullptr, 0);
+      JsonObject er=r.createNestedObject("error");
+      er["code"]="unsupported_tool"; er["message"]="tool not found";
+    } else if(parallel && executor && t->longRunning()
+              && executor->submit(t, args, sub, out.assetTransport(), replyBytes(t))==ToolExecutor::Submit::Queued){
+      MCP_TRACE_EVT(Queued, sub, t->name(), 0);
+      r["queued"]=true;
+      r["request_id"]=sub;   // copied
+      ok=true;
+    } else {
+      ObservationBuilder so(replyBytes(t));
+      so.setRequestId((const char*)sub);
+      so.setAssetTransport(out.assetTransport());
+      uint32_t us=0;
+      ok=invoke(t, args, sub, so, us);
+      r["us"]=us;
+      const char* txt=so.doc["result"]["text"]|"";
+      r["text"]=so.doc["result"]["text"];
+      if(!so.doc["error"].isNull()) r["error"]=so.doc["error"];
+      for(JsonObjectConst a : so.doc["result"]["assets"].as<JsonArrayConst>()){
+        JsonObject d=out.addAsset();
+        d.set(a);
+        d["step"]=n;
+      }
+      if(txt[0]){
+        if(text.length()) text+="\n";
+        text+=t->name(); text+=": "; text+=txt;
+      }
+    }
+    r["ok"]=ok;
+    outcome[n]=ok;
+    if(!ok){ failed++; stopped=stopOnError; }
+  }
+
+  out.doc["ok"]=failed==0;
+  out.doc["result"]["text"]=text;   // String: copied into the doc
+  out.doc["result"]["us"]=micros()-t0;
+  if(failed) out.error("step_failed", stopped ? "a step failed; remaining steps skipped" : "one or more steps failed");
+  MCP_LOGD("REGISTRY", "batch %s: %u steps, %u failed%s", rid, (unsigned)i, (unsigned)failed, stopped ? " (stopped)" : "");
+  if(out.doc.overflowed() || measureMsgPack(out.doc)>RESULT_CACHE_BYTES){
+    // the steps have run: answer (and cache) what can be carried instead of losing the reply
+    MCP_LOGW("REGISTRY", "batch %s: reply too large, sending step summary", rid);
+    const String ridCopy(rid);   // rid may be ridBuf or point into cmd; either way out.reset() drops it
+    out.reset();
+    out.setRequestId(ridCopy);
+    JsonArray sum=out.doc["result"].createNestedArray("steps");
+    uint8_t n=0;
+    for(JsonObjectConst s : steps){
+      JsonObject r=sum.createNestedObject();
+      r["tool"]=s["tool"]|"";
+      if(outcome[n]<0) r["skipped"]=true; else r["ok"]=outcome[n]==1;
+      n++;
+    }
+    out.error("too_large", "batch reply exceeds BATCH_REPLY_BYTES; steps ran, split the batch for their results");
+  }
+  if(ridGiven) cache.store(out);
+  return failed==0;
+}
+
+bool ToolRegistry::dispatch(const JsonDocument& cmd, ObservationBuilder& out){
   const char* type=cmd["type"]|"";
-  if(strcmp(type,"device.command")!=0) return false;
+  if(strcmp(type,"device.cancel")==0) return cancel(cmd, out);
+  if(strcmp(type,"device.command_batch")==0) return batch(cmd, out);
+  if(strcmp(type,"device.command")!=0){ out.suppress(); return false; }
 
-  String toolName=(const char*)(cmd["tool"]|"");
-  String rid=(const char*)(cmd["request_id"]|"");
+  // cmd outlives the reply, so both stay pointers into the parsed doc
+  const char* toolName=cmd["tool"]|"";
+  const char* rid=cmd["request_id"]|"";
 
   JsonVariantConst v = cmd["args"];
   JsonObjectConst args = v.isNull() ? JsonObjectConst() : v.as<JsonObjectConst>();
   
-  // DEBUG: Check args
-  Serial.printf("[REGISTRY] Dispatch tool='%s', args.isNull=%d\n", toolName.c_str(), v.isNull());
-  if (!v.isNull()) {
-    Serial.print("[REGISTRY] args size=");
-    Serial.println(args.size());
-    Serial.print("[REGISTRY] args content: ");
-    serializeJson(args, Serial);
-    Serial.println();
-  }
+#if MCP_LOG_LEVEL >= MCP_LOG_DEBUG
+  MCP_LOGD("REGISTRY", "Dispatch tool='%s', args.isNull=%d, args.size=%u", toolName, v.isNull(), (unsigned)args.size());
+  if (!v.isNull()) { Serial.print("[REGISTRY] args content: "); serializeJson(args, Serial); Serial.println(); }
+#endif
 
-  ITool* target=nullptr;
-  for(auto* t:tools){ if(toolName==t->name()){ target=t; break; } }
+  ITool* target=find(toolName);
 
-  ObservationBuilder ob;
-  ob.setRequestId(rid.length()? rid : String(millis(),HEX));
+  // Per-request asset transport (bridge behind NAT asks for "mqtt")
+  out.setAssetTransport(ObservationBuilder::parseTransport(cmd["asset_transport"].as<const char*>(), ObservationBuilder::defaultTransport()));
+
+  char ridBuf[12];
+  // generated ids are never retried, nor are local commands that opt out ("cache": false, rules)
+  const bool ridGiven=rid[0] && (cmd["cache"]|true);
+  if(!rid[0]){ snprintf(ridBuf, sizeof(ridBuf), "%lx", (unsigned long)millis()); out.setRequestId(String(ridBuf)); rid=ridBuf; }
+  else out.setRequestId(rid);
 
   if(!target){ 
-    Serial.printf("[REGISTRY] Tool '%s' not found\n", toolName.c_str());
-    ob.error("unsupported_tool","tool not found"); 
-    outEventsJson=ob.toJson(); 
+    MCP_LOGW("REGISTRY", "Tool '%s' not found", toolName);
+    MCP_TRACE_EVT(NotFound, rid, nullptr, 0);
+    out.error("unsupported_tool","tool not found"); 
     return false; 
   }
+
+  // Retried command (bridge timeout, QoS1 redelivery): answer without running the tool again
+  switch(ridGiven ? cache.lookup(rid, out) : ResultCache::State::Miss){
+    case ResultCache::State::Done:
+      MCP_LOGD("REGISTRY", "%s: cached result", rid);
+      MCP_TRACE_EVT(Cached, rid, target->name(), 0);
+      return out.doc["ok"]|false;
+    case ResultCache::State::InFlight:
+      // the running job's observation carries this request_id and answers both
+      MCP_LOGD("REGISTRY", "%s: attached to running job", rid);
+      MCP_TRACE_EVT(Attached, rid, target->name(), 0);
+      out.setRequestId(rid);
+      if(cmd["ack"]|true) out.ack("attached", target->name());
+      else out.suppress();
+      return true;
+    case ResultCache::State::Miss:
+      break;
+  }
   
-  Serial.printf("[REGISTRY] Invoking tool '%s'...\n", target->name());
-  bool ok = target->invoke(args, ob);
-  Serial.printf("[REGISTRY] Tool invoke returned: %s\n", ok ? "true" : "false");
-  
-  outEventsJson = ob.toJson();
+  if(executor && target->longRunning()){
+    switch(executor->submit(target, args, rid, out.assetTransport(), replyBytes(target))){
+      case ToolExecutor::Submit::Queued:
+        MCP_LOGD("REGISTRY", "Queued '%s' as job %s", target->name(), rid);
+        MCP_TRACE_EVT(Queued, rid, target->name(), 0);
+        if(ridGiven) cache.markInFlight(rid);
+        if(cmd["ack"]|true) out.ack("queued", target->name());
+        else out.suppress();
+        return true;
+      case ToolExecutor::Submit::Busy:
+        out.error("busy","tool concurrency limit reached"); return false;
+      case ToolExecutor::Submit::Full:
+        out.error("busy","executor queue full"); return false;
+      case ToolExecutor::Submit::Unavailable:
+        break; // fall back to inline invoke
+    }
+  }
+
+  uint32_t us = 0;
+  bool ok = invoke(target, args, rid, out, us);
+  if(ridGiven) cache.store(out);
   return ok;
-}
\ No newline at end of file
+}
+
+bool ToolRegistry::dispatch(const JsonDocument& cmd, String& outEventsJson, const String& /*http_base*/){
+  ObservationBuilder ob;
+  bool ok = dispatch(cmd, ob);
+  outEventsJson = ob.suppressed() ? String() : ob.toJson();
+  return ok;
+}
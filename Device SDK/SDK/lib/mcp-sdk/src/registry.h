@@ -2,14 +2,60 @@
 #include <vector>
 #include <ArduinoJson.h>
 #include "tool.h"
+#include "executor.h"
+#include "result_cache.h"
 
+#ifndef BATCH_MAX_STEPS
+#define BATCH_MAX_STEPS 8                         // steps per device.command_batch
+#endif
+#ifndef BATCH_REPLY_BYTES
+#define BATCH_REPLY_BYTES DOC_POOL_LARGE_BYTES     // combined observation of a batch (pooled large class)
+#endif
+
+// device.command_batch: several tools in one message, one combined observation back
+//   {"type":"device.command_batch","request_id":"b1","mode":"sequential","stop_on_error":true,
+//    "steps":[{"tool":"ExpressEmotion","args":{..}},{"tool":"capture_image","args":{..}}]}
+// - sequential (default): steps run in order on the caller's task (long-running ones too);
+//   stop_on_error (default true) skips the rest after the first failure
+// - parallel: long-running steps go to the executor at once and report later as their own
+//   observations (request_id "<rid>/<step>"); the others run inline, all of them regardless of errors
+// - reply: result.steps[] = {tool, ok, us, text, error | queued+request_id | skipped}, every
+//   step's assets in result.assets tagged "step":<n>, result.text = the step texts joined
+// Each step's tool sees request_id "<rid>/<step>". The batch reply is cached like a command.
+// A reply that outgrows BATCH_REPLY_BYTES or a RESULT_CACHE_BYTES slot is replaced by error
+// "too_large" with result.steps = [{tool, ok | skipped}], cached too, so a retry runs nothing.
 class ToolRegistry{
  public:
-  void add(ITool* t){ tools.push_back(t); }
-  bool initAll(){ bool ok=true; for(auto* t:tools) ok=t->init() && ok; return ok; }
+  void add(ITool* t){ tools.push_back(t); reindex(); }
+  bool initAll();
   String buildAnnounce(const String& device_id, const String& http_base);
+  // Fills `out` with the reply to publish (observation, device.ack, or suppressed); asset URLs are resolved
+  bool dispatch(const JsonDocument& cmd, ObservationBuilder& out);
+  // Legacy: same, serialized to a String
   bool dispatch(const JsonDocument& cmd, String& outEventsJson, const String& http_base);
   const std::vector<ITool*>& list() const { return tools; }
+  // O(1) name lookup (FNV-1a open-addressing index built at registration), no allocation
+  ITool* find(const char* name) const;
+  static uint32_t hashName(const char* s){ uint32_t h=2166136261u; while(*s){ h^=(uint8_t)*s++; h*=16777619u; } return h; }
+  // optional: long-running tools go to this executor; the reply is then a device.ack
+  void setExecutor(ToolExecutor* ex){ executor=ex; }
+  // Feed finished executor jobs back (ToolExecutor::pump sink) so retries of that request_id hit the cache
+  void complete(const ObservationBuilder& ob){ cache.store(ob); }
+  const ResultCache::Stats& cacheStats() const { return cache.stats(); }
+  // Reply doc capacity for a tool: optional "reply_doc_bytes" in its describe(), else the pool default
+  size_t replyBytes(const ITool* t) const;
+  size_t replyBytes(const char* toolName) const { return replyBytes(find(toolName)); }
+  // Reply doc capacity for a parsed command (tool's replyBytes, BATCH_REPLY_BYTES for a batch)
+  size_t replyBytes(const JsonDocument& cmd) const;
  private:
   std::vector<ITool*> tools;
+  ToolExecutor* executor=nullptr;
+  ResultCache cache;         // request_id -> reply, for retried commands
+  std::vector<uint16_t> docBytes;   // per tool (same order as tools), read from describe() in initAll()
+  struct Slot { uint32_t hash; ITool* tool; };
+  std::vector<Slot> index;   // power-of-two sized, >= 2x tools
+  void reindex();
+  bool cancel(const JsonDocument& cmd, ObservationBuilder& out);
+  bool batch(const JsonDocument& cmd, ObservationBuilder& out);
+  bool invoke(ITool* t, JsonObjectConst args, const char* rid, ObservationBuilder& out, uint32_t& us);
 };
\ No newline at end of file
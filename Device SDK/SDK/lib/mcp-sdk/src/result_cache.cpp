@@ -0,0 +1,84 @@
+#include "result_cache.h"
+#include "registry.h"   // ToolRegistry::hashName
+
+bool ResultCache::allocate(){
+  if (_store) return true;
+  const size_t bytes = (size_t)RESULT_CACHE_SLOTS * RESULT_CACHE_BYTES;
+#if defined(ESP32)
+  if (psramFound()) _store = (uint8_t*)ps_malloc(bytes);
+#endif
+  if (!_store) _store = (uint8_t*)malloc(bytes);
+  return _store != nullptr;
+}
+
+ResultCache::Entry* ResultCache::find(const char* rid, uint32_t h){
+  for (auto& e : _slots)
+    if (e.state != State::Miss && e.hash == h && strcmp(e.rid, rid) == 0) return &e;
+  return nullptr;
+}
+
+ResultCache::Entry& ResultCache::claim(const char* rid, uint32_t h){
+  if (Entry* e = find(rid, h)) return *e;
+  // empty slot, else least recently used Done, else least recently used at all
+  Entry* victim = nullptr;
+  for (auto& e : _slots) {
+    if (e.state == State::Miss) { victim = &e; break; }
+    if (!victim || (e.state == State::Done) > (victim->state == State::Done) ||
+        ((e.state == State::Done) == (victim->state == State::Done) && (int32_t)(e.used - victim->used) < 0))
+      victim = &e;
+  }
+  if (victim->state != State::Miss) _stats.evicted++;
+  victim->state = State::Miss;
+  victim->hash = h;
+  victim->len = 0;
+  strlcpy(victim->rid, rid, sizeof(victim->rid));
+  return *victim;
+}
+
+ResultCache::State ResultCache::lookup(const char* rid, ObservationBuilder& out){
+  if (!rid || !rid[0]) return State::Miss;
+  Entry* e = find(rid, ToolRegistry::hashName(rid));
+  if (!e) return State::Miss;
+  e->used = ++_clock;
+  if (e->state == State::InFlight) { _stats.attached++; return State::InFlight; }
+
+  out.reset();
+  // const input: ArduinoJson copies the strings instead of decoding in place (zero-copy would
+  // rewrite the slot and break the next retry of the same request_id)
+  if (deserializeMsgPack(out.doc, (const uint8_t*)data(*e), e->len) != DeserializationError::Ok) {
+    e->state = State::Miss;   // corrupt slot: let the tool run again
+    out.reset();
+    return State::Miss;
+  }
+  out.assets = out.doc["result"]["assets"];
+  _stats.hits++;
+  return State::Done;
+}
+
+void ResultCache::markInFlight(const char* rid){
+  if (!rid || !rid[0]) return;
+  Entry& e = claim(rid, ToolRegistry::hashName(rid));
+  e.state = State::InFlight;
+  e.used = ++_clock;
+}
+
+void ResultCache::store(const ObservationBuilder& ob){
+  const char* rid = ob.doc["request_id"] | "";
+  if (!rid[0] || ob.suppressed()) return;
+  const uint32_t h = ToolRegistry::hashName(rid);
+  if (!allocate() || measureMsgPack(ob.doc) > RESULT_CACHE_BYTES) {
+    _stats.oversize++;
+    forget(rid);              // a stale InFlight would swallow retries forever
+    return;
+  }
+  Entry& e = claim(rid, h);
+  e.len = (uint16_t)serializeMsgPack(ob.doc, data(e), RESULT_CACHE_BYTES);
+  e.state = State::Done;
+  e.used = ++_clock;
+  _stats.stored++;
+}
+
+void ResultCache::forget(const char* rid){
+  if (!rid || !rid[0]) return;
+  if (Entry* e = find(rid, ToolRegistry::hashName(rid))) e->state = State::Miss;
+}
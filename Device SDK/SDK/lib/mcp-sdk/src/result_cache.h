@@ -0,0 +1,58 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "tool.h"
+
+#ifndef RESULT_CACHE_SLOTS
+#define RESULT_CACHE_SLOTS 8         // recent request_ids remembered (> EXEC_MAX_JOBS)
+#endif
+#ifndef RESULT_CACHE_BYTES
+#define RESULT_CACHE_BYTES 2048      // MsgPack-encoded reply per slot (a full batch reply fits)
+#endif
+
+// Recent request_id -> reply, so a retried device.command never runs the tool twice.
+// - InFlight: job queued on the executor; a duplicate attaches (the one result answers both)
+// - Done: serialized reply (asset URLs already resolved), replayed as-is to duplicates
+// LRU eviction, finished entries first; in-flight ones are only evicted when nothing else is left.
+// Replies larger than a slot are not cached (counted as oversize). Tool task only.
+class ResultCache {
+ public:
+  enum class State : uint8_t { Miss, InFlight, Done };
+
+  struct Stats {
+    uint32_t hits = 0;       // answered from cache
+    uint32_t attached = 0;   // duplicate of a running job
+    uint32_t stored = 0;
+    uint32_t evicted = 0;
+    uint32_t oversize = 0;
+  };
+
+  ~ResultCache(){ free(_store); }
+
+  // Done: `out` holds the cached reply. rid empty -> Miss
+  State lookup(const char* rid, ObservationBuilder& out);
+  void markInFlight(const char* rid);
+  void store(const ObservationBuilder& ob);     // keyed by ob.doc["request_id"]
+  void forget(const char* rid);
+
+  const Stats& stats() const { return _stats; }
+
+ private:
+  struct Entry {
+    State state = State::Miss;
+    uint32_t hash = 0;
+    uint32_t used = 0;       // LRU clock
+    uint16_t len = 0;
+    char rid[48] = {0};
+  };
+
+  bool allocate();
+  Entry* find(const char* rid, uint32_t h);
+  Entry& claim(const char* rid, uint32_t h);
+  uint8_t* data(const Entry& e){ return _store + (size_t)(&e - _slots) * RESULT_CACHE_BYTES; }
+
+  Entry _slots[RESULT_CACHE_SLOTS];
+  uint8_t* _store = nullptr;
+  uint32_t _clock = 0;
+  Stats _stats;
+};
@@ -0,0 +1,216 @@
+#include "rule_engine.h"
+#include "registry.h"
+#include "metrics.h"
+#include "mcp_log.h"
+#include "trace.h"
+
+static uint32_t hashOrAny(const char* s){ return s && s[0] ? ToolRegistry::hashName(s) : 0; }
+
+RuleEngine::Op RuleEngine::parseOp(const char* s){
+  if (!s || !s[0])         return Op::Any;
+  if (!strcmp(s, "=="))    return Op::Eq;
+  if (!strcmp(s, "!="))    return Op::Ne;
+  if (!strcmp(s, ">"))     return Op::Gt;
+  if (!strcmp(s, ">="))    return Op::Ge;
+  if (!strcmp(s, "<"))     return Op::Lt;
+  if (!strcmp(s, "<="))    return Op::Le;
+  return (Op)0xFF;
+}
+
+bool RuleEngine::compile(JsonObjectConst src, Rule& r, const char*& err){
+  const char* id = src["id"] | "";
+  if (!id[0] || strlen(id) >= sizeof(r.id)) { err = "id missing or too long"; return false; }
+  strlcpy(r.id, id, sizeof(r.id));
+
+  JsonObjectConst when = src["when"];
+  r.source = hashOrAny(when["source"] | "");
+  r.event = hashOrAny(when["event"] | "");
+  if (!r.source && !r.event) { err = "when needs source or event"; return false; }
+
+  r.op = parseOp(when["op"] | "");
+  if (r.op == (Op)0xFF) { err = "bad op"; return false; }
+  const char* field = when["field"] | "";
+  if (r.op != Op::Any) {
+    if (!field[0] || strlen(field) >= sizeof(r.field)) { err = "field missing or too long"; return false; }
+    JsonVariantConst v = when["value"];
+    r.strVal = v.is<const char*>();
+    if (r.strVal && r.op != Op::Eq && r.op != Op::Ne) { err = "string value needs == or !="; return false; }
+    if (!r.strVal && !v.is<float>()) { err = "value must be a number or string"; return false; }
+    if (r.strVal) r.strHash = ToolRegistry::hashName(v.as<const char*>());
+    else          r.num = v.as<float>();
+  }
+  strlcpy(r.field, field, sizeof(r.field));
+
+  JsonObjectConst act = src["do"];
+  const char* tool = act["tool"] | "";
+  r.target = _reg.find(tool);
+  if (!r.target) { err = "unsupported_tool"; return false; }
+
+  // action stored as the device.command the registry would receive over MQTT
+  DocLease lease(EXEC_ARGS_DOC_SIZE);
+  JsonDocument& cmd = lease.doc();
+  cmd["type"] = "device.command";
+  cmd["tool"] = r.target->name();
+  cmd["ack"] = true;
+  if (!act["args"].isNull()) cmd["args"] = act["args"];
+  if (cmd.overflowed() || measureMsgPack(cmd) > sizeof(r.cmd)) { err = "action too large"; return false; }
+  r.cmdLen = (uint16_t)serializeMsgPack(cmd, r.cmd, sizeof(r.cmd));
+
+  r.cooldown_ms = src["cooldown_ms"] | 0;
+  r.per_min = src["max_per_min"] | 0;
+  if (r.per_min > 600) r.per_min = 600;
+  r.tokens = (uint32_t)r.per_min * 60000u;   // bucket starts full
+  r.refill_ms = 0;
+  r.fired = false;
+  r.fires = r.limited = 0;
+  return true;
+}
+
+int RuleEngine::indexOf(const char* id) const {
+  for (uint8_t i=0; i<_count; i++) if (!strcmp(_rules[i].id, id)) return i;
+  return -1;
+}
+
+void RuleEngine::removeAt(int i){
+  for (uint8_t j=i; j+1<_count; j++) _rules[j] = _rules[j+1];
+  _count--;
+  _head = _tail = 0;   // queued indices may now point at other rules
+}
+
+void RuleEngine::describe(JsonArray out) const {
+  for (uint8_t i=0; i<_count; i++) {
+    JsonObject o = out.createNestedObject();
+    o["id"] = _rules[i].id;
+    o["tool"] = _rules[i].target->name();
+    o["fires"] = _rules[i].fires;
+    o["limited"] = _rules[i].limited;
+  }
+}
+
+bool RuleEngine::load(const JsonDocument& msg, ObservationBuilder& reply){
+  reply.setRequestId(msg["request_id"] | "");
+  JsonObject res = reply.doc["result"].as<JsonObject>();
+  JsonArray errors = res.createNestedArray("errors");
+  bool ok = true;
+
+  for (JsonVariantConst id : msg["remove"].as<JsonArrayConst>()) {
+    int i = indexOf(id | "");
+    if (i >= 0) removeAt(i);
+  }
+
+  JsonArrayConst rules = msg["rules"];
+  if (!rules.isNull()) {
+    if (msg["replace"] | true) { _count = 0; _head = _tail = 0; }
+    for (JsonObjectConst src : rules) {
+      Rule r;
+      const char* err = nullptr;
+      if (compile(src, r, err)) {
+        int i = indexOf(r.id);
+        if (i < 0 && _count >= RULES_MAX) err = "rule table full";
+        else { _rules[i < 0 ? _count++ : i] = r; continue; }
+      }
+      ok = false;
+      JsonObject e = errors.createNestedObject();
+      e["id"] = src["id"] | "";
+      e["error"] = err;
+      MCP_LOGW("RULES", "rule '%s' rejected: %s", src["id"] | "", err);
+    }
+  }
+
+  describe(res.createNestedArray("rules"));
+  char text[32];
+  snprintf(text, sizeof(text), "%u rules active", (unsigned)_count);
+  // String: copied into the doc, the caller serializes reply after text is gone
+  if (ok) reply.success(String(text));
+  else { reply.error("bad_rule", "some rules were rejected"); reply.setText(String(text)); }
+  MCP_LOGI("RULES", "%s%s", text, ok ? "" : " (with errors)");
+  return ok;
+}
+
+// cooldown + token bucket; refill is computed lazily from the last check
+bool RuleEngine::admit(Rule& r, uint32_t now_ms){
+  if (r.fired && r.cooldown_ms && now_ms - r.last_ms < r.cooldown_ms) return false;
+  if (r.per_min) {
+    const uint32_t cap = (uint32_t)r.per_min * 60000u;
+    uint32_t dt = now_ms - r.refill_ms;
+    if (dt > 60000u) dt = 60000u;
+    r.tokens += dt * r.per_min;
+    if (r.tokens > cap) r.tokens = cap;
+    r.refill_ms = now_ms;
+    if (r.tokens < 60000u) return false;
+    r.tokens -= 60000u;
+  }
+  r.fired = true;
+  r.last_ms = now_ms;
+  return true;
+}
+
+bool RuleEngine::matches(const Rule& r, JsonObjectConst asset) const {
+  if (r.event && hashOrAny(asset["event_type"] | "") != r.event) return false;
+  if (r.op == Op::Any) return true;
+  JsonVariantConst v = asset[r.field];
+  if (v.isNull()) return false;
+  if (r.strVal) {
+    const bool eq = v.is<const char*>() && ToolRegistry::hashName(v.as<const char*>()) == r.strHash;
+    return r.op == Op::Eq ? eq : !eq;
+  }
+  if (!v.is<float>()) return false;
+  const float x = v.as<float>();
+  switch (r.op) {
+    case Op::Eq: return x == r.num;
+    case Op::Ne: return x != r.num;
+    case Op::Gt: return x >  r.num;
+    case Op::Ge: return x >= r.num;
+    case Op::Lt: return x <  r.num;
+    case Op::Le: return x <= r.num;
+    default:     return true;
+  }
+}
+
+void RuleEngine::observe(const ObservationBuilder& ev, uint32_t now_ms){
+  if (!_count) return;
+  const uint32_t src = hashOrAny(ev.doc["source"] | "");
+  JsonArrayConst assets = ev.doc["result"]["assets"];
+  for (uint8_t i=0; i<_count; i++) {
+    Rule& r = _rules[i];
+    if (r.source && r.source != src) continue;
+    bool hit = false;
+    for (JsonObjectConst a : assets) if (matches(r, a)) { hit = true; break; }
+    if (!hit) continue;
+    _stats.matched++;
+    if (!admit(r, now_ms)) { r.limited++; _stats.limited++; continue; }
+    if ((uint8_t)(_head - _tail) >= RULES_PENDING) { _stats.dropped++; continue; }
+    _pending[_head++ & (RULES_PENDING - 1)] = i;
+  }
+}
+
+void RuleEngine::run(uint32_t now_ms, const Sink& sink){
+  (void)now_ms;
+  // only what was pending on entry: an action's own emissions fire on the next pass,
+  // so a rule that triggers itself cannot spin here
+  const uint8_t end = _head;
+  while (_tail != end) {
+    Rule& r = _rules[_pending[_tail++ & (RULES_PENDING - 1)]];
+    DocLease lease(EXEC_ARGS_DOC_SIZE);
+    JsonDocument& cmd = lease.doc();
+    // const input: strings are copied into the lease, so the compiled action survives this
+    // firing and the args a queued job copies do not point into r.cmd
+    if (deserializeMsgPack(cmd, (const uint8_t*)r.cmd, r.cmdLen) != DeserializationError::Ok) { _stats.failed++; continue; }
+    char rid[32];
+    snprintf(rid, sizeof(rid), "rule-%s-%lu", r.id, (unsigned long)++_seq);
+    cmd["request_id"] = (const char*)rid;
+    cmd["cache"] = false;   // never retried; keep the result cache for MQTT commands
+
+    ObservationBuilder out(_reg.replyBytes(r.target));
+    const bool ok = _reg.dispatch(cmd, out);
+    r.fires++;
+    _stats.fired++;
+    if (!ok) _stats.failed++;
+    METRIC_COUNT("mcp_rule_fires_total", ok ? "ok" : "fail", 1);
+    MCP_TRACE_EVT(RuleFired, rid, r.target->name(), ok);
+    MCP_LOGD("RULES", "%s -> %s: %s", r.id, r.target->name(), ok ? "ok" : "failed");
+    if (out.suppressed()) continue;
+    out.doc["rule"] = r.id;
+    if (sink) sink(out);
+  }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <functional>
+#include "tool.h"
+
+#ifndef RULES_MAX
+#define RULES_MAX 16               // compiled rules held at once
+#endif
+#ifndef RULES_CMD_BYTES
+#define RULES_CMD_BYTES 160        // MsgPack-encoded action command per rule
+#endif
+#ifndef RULES_PENDING
+#define RULES_PENDING 8            // fired actions waiting for run() (power of two)
+#endif
+
+class ToolRegistry;
+
+// On-device reflexes: "when <event> [field op value] do <tool>(args)" without the
+// device → broker → reflex → broker → device round trip. Loaded by a device.rules message:
+//   {"type":"device.rules","request_id":"..","replace":true,"rules":[
+//     {"id":"hit_angry",
+//      "when":{"source":"PAIN_RECEPTOR_IMPACT","event":"impact","field":"strength","op":">=","value":80},
+//      "do":{"tool":"ExpressEmotion","args":{"mood":"angry"}},
+//      "cooldown_ms":2000,"max_per_min":10}]}
+//   "remove":["id",..] drops rules; a message without "rules"/"remove" just lists them.
+// - rules are compiled on load: source/event become FNV hashes, the target tool is
+//   resolved once and the action is stored as a ready device.command (MsgPack)
+// - observe() sees every observation a tool emits ("source" + each asset's "event_type"
+//   and numeric/string field) and only queues matching actions; run() dispatches them
+//   through ToolRegistry, so executor routing, metrics and traces apply as for MQTT commands
+// - each rule has a cooldown and a per-minute token bucket; a full pending queue drops
+// - results are reported asynchronously as regular observations tagged "rule":<id>
+// Rules live in RAM; the sender re-sends them after a device.announce. Tool task only.
+class RuleEngine {
+ public:
+  using Sink = std::function<void(const ObservationBuilder&)>;
+  enum class Op : uint8_t { Any, Eq, Ne, Gt, Ge, Lt, Le };
+
+  struct Stats { uint32_t matched = 0, fired = 0, limited = 0, dropped = 0, failed = 0; };
+
+  explicit RuleEngine(ToolRegistry& reg) : _reg(reg) {}
+
+  // device.rules: compile/replace/remove, reply lists the table with per-rule status
+  bool load(const JsonDocument& msg, ObservationBuilder& reply);
+  void observe(const ObservationBuilder& ev, uint32_t now_ms);
+  void run(uint32_t now_ms, const Sink& sink);   // dispatch queued actions
+
+  size_t count() const { return _count; }
+  bool pending() const { return _tail != _head; }
+  const Stats& stats() const { return _stats; }
+
+  static Op parseOp(const char* s);
+
+ private:
+  struct Rule {
+    char id[16] = {0};
+    uint32_t source = 0;          // hash of the emitting tool's name, 0 = any
+    uint32_t event = 0;           // hash of asset event_type, 0 = any
+    char field[16] = {0};         // asset member compared with value (empty = no condition)
+    Op op = Op::Any;
+    bool strVal = false;
+    float num = 0;
+    uint32_t strHash = 0;
+    ITool* target = nullptr;
+    uint16_t cmdLen = 0;
+    uint8_t cmd[RULES_CMD_BYTES];
+    uint32_t cooldown_ms = 0;
+    uint16_t per_min = 0;         // 0 = no bucket
+    uint32_t tokens = 0;          // per_min bucket, in 1/60000 of a token
+    uint32_t refill_ms = 0;
+    uint32_t last_ms = 0;
+    uint32_t fires = 0, limited = 0;
+    bool fired = false;
+  };
+
+  bool compile(JsonObjectConst src, Rule& r, const char*& err);
+  bool admit(Rule& r, uint32_t now_ms);
+  bool matches(const Rule& r, JsonObjectConst asset) const;
+  int indexOf(const char* id) const;
+  void removeAt(int i);
+  void describe(JsonArray out) const;
+
+  ToolRegistry& _reg;
+  Rule _rules[RULES_MAX];
+  uint8_t _count = 0;
+  uint8_t _pending[RULES_PENDING];
+  uint8_t _head = 0, _tail = 0;   // ring of rule indices
+  uint32_t _seq = 0;              // request_id suffix of fired actions
+  Stats _stats;
+};
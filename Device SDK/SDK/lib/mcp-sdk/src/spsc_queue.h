@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Lock-free single-producer / single-consumer ring of N fixed slots (N power of two).
+// Slots are filled and read in place, so large payloads cross tasks/cores without a copy:
+//   producer:  if (T* s = q.beginPush()) { ...fill *s...; q.commitPush(); }
+//   consumer:  while (T* s = q.front()) { ...use *s...; q.pop(); }
+// Exactly one task may push and exactly one may pop; acquire/release on the indices
+// publishes the slot contents across cores.
+template <typename T, size_t N>
+class SpscQueue {
+  static_assert(N && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+ public:
+  T* beginPush(){
+    const uint32_t h = _head.load(std::memory_order_relaxed);
+    if (h - _tail.load(std::memory_order_acquire) >= N) return nullptr;   // full
+    return &_slots[h & (N - 1)];
+  }
+  void commitPush(){ _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  T* front(){
+    const uint32_t t = _tail.load(std::memory_order_relaxed);
+    if (t == _head.load(std::memory_order_acquire)) return nullptr;        // empty
+    return &_slots[t & (N - 1)];
+  }
+  void pop(){ _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  size_t size() const { return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity(){ return N; }
+
+ private:
+  T _slots[N];
+  std::atomic<uint32_t> _head{0};   // written by producer only
+  std::atomic<uint32_t> _tail{0};   // written by consumer only
+};
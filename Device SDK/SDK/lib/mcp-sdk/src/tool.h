@@ -1,32 +1,128 @@
 #pragma once
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include "asset_source.h"
+#include "doc_pool.h"
 
 // REPLACE WHOLE ObservationBuilder WITH THIS
 struct ObservationBuilder {
-  StaticJsonDocument<2048> doc;
+ private:
+  DocLease lease_;           // pooled (DocPool), so builders cost no stack
+ public:
+  JsonDocument& doc;
   JsonArray assets;
-  ObservationBuilder(){
+  // Emitter hint (not serialized): Urgent skips batching windows, Latest lets a newer
+  // event of the same source/event_type replace a pending one
+  enum class Delivery : uint8_t { Normal, Urgent, Latest };
+  // How binary assets reach the receiver: URL on the device's WebServer, or pushed as
+  // MQTT chunks (see asset_source.h) for bridges that cannot reach the device over HTTP
+  enum class AssetTransport : uint8_t { Http, Mqtt };
+
+  // bytes: capacity needed (a tool's "reply_doc_bytes", see ToolRegistry::replyBytes)
+  explicit ObservationBuilder(size_t bytes = DOC_POOL_LARGE_BYTES) : lease_(bytes), doc(lease_.doc()) { reset(); }
+  // Not copyable: `assets` points into this doc
+  ObservationBuilder(const ObservationBuilder&) = delete;
+  ObservationBuilder& operator=(const ObservationBuilder&) = delete;
+
+  void reset(){
+    doc.clear();
     doc["type"] = "device.observation";
     doc["ok"] = false;
     JsonObject res = doc.createNestedObject("result");
     res["text"] = "";                         // bridge expects this
     assets = res.createNestedArray("assets"); // and this
+    suppressed_ = false;
+    delivery_ = Delivery::Normal;
+    transport_ = defaultTransport();
+  }
+  // Device-wide default; a command may override it per request ("asset_transport")
+  static AssetTransport& defaultTransport(){ static AssetTransport t = AssetTransport::Http; return t; }
+  void setAssetTransport(AssetTransport t){ transport_=t; }
+  AssetTransport assetTransport() const { return transport_; }
+  static AssetTransport parseTransport(const char* s, AssetTransport def){
+    if (!s) return def;
+    if (strcmp(s, "mqtt")==0) return AssetTransport::Mqtt;
+    if (strcmp(s, "http")==0) return AssetTransport::Http;
+    return def;
   }
+  void setDelivery(Delivery d){ delivery_=d; }
+  Delivery delivery() const { return delivery_; }
   void setRequestId(const String& rid){ doc["request_id"]=rid; }
+  // No-copy variant: rid must outlive the builder (e.g. points into the cmd doc)
+  void setRequestId(const char* rid){ doc["request_id"]=rid; }
   void error(const char* code,const char* msg){
     doc["ok"]=false;
     JsonObject er=doc.createNestedObject("error");
     er["code"]=code; er["message"]=msg;
   }
+  // const char* is linked, not copied: literals only. Built text (String, stack buffer) must
+  // go through the String overloads, the doc is serialized after invoke() has returned
   void setText(const char* text){ doc["result"]["text"]=text; }
+  void setText(const String& text){ doc["result"]["text"]=text; }
   JsonObject addAsset(){ return assets.createNestedObject(); }
+
+  // Base for relative asset URLs ("/last.jpg?rid=.." -> "http://<ip>/last.jpg?rid=.."), set once the IP is known
+  static String& httpBase(){ static String base; return base; }
+  static void setHttpBase(const String& base){ httpBase()=base; }
+  // Resolve at build time so the doc can be serialized once, straight to the transport
+  void setAssetUrl(JsonObject a, const String& path) const {
+    if (path.startsWith("/")) a["url"] = httpBase() + path; else a["url"] = path;
+  }
+  // Binary asset whose bytes the tool can hand out by asset_id (an IAssetSource):
+  // Http → url from path; Mqtt → no url, chunk/digest metadata for the receiver
+  void setAssetData(JsonObject a, const String& path, const uint8_t* data, size_t len) const {
+    if (transport_ != AssetTransport::Mqtt) { setAssetUrl(a, path); return; }
+    a["transport"] = "mqtt";
+    a["size"] = len;
+    a["chunk_bytes"] = ASSET_CHUNK_BYTES;
+    a["chunks"] = (len + ASSET_CHUNK_BYTES - 1) / ASSET_CHUNK_BYTES;
+    char hex[65];
+    if (AssetSources::sha256Hex(data, len, hex)) a["sha256"] = hex;
+  }
+  // Fallback for tools that still write relative "url"s themselves: patched in place, no reparse
+  void resolveUrls(){
+    if (assets.isNull()) return;
+    for (JsonObject a : assets) {
+      const char* url = a["url"] | nullptr;
+      if (url && url[0]=='/') a["url"] = httpBase() + url;
+    }
+  }
+
+  // Turn this reply into a device.ack (job queued / cancelling); the observation follows later
+  void ack(const char* status, const char* tool=nullptr){
+    String rid = doc["request_id"] | "";
+    doc.clear();
+    doc["type"]="device.ack";
+    doc["request_id"]=rid;
+    if (tool) doc["tool"]=tool;
+    doc["status"]=status;
+    assets = JsonArray();
+  }
+  // Nothing to publish for this command (e.g. queued with "ack": false)
+  void suppress(){ suppressed_=true; }
+  bool suppressed() const { return suppressed_; }
+
   void success(const char* text){ doc["ok"]=true; setText(text); }
+  void success(const String& text){ doc["ok"]=true; setText(text); }
   String toJson() const { String s; serializeJson(doc,s); return s; }
+
+  // Cooperative cancellation (set by ToolExecutor for long-running jobs).
+  // Long tools should poll cancelled() inside their wait loops and bail out early.
+  void bindCancel(const volatile bool* flag){ cancel_=flag; }
+  bool cancelled() const { return cancel_ && *cancel_; }
+ private:
+  const volatile bool* cancel_ = nullptr;
+  bool suppressed_ = false;
+  Delivery delivery_ = Delivery::Normal;
+  AssetTransport transport_ = AssetTransport::Http;
 };
 
 class WebServer;
 
+#ifndef TICK_IDLE
+#define TICK_IDLE 0xFFFFFFFFu   // nextTickMs(): nothing scheduled until the tool is poked (command)
+#endif
+
 struct ITool{
   virtual ~ITool(){}
   virtual bool init()=0;
@@ -36,4 +132,12 @@ struct ITool{
   // optional, default no-op
   virtual void register_http(WebServer& srv) {}
   virtual void tick(uint32_t /*now_ms*/) {}
+  // optional: when tick() next needs to run (millis), or TICK_IDLE. Default = never, so a tool
+  // without periodic work costs nothing; a legacy polling tool opts in with `return now_ms;`.
+  virtual uint32_t nextTickMs(uint32_t /*now_ms*/) { return TICK_IDLE; }
+  // optional: run invoke() on the ToolExecutor worker instead of the MQTT callback.
+  // Long-running tools get an immediate device.ack and report the final observation via the emitter.
+  virtual bool longRunning() const { return false; }
+  // optional: max queued+running jobs of this tool on the executor (0 = unlimited)
+  virtual uint8_t maxConcurrency() const { return 1; }
 };
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include "registry.h"
+
+// Compile-time tool set kept in static storage (no `new` per tool).
+// Tools are constructed in place from the ctor args (one per tool, in order) and
+// registered in declaration order; lookup then goes through ToolRegistry's hash index.
+//
+//   static ToolTable<ExpressEmotionTool, ExampleDigitalEvent> table(ExpressEmotionTool(), 0);
+//   table.registerAll(reg);
+template<class... Tools>
+class ToolTable {
+ public:
+  static constexpr size_t count = sizeof...(Tools);
+
+  ToolTable() = default;
+  template<class... Args>
+  explicit ToolTable(Args&&... args) : _tools(std::forward<Args>(args)...) {}
+
+  void registerAll(ToolRegistry& reg){ _add(reg, std::integral_constant<size_t, 0>()); }
+
+  template<size_t I>
+  typename std::tuple_element<I, std::tuple<Tools...>>::type& get(){ return std::get<I>(_tools); }
+
+ private:
+  std::tuple<Tools...> _tools;
+
+  void _add(ToolRegistry&, std::integral_constant<size_t, count>) {}
+  template<size_t I>
+  void _add(ToolRegistry& reg, std::integral_constant<size_t, I>){
+    reg.add(&std::get<I>(_tools));
+    _add(reg, std::integral_constant<size_t, I + 1>());
+  }
+};
@@ -0,0 +1,69 @@
+#include "trace.h"
+
+static const char* const kStageNames[(size_t)Trace::Stage::Count] = {
+  "cmd_rx", "cmd_drop", "parsed", "parse_error", "not_found", "cached", "attached",
+  "queued", "invoke_end", "invoke_error", "job_end", "obs_drop", "published", "publish_fail",
+  "rule_fired" };
+
+const char* Trace::stageName(Stage s){
+  return s < Stage::Count ? kStageNames[(size_t)s] : "?";
+}
+
+void Trace::record(Stage s, const char* rid, const char* tag, uint32_t value){
+  const uint32_t n = _next.fetch_add(1, std::memory_order_relaxed);
+  Event& e = _ring[n & (TRACE_SLOTS - 1)];
+  e.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  e.t_us = micros();
+  e.value = value;
+  e.tag = tag;
+  e.stage = s;
+#if defined(ESP32)
+  e.core = (uint8_t)xPortGetCoreID();
+#else
+  e.core = 0;
+#endif
+  strlcpy(e.rid, rid ? rid : "", sizeof(e.rid));
+  e.seq.store(n + 1, std::memory_order_release);
+}
+
+// rid comes off the wire; tag is a literal or tool name
+static void printJsonString(Print& out, const char* s){
+  out.print('"');
+  for (; s && *s; s++) {
+    char c = *s;
+    if (c == '"' || c == '\\') { out.print('\\'); out.print(c); }
+    else if ((uint8_t)c < 0x20) out.print('?');
+    else out.print(c);
+  }
+  out.print('"');
+}
+
+void Trace::dump(Print& out, uint32_t since) const {
+  const uint32_t end = _next.load(std::memory_order_acquire);
+  uint32_t first = end > TRACE_SLOTS ? end - TRACE_SLOTS : 0;
+  if (since > first + 1) first = since - 1;
+  out.printf("{\"now_us\":%u,\"next\":%u,\"events\":[", (unsigned)micros(), (unsigned)(end + 1));
+  bool comma = false;
+  for (uint32_t n = first; n < end; n++) {
+    const Event& e = _ring[n & (TRACE_SLOTS - 1)];
+    if (e.seq.load(std::memory_order_acquire) != n + 1) continue;   // overwritten or in progress
+    uint32_t t_us = e.t_us, value = e.value;
+    const char* tag = e.tag;
+    Stage stage = e.stage;
+    uint8_t core = e.core;
+    char rid[TRACE_RID_LEN];
+    memcpy(rid, e.rid, sizeof(rid));
+    rid[sizeof(rid) - 1] = 0;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (e.seq.load(std::memory_order_relaxed) != n + 1) continue;   // torn read
+    out.printf("%s[%u,%u,%u,\"%s\",", comma ? "," : "", (unsigned)(n + 1), (unsigned)t_us,
+               (unsigned)core, stageName(stage));
+    printJsonString(out, rid);
+    out.print(',');
+    printJsonString(out, tag);
+    out.printf(",%u]", (unsigned)value);
+    comma = true;
+  }
+  out.print("]}");
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+#ifndef MCP_TRACE
+#define MCP_TRACE 1                // 0 = all MCP_TRACE_EVT calls compile away, /trace not registered
+#endif
+#ifndef TRACE_SLOTS
+#define TRACE_SLOTS 64             // power of two; oldest events are overwritten
+#endif
+#ifndef TRACE_RID_LEN
+#define TRACE_RID_LEN 16           // request_id prefix kept per event
+#endif
+
+// Lock-free in-RAM ring of structured trace events: one fixed slot per event (stage,
+// microsecond timestamp, core, request_id, tag, value), no formatting on the hot path.
+// Any task may record; slots are claimed with one atomic increment and sealed with a
+// sequence number, so dump() skips a slot that is being overwritten instead of locking.
+//   MCP_TRACE_EVT(Parsed, rid, toolName, bytes);
+// tag must outlive the firmware (string literal or tool name). dump() writes JSON:
+//   {"now_us":..,"next":..,"events":[[seq,t_us,core,"stage","rid","tag",value],...]}
+class Trace {
+ public:
+  enum class Stage : uint8_t {
+    CmdRx,        // network: payload arrived (value = bytes)
+    CmdDrop,      // network: command queue full / payload too large
+    Parsed,       // tool task: command decoded (value = bytes)
+    ParseError,
+    NotFound,     // unknown tool
+    Cached,       // answered from the result cache
+    Attached,     // retry joined a running job
+    Queued,       // handed to the executor
+    InvokeEnd,    // inline invoke returned ok (value = us)
+    InvokeError,  // inline invoke returned false (value = us)
+    JobEnd,       // executor job finished (value = us)
+    ObsDrop,      // observation queue full / too large
+    Published,    // network: reply on the wire (value = bytes)
+    PublishFail,  // network: publish failed (reply went to the outbox)
+    RuleFired,    // rule action dispatched (value = ok)
+    Count
+  };
+
+  static Trace& instance(){ static Trace t; return t; }
+
+  void record(Stage s, const char* rid, const char* tag, uint32_t value);
+  void dump(Print& out, uint32_t since = 0) const;   // events with seq >= since
+  uint32_t next() const { return _next.load(std::memory_order_relaxed) + 1; }
+  static const char* stageName(Stage s);
+
+ private:
+  static_assert(TRACE_SLOTS && (TRACE_SLOTS & (TRACE_SLOTS - 1)) == 0, "TRACE_SLOTS must be a power of two");
+  struct Event {
+    std::atomic<uint32_t> seq{0};   // 0 = empty or being written
+    uint32_t t_us;
+    uint32_t value;
+    const char* tag;
+    Stage stage;
+    uint8_t core;
+    char rid[TRACE_RID_LEN];
+  };
+  Trace() {}
+
+  Event _ring[TRACE_SLOTS];
+  std::atomic<uint32_t> _next{0};
+};
+
+#if MCP_TRACE
+  #define MCP_TRACE_EVT(stage, rid, tag, value) Trace::instance().record(Trace::Stage::stage, (rid), (tag), (value))
+#else
+  #define MCP_TRACE_EVT(stage, rid, tag, value) do {} while (0)
+#endif
@@ -0,0 +1,82 @@
+#pragma once
+// Generated by web/embed_page.py from web/provision.html -- do not edit by hand
+#include <Arduino.h>
+
+// 2395 bytes of HTML, gzip -9
+static const size_t PROVISION_PAGE_GZ_LEN = 1169;
+static const uint8_t PROVISION_PAGE_GZ[] PROGMEM = {
+  0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0x75,0x56,0x6d,0x6f,0xe2,0x38,
+  0x10,0xfe,0xce,0xaf,0xf0,0x72,0xba,0x75,0xa2,0x42,0x20,0x54,0xa0,0x1e,0x24,0xa9,
+  0xb4,0xed,0xee,0xb6,0xd2,0xb6,0xc7,0x2d,0x48,0xf7,0xe5,0xa4,0xca,0xc4,0x06,0xbc,
+  0x4d,0xec,0x6c,0xec,0xd0,0x72,0x88,0xff,0x7e,0x63,0x3b,0xbc,0x1e,0xfb,0xa1,0x8d,
+  0x5f,0xc6,0xcf,0x3c,0x33,0x9e,0x67,0x4c,0xf4,0x81,0xca,0x54,0xaf,0x0b,0x86,0x96,
+  0x3a,0xcf,0x92,0xa8,0xfe,0xcf,0x08,0x4d,0xa2,0x9c,0x69,0x82,0xd2,0x25,0x29,0x15,
+  0xd3,0x31,0xae,0xf4,0xbc,0x7d,0x83,0xeb,0x55,0x41,0x72,0x16,0xe3,0x15,0x67,0x6f,
+  0x85,0x2c,0x35,0x46,0xa9,0x14,0x9a,0x09,0xb0,0x7a,0xe3,0x54,0x2f,0x63,0xca,0x56,
+  0x3c,0x65,0x6d,0x3b,0x69,0x71,0xc1,0x35,0x27,0x59,0x5b,0xa5,0x24,0x63,0x71,0x08,
+  0x10,0x9a,0xeb,0x8c,0x25,0x4f,0x77,0xe3,0xf6,0x37,0xae,0x19,0x9a,0x30,0x5d,0x15,
+  0x51,0xc7,0xad,0x36,0x22,0xa5,0xd7,0xf0,0x9d,0x49,0xba,0xde,0xcc,0x01,0xb6,0x3d,
+  0x27,0x39,0xcf,0xd6,0x43,0x45,0x84,0x6a,0x2b,0x56,0xf2,0xf9,0x28,0x27,0xef,0x0e,
+  0x7b,0xd8,0x1f,0x74,0x8b,0x77,0x98,0x97,0x0b,0x2e,0x86,0x3d,0x18,0x23,0x52,0x69,
+  0x39,0x2a,0x08,0xa5,0x5c,0x2c,0x86,0x5d,0x14,0xf6,0x8a,0xf7,0x6d,0x46,0x66,0x2c,
+  0xdb,0x50,0xae,0x8a,0x8c,0xac,0x87,0xb3,0x4c,0xa6,0xaf,0xbb,0x33,0xc1,0xa0,0x64,
+  0x39,0xea,0xa2,0xa0,0x07,0xdf,0x2d,0x17,0x45,0xa5,0x5b,0x8a,0x65,0x2c,0xd5,0x1b,
+  0xe7,0x21,0xec,0x76,0x7f,0xdf,0xe3,0x59,0xeb,0x91,0x65,0xa5,0xf8,0xbf,0x6c,0x18,
+  0x9a,0x43,0xb3,0x4a,0x6b,0x29,0x36,0x27,0x36,0xc8,0xec,0xd4,0x3e,0xda,0x5a,0x16,
+  0xce,0x52,0xe5,0x24,0xcb,0x36,0xa9,0xcc,0x64,0x39,0xfc,0x6d,0x30,0x18,0x6c,0xa3,
+  0x8e,0x0b,0x36,0xea,0xd8,0x8c,0x37,0x22,0x13,0x35,0xa4,0xbf,0x97,0x8c,0x4b,0xb9,
+  0xe2,0x8a,0x4b,0x01,0x90,0xb0,0xdb,0x83,0x3d,0x0a,0x89,0xe7,0x99,0x42,0xb2,0x60,
+  0x22,0x89,0x54,0x95,0x03,0xfc,0x3a,0x99,0xa4,0x44,0xa0,0xbf,0x79,0xfb,0x0b,0x07,
+  0xb0,0x7a,0x2d,0xb2,0x01,0x27,0x93,0xc9,0xe3,0x7d,0xd4,0x71,0xe3,0xc8,0x05,0x85,
+  0x38,0x8d,0xb1,0x52,0x9c,0x62,0x24,0x05,0x5c,0xad,0x58,0xb0,0xb8,0x69,0xe6,0x53,
+  0xf6,0xae,0x83,0x15,0xc9,0x2a,0x16,0xeb,0x25,0x57,0x6e,0xd8,0x4c,0x22,0x59,0x68,
+  0x20,0x81,0xdc,0x0e,0xc6,0xd6,0x9d,0xe1,0x14,0x04,0x41,0xd4,0x71,0x9b,0xc0,0xde,
+  0x81,0x1b,0xfe,0x36,0x17,0xc8,0x14,0x54,0x8c,0xdd,0xc4,0x7a,0xca,0x78,0xfa,0x1a,
+  0xe3,0x4c,0x12,0xea,0x85,0x3e,0x4e,0xbe,0x33,0x28,0x06,0x11,0x75,0x9c,0x45,0x82,
+  0x22,0x9b,0x19,0x4b,0x8e,0x2c,0x18,0x36,0x88,0x66,0x01,0xbe,0x75,0xd0,0x00,0x3d,
+  0x97,0x65,0x8e,0xa0,0xf8,0x96,0x12,0xac,0xc6,0x7f,0x4e,0xa6,0x18,0x91,0xd4,0xf8,
+  0x8f,0x71,0x47,0x91,0x15,0x9c,0x6a,0xd4,0x71,0xdb,0x6c,0xa0,0x93,0xe8,0xed,0xc5,
+  0xee,0x83,0x37,0xc1,0xe2,0xba,0x86,0xdf,0xf8,0x9c,0xbf,0xb8,0x8c,0x94,0xec,0x67,
+  0xc5,0x4b,0x46,0xcf,0x80,0xc6,0x44,0xa9,0x37,0x59,0xd2,0x33,0xb0,0xa3,0xe3,0x05,
+  0x58,0xe0,0x3a,0xe8,0xa2,0xb6,0x3e,0xd0,0x79,0xfa,0x6b,0x3a,0x45,0x0f,0x52,0x69,
+  0xe4,0x3d,0x8e,0xfd,0x8b,0x28,0xf9,0x4f,0xad,0x5f,0x96,0x60,0x82,0x77,0x99,0x0e,
+  0xff,0xe8,0x05,0xe1,0xe0,0x26,0xe8,0x06,0x50,0x80,0x17,0xa8,0x59,0xd0,0x31,0x68,
+  0xef,0xd7,0x78,0x4e,0x99,0x8e,0x95,0xa8,0xf2,0x19,0x2b,0x0f,0xe8,0x37,0x37,0xd7,
+  0x18,0xe5,0x1c,0x72,0x17,0xc2,0x97,0xbc,0xc7,0x78,0xd0,0xef,0x5f,0xf7,0x2f,0x38,
+  0xba,0xb7,0x52,0x46,0x17,0x73,0x49,0x4d,0xd6,0x9c,0x47,0xa7,0xf8,0x97,0xb3,0x34,
+  0xee,0x6e,0xef,0x50,0xad,0x9a,0x68,0x9e,0xa2,0xc7,0x31,0xf2,0x5c,0xf1,0x90,0xac,
+  0x85,0x58,0x5e,0xe8,0x35,0x8a,0xd1,0xfd,0xc3,0x9d,0xc9,0xcf,0xce,0x76,0xc7,0xe0,
+  0x71,0x7c,0x31,0x46,0x65,0xa1,0x5e,0x78,0x81,0x11,0xc8,0x3a,0x65,0x4b,0x99,0x51,
+  0x56,0x1e,0x67,0xae,0xdf,0x3d,0x5c,0xc2,0x57,0xa2,0xd9,0x1b,0x59,0x5f,0x44,0x5a,
+  0xb8,0xbd,0x5f,0xe2,0x84,0x07,0x98,0x67,0xa6,0x73,0xa2,0x5e,0x2f,0xc2,0x08,0xb7,
+  0x77,0x06,0xd3,0xeb,0xf7,0x83,0xdd,0xdf,0x11,0x9f,0xfb,0xe7,0xc9,0x45,0x10,0x2a,
+  0xd4,0x19,0xc0,0x8e,0xdd,0x89,0x18,0x4e,0x74,0xa6,0xaa,0x59,0xce,0x35,0x68,0x13,
+  0x54,0x80,0x3e,0xa2,0xef,0x6c,0x26,0xa5,0xde,0x8b,0xab,0x11,0x75,0x8c,0x74,0xa0,
+  0xab,0x94,0x49,0x54,0x24,0x4e,0x6a,0xa6,0xbf,0xfc,0x30,0xfd,0x40,0x91,0x19,0x39,
+  0xa8,0xad,0x30,0xed,0x37,0x2d,0x79,0x01,0x5a,0x9e,0x57,0xc2,0xca,0x0b,0x59,0xd5,
+  0x96,0x56,0xb1,0xfe,0xa6,0x81,0xd0,0x9c,0xe9,0x74,0xe9,0xe1,0x0e,0xc4,0x0b,0x85,
+  0xfe,0xaa,0x82,0x1f,0x0a,0x54,0x7e,0x55,0x9b,0xdc,0xe2,0x5b,0x37,0x80,0x4e,0x3f,
+  0xc4,0xd8,0xf7,0x03,0xbd,0x64,0xc2,0x2b,0xe3,0xa4,0xb4,0x86,0xde,0x6e,0x85,0xc6,
+  0x89,0x41,0x43,0x88,0xcf,0xbd,0x0f,0x50,0x49,0xae,0xe5,0xf8,0x68,0x3f,0x8c,0x69,
+  0xb0,0xaf,0xaa,0x91,0xb5,0x5c,0x91,0x12,0xa9,0x18,0x1e,0xac,0x2a,0x87,0xc7,0x26,
+  0x58,0x30,0xfd,0x39,0x63,0x66,0xf8,0x69,0xfd,0x48,0x3d,0xd7,0xd7,0xfc,0x56,0x5a,
+  0x95,0x71,0xdd,0xc0,0xdc,0x31,0x15,0x70,0x21,0x58,0xf9,0x30,0x7d,0xfa,0x06,0x2d,
+  0xcc,0xad,0xd1,0x60,0x4f,0x1f,0xb2,0xf3,0x99,0x40,0x44,0x02,0x08,0x19,0x0f,0xf2,
+  0xe0,0x21,0x2d,0x19,0x64,0xbf,0x76,0xe2,0x61,0x57,0xb2,0xd8,0x1f,0xc9,0x9a,0xa1,
+  0x08,0x8c,0x4f,0x87,0x88,0x90,0x0c,0x34,0x34,0x96,0xbb,0xfa,0x29,0x74,0x7b,0x57,
+  0x18,0x79,0xf8,0x4a,0x04,0x25,0x4c,0x60,0x4c,0x3f,0xe5,0x2d,0x04,0xb9,0x82,0x4d,
+  0x06,0x3c,0xd9,0x2d,0xfe,0xa7,0xda,0x84,0x5f,0xfa,0x61,0x6f,0x0b,0xd9,0xaa,0xc7,
+  0xd7,0x5b,0xec,0x5f,0x61,0x1f,0x8f,0x54,0x40,0x0a,0x68,0xf6,0xf4,0x6e,0xc9,0x33,
+  0xea,0x49,0x7f,0xb4,0xf5,0x47,0x87,0x94,0x1d,0x22,0xc8,0x98,0x58,0xe8,0xa5,0x7f,
+  0x12,0x68,0xf3,0x7f,0xad,0xbb,0x79,0xe5,0xd1,0x40,0xd5,0xfd,0xfb,0x16,0x1f,0x75,
+  0x72,0x70,0xfd,0x2c,0xd1,0x0e,0x0e,0xcd,0x65,0x25,0x28,0xda,0x5d,0x39,0x70,0x69,
+  0xee,0x5b,0x7d,0x73,0xef,0x1f,0xd8,0x1b,0x87,0x0e,0x1d,0x26,0x07,0x62,0xa7,0xcf,
+  0x09,0xfa,0xf8,0x71,0x67,0x06,0xf6,0xa7,0x2f,0xcd,0xc9,0x2d,0x41,0xe3,0x3f,0xc9,
+  0xdf,0x31,0x57,0x75,0xcc,0x15,0xa2,0x00,0xdb,0x97,0x5c,0x25,0x71,0xf7,0xf6,0x89,
+  0xe8,0x65,0x50,0x1a,0xc2,0xfb,0xe5,0x0e,0x74,0xcc,0x2e,0x24,0x50,0x01,0xa4,0xb4,
+  0x35,0xb8,0xe7,0x76,0xc0,0x04,0x2e,0x4c,0x4f,0x79,0xce,0x64,0xa5,0x3d,0x53,0xe1,
+  0xad,0xb0,0x0f,0xa7,0x8c,0xe5,0xd6,0x0f,0x52,0x62,0x4a,0xdc,0xf3,0xe3,0xe4,0xdc,
+  0xea,0xda,0x60,0x83,0xd9,0xb6,0x61,0x65,0x61,0x4e,0x80,0x7c,0x9c,0x64,0x40,0x72,
+  0xf6,0xf9,0xee,0xd8,0x1f,0x51,0x8d,0xff,0x00,0xd7,0x7c,0x48,0x98,0x5b,0x09,0x00,
+  0x00,
+};
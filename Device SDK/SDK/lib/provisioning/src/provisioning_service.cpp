@@ -1,5 +1,30 @@
 
 #include "provisioning_service.h"
+#include <algorithm>
+#include "provision_page.h"
+#if defined(ESP32)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/event_groups.h"
+#endif
+
+// Wi-Fi STA events → bits, so connect waits block on the event instead of polling
+#if defined(ESP32)
+static EventGroupHandle_t s_wifiEvents = nullptr;
+static const EventBits_t EV_GOT_IP = BIT0;
+static volatile uint32_t s_assocMs = 0;   // STA associated (before DHCP)
+
+static void wifiEventsInit(){
+  if (s_wifiEvents) return;
+  s_wifiEvents = xEventGroupCreate();
+  WiFi.onEvent([](WiFiEvent_t ev, WiFiEventInfo_t){
+    switch(ev){
+      case ARDUINO_EVENT_WIFI_STA_CONNECTED: s_assocMs = millis(); break;
+      case ARDUINO_EVENT_WIFI_STA_GOT_IP:    xEventGroupSetBits(s_wifiEvents, EV_GOT_IP); break;
+      default: break;
+    }
+  });
+}
+#endif
 
 ProvisioningService::ProvisioningService(WebServer& server, DNSServer& dns, Preferences& prefs)
 : _srv(server), _dns(dns), _prefs(prefs) {}
@@ -11,6 +36,17 @@ void ProvisioningService::load(McpConfig& cfg){
   if (_prefs.isKey("mqtt_host"))  cfg.mqtt_host = _prefs.getString("mqtt_host");
   cfg.mqtt_port = _prefs.isKey("mqtt_port") ? _prefs.getUShort("mqtt_port") : 1883;
   if (_prefs.isKey("device_id"))  cfg.device_id = _prefs.getString("device_id");
+  if (_prefs.isKey("static_ip"))  cfg.static_ip = _prefs.getString("static_ip");
+  if (_prefs.isKey("gateway"))    cfg.gateway = _prefs.getString("gateway");
+  if (_prefs.isKey("netmask"))    cfg.netmask = _prefs.getString("netmask");
+  if (_prefs.isKey("dns"))        cfg.dns = _prefs.getString("dns");
+  if (_prefs.getBytes("fc_bssid", cfg.bssid, sizeof(cfg.bssid)) == sizeof(cfg.bssid)) {
+    cfg.channel    = _prefs.getUChar("fc_chan", 0);
+    cfg.lease_ip   = _prefs.getULong("fc_ip", 0);
+    cfg.lease_gw   = _prefs.getULong("fc_gw", 0);
+    cfg.lease_mask = _prefs.getULong("fc_mask", 0);
+    cfg.lease_dns  = _prefs.getULong("fc_dns", 0);
+  }
   _prefs.end();
 }
 
@@ -21,6 +57,33 @@ void ProvisioningService::save(const McpConfig& cfg){
   _prefs.putString("mqtt_host", cfg.mqtt_host);
   _prefs.putUShort("mqtt_port", cfg.mqtt_port);
   _prefs.putString("device_id", cfg.device_id);
+  _prefs.putString("static_ip", cfg.static_ip);
+  _prefs.putString("gateway", cfg.gateway);
+  _prefs.putString("netmask", cfg.netmask);
+  _prefs.putString("dns", cfg.dns);
+  // new credentials: the cached AP/lease may belong to another network
+  _prefs.remove("fc_bssid");
+  _prefs.end();
+}
+
+// Only rewritten when something changed (NVS wear on every reboot otherwise)
+void ProvisioningService::_saveFast(const McpConfig& cfg){
+  McpConfig old;
+  _prefs.begin("mcp", false);
+  bool same = _prefs.getBytes("fc_bssid", old.bssid, sizeof(old.bssid)) == sizeof(old.bssid) &&
+              memcmp(old.bssid, cfg.bssid, sizeof(old.bssid)) == 0 &&
+              _prefs.getUChar("fc_chan", 0) == cfg.channel &&
+              _prefs.getULong("fc_ip", 0) == cfg.lease_ip && _prefs.getULong("fc_gw", 0) == cfg.lease_gw &&
+              _prefs.getULong("fc_mask", 0) == cfg.lease_mask && _prefs.getULong("fc_dns", 0) == cfg.lease_dns;
+  if (!same) {
+    _prefs.putBytes("fc_bssid", cfg.bssid, sizeof(cfg.bssid));
+    _prefs.putUChar("fc_chan", cfg.channel);
+    _prefs.putULong("fc_ip", cfg.lease_ip);
+    _prefs.putULong("fc_gw", cfg.lease_gw);
+    _prefs.putULong("fc_mask", cfg.lease_mask);
+    _prefs.putULong("fc_dns", cfg.lease_dns);
+    Serial.printf("[WIFI] Fast-connect cache updated (ch=%u)\n", cfg.channel);
+  }
   _prefs.end();
 }
 
@@ -40,53 +103,88 @@ String ProvisioningService::apSsid(){
   return String(ssid);
 }
 
-String ProvisioningService::htmlEscape(const String& s){
-  String o; o.reserve(s.length()+8);
+void ProvisioningService::jsonEscape(String& out, const String& s){
   for(char c: s){
     switch(c){
-      case '&': o += F("&amp;"); break;
-      case '<': o += F("&lt;"); break;
-      case '>': o += F("&gt;"); break;
-      case '\"': o += F("&quot;"); break;
-      case '\'': o += F("&#39;"); break;
-      default: o += c;
+      case '"':  out += F("\\\""); break;
+      case '\\': out += F("\\\\"); break;
+      default:
+        if((uint8_t)c < 0x20){ char u[8]; snprintf(u, sizeof(u), "\\u%04x", c); out += u; }
+        else out += c;
     }
   }
-  return o;
 }
 
-String ProvisioningService::buildProvisionPage(const String& did, bool doScan){
+void ProvisioningService::startScan(){
+  if(_scanning) return;
+  // async: returns WIFI_SCAN_RUNNING immediately, loop() picks up the result
+  _scanning = WiFi.scanNetworks(true) == WIFI_SCAN_RUNNING;
+}
+
+void ProvisioningService::collectScan(){
+  int n = WiFi.scanComplete();
+  if(n == WIFI_SCAN_RUNNING) return;
+  _scanning = false;
+  if(n < 0) return;                    // WIFI_SCAN_FAILED: keep the previous list
+  _networks.clear();
+  for(int i=0;i<n;i++){
+    String ssid = WiFi.SSID(i);
+    if(!ssid.length()) continue;       // hidden
+    int32_t rssi = WiFi.RSSI(i);
+    bool dup = false;
+    for(auto& nw: _networks) if(nw.ssid == ssid){ if(rssi > nw.rssi) nw.rssi = rssi; dup = true; break; }
+    if(!dup) _networks.push_back({ssid, rssi, WiFi.encryptionType(i) != WIFI_AUTH_OPEN});
+  }
+  WiFi.scanDelete();
+  std::sort(_networks.begin(), _networks.end(), [](const Network& a, const Network& b){ return a.rssi > b.rssi; });
+  if(_networks.size() > PROV_SCAN_MAX) _networks.resize(PROV_SCAN_MAX);
+  _scanMs = millis();
+  if(!_scanMs) _scanMs = 1;
+  Serial.printf("[PROV] Scan done: %u networks\n", (unsigned)_networks.size());
+}
+
+void ProvisioningService::loop(){
+  if(_scanning) collectScan();
+}
+
+// Static page: gzip in flash, streamed as-is (no per-request String)
+void ProvisioningService::sendPage(){
+  _srv.sendHeader("Content-Encoding", "gzip");
+  _srv.sendHeader("Cache-Control", "no-cache");
+  _srv.setContentLength(PROVISION_PAGE_GZ_LEN);
+  _srv.send(200, "text/html; charset=utf-8", "");
+  for(size_t off=0; off<PROVISION_PAGE_GZ_LEN; off+=PROV_PAGE_CHUNK){
+    size_t n = PROVISION_PAGE_GZ_LEN - off;
+    if(n > PROV_PAGE_CHUNK) n = PROV_PAGE_CHUNK;
+    _srv.sendContent_P((PGM_P)PROVISION_PAGE_GZ + off, n);
+  }
+}
+
+// {"device_id":..,"scanning":..,"age_ms":..,"networks":[{"ssid","rssi","secure"}]}
+void ProvisioningService::sendNetworks(){
+  bool stale = !_scanMs || millis() - _scanMs > PROV_SCAN_MAX_AGE_MS;
+  if(_srv.hasArg("rescan") && stale) startScan();
   String body;
-  body.reserve(6000);
-  body += F("<!doctype html><html><head><meta charset='utf-8'><meta name='viewport' content='width=device-width,initial-scale=1'><title>MCP-Lite Setup</title><style>body{font-family:sans-serif;max-width:560px;margin:20px auto;padding:0 12px}label{display:block;margin:.6rem 0 .2rem}input,select{width:100%;padding:.6rem;font-size:1rem}button{padding:.6rem 1rem;margin-top:1rem}small{color:#666}</style></head><body><h2>Provisioning</h2>");
-  if(doScan){
-    int n = WiFi.scanNetworks();
-    body += F("<details open><summary>Scan Wi-Fi</summary><label>SSID</label><select id='ssid'>");
-    for(int i=0;i<n;i++){
-      String ssid = WiFi.SSID(i);
-      int32_t rssi = WiFi.RSSI(i);
-      bool enc = WiFi.encryptionType(i) != WIFI_AUTH_OPEN;
-      body += "<option value='" + htmlEscape(ssid) + "'>";
-      body += htmlEscape(ssid) + " (" + String(rssi) + " dBm";
-      body += enc ? ", 🔒" : ", 🔓";
-      body += ")</option>";
-    }
-    if(n<=0) body += F("<option value=''>No networks found (rescan)</option>");
-    body += F("</select><button onclick=\"document.getElementById('ssidText').value=document.getElementById('ssid').value\">Use selected</button></details>");
-  } else {
-    body += F("<p><a href='/?scan=1'>Scan Wi-Fi</a> (recommended)</p>");
+  body.reserve(64 + _networks.size() * 48);
+  body += F("{\"device_id\":\"");
+  jsonEscape(body, _did);
+  body += F("\",\"scanning\":");
+  body += _scanning ? F("true") : F("false");
+  body += F(",\"age_ms\":");
+  body += _scanMs ? String(millis() - _scanMs) : String(-1);
+  body += F(",\"networks\":[");
+  for(size_t i=0;i<_networks.size();i++){
+    const Network& nw = _networks[i];
+    if(i) body += ',';
+    body += F("{\"ssid\":\"");
+    jsonEscape(body, nw.ssid);
+    body += F("\",\"rssi\":");
+    body += String(nw.rssi);
+    body += nw.secure ? F(",\"secure\":true}") : F(",\"secure\":false}");
   }
-  body += F("<form method='POST' action='/save'>"
-            "<label>Wi-Fi SSID</label><input id='ssidText' name='wifi_ssid' required>"
-            "<label>Wi-Fi Password</label><input name='wifi_pass' type='password'>"
-            "<label>MQTT Host (IP)</label><input name='mqtt_host' value='192.168.0.100' required>"
-            "<label>MQTT Port</label><input name='mqtt_port' type='number' value='1883' min='1' max='65535' required>"
-            "<label>Device ID</label><input name='device_id' value='");
-  body += htmlEscape(did);
-  body += F("' required>"
-            "<button type='submit'>Save & Reboot</button>"
-            "</form><hr><p><small>Project saba</small></p></body></html>");
-  return body;
+  body += F("]}");
+  _srv.sendHeader("Cache-Control", "no-store");
+  _srv.send(200, "application/json", body);
 }
 
 void ProvisioningService::startPortal(const String& defaultDid){
@@ -105,15 +203,18 @@ void ProvisioningService::startPortal(const String& defaultDid){
 
   _dns.start(53, "*", apIP);
 
-  _srv.onNotFound([this, defaultDid](){
-    bool doScan = _srv.hasArg("scan");
-    String html = buildProvisionPage(defaultDid, doScan);
-    _srv.send(200, "text/html; charset=utf-8", html);
-  });
-  _srv.on("/", HTTP_GET, [this, defaultDid](){
-    String html = buildProvisionPage(defaultDid, _srv.hasArg("scan"));
-    _srv.send(200, "text/html; charset=utf-8", html);
+  // First scan runs while the user is still joining the AP
+  _did = defaultDid;
+  WiFi.mode(WIFI_AP_STA);
+  startScan();
+
+  // Captive-portal probes (any host/path): a tiny redirect instead of the page
+  _srv.onNotFound([this, apIP](){
+    _srv.sendHeader("Location", String("http://") + apIP.toString() + "/");
+    _srv.send(302, "text/plain", "");
   });
+  _srv.on("/", HTTP_GET, [this](){ sendPage(); });
+  _srv.on("/networks.json", HTTP_GET, [this](){ sendNetworks(); });
   _srv.on("/generate_204", HTTP_GET, [this](){ _srv.send(204); });
   _srv.on("/hotspot-detect.html", HTTP_GET, [this](){ _srv.send(200, "text/plain", "OK"); });
   _srv.on("/save", HTTP_POST, [this](){
@@ -123,6 +224,10 @@ void ProvisioningService::startPortal(const String& defaultDid){
     cfg.mqtt_host = _srv.arg("mqtt_host");
     cfg.mqtt_port = (uint16_t) _srv.arg("mqtt_port").toInt();
     cfg.device_id = _srv.arg("device_id");
+    cfg.static_ip = _srv.arg("static_ip");
+    cfg.gateway   = _srv.arg("gateway");
+    cfg.netmask   = _srv.arg("netmask");
+    cfg.dns       = _srv.arg("dns");
     if(!cfg.wifi_ssid.length() || !cfg.mqtt_host.length() || !cfg.mqtt_port || !cfg.device_id.length()){
       _srv.send(422, "text/plain", "Missing required fields"); return;
     }
@@ -135,15 +240,83 @@ void ProvisioningService::startPortal(const String& defaultDid){
 }
 
 bool ProvisioningService::connectSTA(const String& ssid, const String& pass, unsigned long timeoutMs){
+  McpConfig cfg;
+  cfg.wifi_ssid = ssid;
+  cfg.wifi_pass = pass;
+  return _attempt(cfg, false, timeoutMs);
+}
+
+bool ProvisioningService::connectSTA(McpConfig& cfg, unsigned long timeoutMs){
+  _timing = ConnectTiming();
+  _timing.start_ms = millis();
+  bool ok = false;
+  if (cfg.channel) {
+    ok = _attempt(cfg, true, PROV_FAST_CONNECT_MS);
+    if (!ok) Serial.println("[WIFI] Fast connect failed, full scan...");
+  }
+  if (!ok) {
+    uint32_t spent = millis() - _timing.start_ms;
+    ok = _attempt(cfg, false, timeoutMs > spent ? timeoutMs - spent : 1000);
+  }
+  if (!ok) return false;
+
+  memcpy(cfg.bssid, WiFi.BSSID(), sizeof(cfg.bssid));
+  cfg.channel = (uint8_t)WiFi.channel();
+  if (!cfg.static_ip.length()) {
+    cfg.lease_ip   = (uint32_t)WiFi.localIP();
+    cfg.lease_gw   = (uint32_t)WiFi.gatewayIP();
+    cfg.lease_mask = (uint32_t)WiFi.subnetMask();
+    cfg.lease_dns  = (uint32_t)WiFi.dnsIP();
+  }
+  _saveFast(cfg);
+  return true;
+}
+
+bool ProvisioningService::_attempt(McpConfig& cfg, bool fast, unsigned long timeoutMs){
   WiFi.setSleep(false);
   WiFi.mode(WIFI_STA);
-  WiFi.begin(ssid.c_str(), pass.c_str());
+
+  // IP config: user static > reused lease (fast path only) > DHCP
+  IPAddress ip, gw, mask, dns;
+  if (cfg.static_ip.length() && ip.fromString(cfg.static_ip) && gw.fromString(cfg.gateway)) {
+    if (!mask.fromString(cfg.netmask)) mask = IPAddress(255,255,255,0);
+    if (!dns.fromString(cfg.dns)) dns = gw;
+    WiFi.config(ip, gw, mask, dns);
+#if PROV_REUSE_LEASE
+  } else if (fast && cfg.lease_ip && cfg.lease_gw) {
+    WiFi.config(IPAddress(cfg.lease_ip), IPAddress(cfg.lease_gw), IPAddress(cfg.lease_mask),
+                IPAddress(cfg.lease_dns ? cfg.lease_dns : cfg.lease_gw));
+#endif
+  } else {
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);   // back to DHCP
+  }
+
+#if defined(ESP32)
+  wifiEventsInit();
+  xEventGroupClearBits(s_wifiEvents, EV_GOT_IP);
+  s_assocMs = 0;
+#endif
+  if (fast) WiFi.begin(cfg.wifi_ssid.c_str(), cfg.wifi_pass.c_str(), cfg.channel, cfg.bssid, true);
+  else      WiFi.begin(cfg.wifi_ssid.c_str(), cfg.wifi_pass.c_str());
 
   //ESP-32-C3-MINI-ERROR
   WiFi.setTxPower(WIFI_POWER_8_5dBm);
 
-
+#if defined(ESP32)
+  // Driver retries association on its own; just block until DHCP (or the static config) is up
+  xEventGroupWaitBits(s_wifiEvents, EV_GOT_IP, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeoutMs));
+  _timing.assoc_ms = s_assocMs;
+#else
   unsigned long start = millis();
-  while(WiFi.status()!=WL_CONNECTED && (millis()-start < timeoutMs)){ delay(500); }
-  return WiFi.status()==WL_CONNECTED;
+  while(WiFi.status()!=WL_CONNECTED && (millis()-start < timeoutMs)){ delay(50); }
+#endif
+  bool ok = WiFi.status()==WL_CONNECTED;
+  if (ok) {
+    if (!_timing.assoc_ms) _timing.assoc_ms = millis();
+    _timing.ip_ms = millis();
+    _timing.fast = fast;
+  } else {
+    WiFi.disconnect();
+  }
+  return ok;
 }
@@ -4,6 +4,28 @@
 #include <DNSServer.h>
 #include <Preferences.h>
 #include <WiFi.h>
+#include <vector>
+
+#ifndef PROV_SCAN_MAX
+#define PROV_SCAN_MAX 20               // networks kept (strongest first, SSIDs deduped)
+#endif
+#ifndef PROV_SCAN_MAX_AGE_MS
+#define PROV_SCAN_MAX_AGE_MS 30000     // ?rescan=1 is ignored while the cached list is younger
+#endif
+#ifndef PROV_PAGE_CHUNK
+#define PROV_PAGE_CHUNK 1024           // sendContent() piece size for the gzipped page
+#endif
+
+#ifndef PROV_FAST_CONNECT_MS
+#define PROV_FAST_CONNECT_MS 3000      // cached BSSID/channel attempt, then full scan-and-associate
+#endif
+#ifndef PROV_REUSE_LEASE
+// 1: the fast path reuses the last DHCP lease as a static config (skips DHCP, ~1 s faster).
+// Off by default: without a clock across reboots the lease's expiry cannot be checked, and a
+// server that has handed the address on makes it a duplicate. Enable only where addresses are
+// reserved per MAC (DHCP reservation); a failed fast attempt still falls back to DHCP.
+#define PROV_REUSE_LEASE 0
+#endif
 
 struct McpConfig {
   String wifi_ssid;
@@ -11,6 +33,15 @@ struct McpConfig {
   String mqtt_host;
   uint16_t mqtt_port = 1883;
   String device_id;
+  // Optional static IP (empty = DHCP)
+  String static_ip;
+  String gateway;
+  String netmask;
+  String dns;
+  // Fast reconnect cache: last AP that worked and the lease it gave us (saved by connectSTA)
+  uint8_t bssid[6] = {0};
+  uint8_t channel = 0;                 // 0 = nothing cached
+  uint32_t lease_ip = 0, lease_gw = 0, lease_mask = 0, lease_dns = 0;
 };
 
 class ProvisioningService {
@@ -22,11 +53,33 @@ public:
   bool hasMinimum(const McpConfig& cfg);
   void startPortal(const String& defaultDid);
   bool connectSTA(const String& ssid, const String& pass, unsigned long timeoutMs=30000);
+  // Cached BSSID/channel (and lease) first, full scan as fallback; refreshes the cache in cfg/NVS
+  bool connectSTA(McpConfig& cfg, unsigned long timeoutMs=30000);
+
+  // Milestones of the last connectSTA(), in millis() since boot
+  struct ConnectTiming { uint32_t start_ms = 0, assoc_ms = 0, ip_ms = 0; bool fast = false; };
+  const ConnectTiming& lastConnect() const { return _timing; }
   String apSsid();
+  // Call from loop() while the portal runs: collects the background Wi-Fi scan
+  void loop();
 private:
+  struct Network { String ssid; int32_t rssi; bool secure; };
+
   WebServer& _srv;
   DNSServer& _dns;
   Preferences& _prefs;
-  String htmlEscape(const String& s);
-  String buildProvisionPage(const String& did, bool doScan);
+  String _did;
+  // Async scan cache: the portal never blocks on WiFi.scanNetworks()
+  std::vector<Network> _networks;
+  uint32_t _scanMs = 0;              // when _networks was filled (0 = never)
+  bool _scanning = false;
+  void startScan();
+  void collectScan();
+  void sendPage();
+  void sendNetworks();
+  static void jsonEscape(String& out, const String& s);
+
+  ConnectTiming _timing;
+  bool _attempt(McpConfig& cfg, bool fast, unsigned long timeoutMs);
+  void _saveFast(const McpConfig& cfg);
 };
\ No newline at end of file
@@ -0,0 +1,28 @@
+#!/usr/bin/env python3
+"""Regenerate src/provision_page.h from web/provision.html (gzip, PROGMEM byte array).
+
+Run after editing the page:  python3 web/embed_page.py
+"""
+import gzip, os
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.join(HERE, "provision.html")
+DST = os.path.join(HERE, "..", "src", "provision_page.h")
+
+with open(SRC, "rb") as f:
+    html = f.read()
+gz = gzip.compress(html, compresslevel=9, mtime=0)
+
+lines = []
+for i in range(0, len(gz), 16):
+    lines.append("  " + ",".join(f"0x{b:02x}" for b in gz[i:i + 16]) + ",")
+
+with open(DST, "w", newline="\n") as f:
+    f.write("#pragma once\n")
+    f.write("// Generated by web/embed_page.py from web/provision.html -- do not edit by hand\n")
+    f.write("#include <Arduino.h>\n\n")
+    f.write(f"// {len(html)} bytes of HTML, gzip -9\n")
+    f.write(f"static const size_t PROVISION_PAGE_GZ_LEN = {len(gz)};\n")
+    f.write("static const uint8_t PROVISION_PAGE_GZ[] PROGMEM = {\n")
+    f.write("\n".join(lines) + "\n};\n")
+print(f"{len(html)} -> {len(gz)} bytes")
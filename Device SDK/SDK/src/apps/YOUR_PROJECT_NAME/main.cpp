@@ -10,19 +10,50 @@
 #include "config.hpp"
 #include "transports/topics.h"
 #include "registry.h"
+#include "executor.h"
+#include "announce_cache.h"
 #include "hooks.h"
 #include "provisioning_service.h"
 #include "tool.h"
 #include "obs_emitter.h"
 #include "mqtt_emitter.h"
-#include "registry_tick.h"
+#include "mqtt_publish.h"
+#include "batching_emitter.h"
+#include "outbox_emitter.h"
+#include "tool_runtime.h"
+#include "asset_push.h"
+#include "async_mqtt_transport.h"
+#include "metrics.h"
+#include "mcp_log.h"
+#include "trace.h"
 
 // ========= Constants =========
 static const uint16_t HTTP_PORT_NUM = HTTP_PORT;
-static const uint32_t MQTT_RECONNECT_INTERVAL = 3000;
 static const uint32_t WIFI_RECONNECT_INTERVAL = 5000;
 static const uint32_t STATUS_PUBLISH_INTERVAL = 30000;
 static const uint32_t ANNOUNCE_PUBLISH_INTERVAL = 300000;
+static const size_t STATUS_DOC_BYTES = 1024;   // pooled (DocPool large class)
+#ifndef ANNOUNCE_INLINE_TOOLS
+#define ANNOUNCE_INLINE_TOOLS 0   // 1 = also put the full tools schema in the retained announce (old bridges)
+#endif
+#ifndef HTTP_TASK_CORE
+#define HTTP_TASK_CORE 0          // runtime HTTP serving task; loop() stays on the Arduino core
+#endif
+#ifndef HTTP_TASK_STACK
+#define HTTP_TASK_STACK 8192
+#endif
+#ifndef ASSET_TRANSPORT_DEFAULT
+#define ASSET_TRANSPORT_DEFAULT "http"   // "mqtt": push binary assets as chunks unless a command asks for http
+#endif
+#ifndef METRICS_PUBLISH_INTERVAL_MS
+#define METRICS_PUBLISH_INTERVAL_MS 0    // >0: periodic device.metrics on mcp/dev/<id>/metrics
+#endif
+#ifndef NET_TASK_CORE
+#define NET_TASK_CORE 0           // Wi-Fi/MQTT task (with HttpTask); tools run on RUNTIME_TOOL_CORE
+#endif
+#ifndef NET_TASK_STACK
+#define NET_TASK_STACK 8192
+#endif
 
 // ========= Run Mode =========
 enum RunMode { MODE_PROVISION, MODE_RUN };
@@ -33,20 +64,63 @@ WebServer server(HTTP_PORT_NUM);
 DNSServer dnsServer;
 Preferences prefs;
 WiFiClient wifiClient;
-PubSubClient mqtt(wifiClient);
+PubSubClient mqttClient(wifiClient);
+AsyncMqttTransport mqtt(mqttClient);      // mqttClient lives on MqttTask; everything else uses mqtt
 ToolRegistry registry;
+ToolExecutor executor;
+ToolRuntime runtime(registry, executor);   // tool task + SPSC queues to/from the network side
+RuleEngine rules(registry);                // device.rules reflexes, run on the tool task
+AnnounceCache announceCache;
 
 // ========= State Variables =========
 String http_base;
 String device_id;
+DeviceTopics topics;                       // built once device_id is known
 McpConfig CFG;
 ProvisioningService* prov = nullptr;
 
 // ========= Timing =========
 unsigned long lastStatusMs = 0;
 unsigned long lastAnnounceMs = 0;
-unsigned long lastMqttTry = 0;
+unsigned long lastMetricsMs = 0;
 unsigned long lastWifiTry = 0;
+bool wifiDown = false;
+
+// Boot breakdown (millis since boot), reported once in the first device.status
+struct BootTiming {
+  uint32_t wifi_ms = 0, ip_ms = 0, mqtt_ms = 0, announce_ms = 0;
+  bool fast = false;       // cached BSSID/channel path worked
+  bool reported = false;
+} bootTiming;
+
+// ========= HTTP → loop() requests =========
+// In runtime mode WebServer runs on its own task; handlers never touch the MQTT transport,
+// they post a request bit that loop() executes.
+enum HttpRequest : uint8_t { REQ_STATUS = 1, REQ_ANNOUNCE = 2, REQ_CLEAR_RETAINED = 4, REQ_FACTORY_RESET = 8 };
+volatile uint8_t httpRequests = 0;
+#if defined(ESP32)
+portMUX_TYPE httpReqMux = portMUX_INITIALIZER_UNLOCKED;
+TaskHandle_t httpTask = nullptr;
+TaskHandle_t netTask = nullptr;
+TaskHandle_t loopTask = nullptr;
+#endif
+
+void postHttpRequest(uint8_t r) {
+#if defined(ESP32)
+  portENTER_CRITICAL(&httpReqMux); httpRequests |= r; portEXIT_CRITICAL(&httpReqMux);
+#else
+  httpRequests |= r;
+#endif
+}
+
+uint8_t takeHttpRequests() {
+#if defined(ESP32)
+  portENTER_CRITICAL(&httpReqMux); uint8_t r = httpRequests; httpRequests = 0; portEXIT_CRITICAL(&httpReqMux);
+#else
+  uint8_t r = httpRequests; httpRequests = 0;
+#endif
+  return r;
+}
 
 // ========= Helper Functions =========
 String isoNow() {
@@ -66,137 +140,232 @@ String macTailDeviceId() {
   return String(buf);
 }
 
-// ========= MQTT Topics =========
-inline String topicAnn()  { return topicAnnounce(device_id); }
-inline String topicStat() { return topicStatus(device_id); }
-inline String topicCmd()  { return topicCmd(device_id); }
-inline String topicEvt()  { return topicEvents(device_id); }
+// Set in setup(); cmd.mp traffic switches it (and so all later events) to MsgPack
+MqttObservationEmitter* mqttEmitter = nullptr;
+// Holds events/replies while MQTT is down and replays them after reconnect
+OutboxEmitter* outbox = nullptr;
+// Network-side emitter chain (batcher → outbox → MQTT); tools emit via runtime.toolEmitter()
+IObservationEmitter* netEmitter = nullptr;
 
 // ========= MQTT Publishing =========
 void publishAnnounce() {
   if (!mqtt.connected()) return;
   
-  String ann = registry.buildAnnounce(device_id, http_base);
-  bool ok = mqtt.publish(topicAnn().c_str(), ann.c_str(), true);
+  // Cached at boot: only {device_id, schema_hash, schema_url} goes out; full schema via /announce.json
+  String ann = !announceCache.ready() ? registry.buildAnnounce(device_id, http_base)
+             : ANNOUNCE_INLINE_TOOLS  ? announceCache.fullJson(device_id, http_base)
+             :                          announceCache.pointerJson(device_id, http_base);
+  bool ok = mqtt.publish(topics.announce.c_str(), (const uint8_t*)ann.c_str(), ann.length(), MQTT_EVENTS_QOS, true);
   Serial.printf("[MQTT] Announce %s (retain, %u bytes)\n", ok ? "✓" : "✗", ann.length());
   
   if (ok) lastAnnounceMs = millis();
+  if (ok && !bootTiming.announce_ms) bootTiming.announce_ms = lastAnnounceMs;
 }
 
 void publishStatus(bool online) {
   if (!mqtt.connected()) return;
   
-  StaticJsonDocument<256> doc;
+  DocLease lease(STATUS_DOC_BYTES);
+  JsonDocument& doc = lease.doc();
   doc["type"] = "device.status";
   doc["device_id"] = device_id;
   doc["online"] = online;
   doc["uptime_ms"] = millis();
   doc["rssi"] = WiFi.RSSI();
   doc["ts"] = isoNow();
+  if (outbox) {
+    const OutboxEmitter::Stats& st = outbox->stats();
+    JsonObject ob = doc.createNestedObject("outbox");
+    ob["queued"] = st.queued;
+    ob["replayed"] = st.replayed;
+    ob["dropped_oldest"] = st.dropped_oldest;
+    ob["dropped_quota"] = st.dropped_quota;
+    ob["dropped_oversize"] = st.dropped_oversize;
+  }
+  {
+    const MqttTransport::Stats& ms = mqtt.stats();
+    JsonObject mq = doc.createNestedObject("mqtt");
+    mq["connects"] = ms.connects;
+    mq["failures"] = ms.failures;
+    mq["disconnects"] = ms.disconnects;
+    mq["tx_pending"] = mqtt.pendingTx();
+    mq["tx_dropped"] = ms.tx_dropped;
+    mq["tx_failed"] = ms.tx_failed;
+    mq["rx_dropped"] = ms.rx_dropped;
+  }
+  {
+    const ToolRuntime::Stats& rs = runtime.stats();
+    JsonObject rt = doc.createNestedObject("runtime");
+    rt["threaded"] = runtime.threaded();
+    rt["cmd_dropped"] = rs.cmd_dropped;
+    rt["obs_dropped"] = rs.obs_dropped;
+    rt["parse_errors"] = rs.parse_errors;
+    const ResultCache::Stats& cs = registry.cacheStats();
+    rt["dedup_hits"] = cs.hits;
+    rt["dedup_attached"] = cs.attached;
+    const RuleEngine::Stats& rl = rules.stats();
+    JsonObject ru = rt.createNestedObject("rules");
+    ru["active"] = rules.count();
+    ru["fired"] = rl.fired;
+    ru["limited"] = rl.limited;
+    ru["dropped"] = rl.dropped;
+    ru["failed"] = rl.failed;
+  }
+  {
+    // Memory headroom: JSON pool, heap, least free stack per task (bytes)
+    DocPool::Stats ps = DocPool::instance().stats();
+    JsonObject jp = doc.createNestedObject("json_pool");
+    jp["in_use"] = ps.in_use;
+    jp["high_water"] = ps.high_water;
+    jp["misses"] = ps.misses;
+    jp["overflows"] = ps.overflows;
+    jp["heap_failed"] = ps.heap_failed;
+    JsonObject hp = doc.createNestedObject("heap");
+    hp["free"] = ESP.getFreeHeap();
+    hp["min_free"] = ESP.getMinFreeHeap();
+    hp["max_alloc"] = ESP.getMaxAllocHeap();
+    if (psramFound()) hp["psram_free"] = ESP.getFreePsram();
+#if defined(ESP32)
+    JsonObject sk = doc.createNestedObject("stack_free");
+    if (netTask)         sk["net"]  = uxTaskGetStackHighWaterMark(netTask);
+    if (runtime.task())  sk["tool"] = uxTaskGetStackHighWaterMark(runtime.task());
+    if (httpTask)        sk["http"] = uxTaskGetStackHighWaterMark(httpTask);
+    if (mqtt.task())     sk["mqtt"] = uxTaskGetStackHighWaterMark(mqtt.task());
+    if (loopTask)        sk["loop"] = uxTaskGetStackHighWaterMark(loopTask);
+    if (uint32_t w = executor.stackHighWater()) sk["exec"] = w;
+#endif
+  }
+  if (!bootTiming.reported) {
+    JsonObject bt = doc.createNestedObject("boot");
+    bt["wifi_ms"] = bootTiming.wifi_ms;
+    bt["ip_ms"] = bootTiming.ip_ms;
+    bt["mqtt_ms"] = bootTiming.mqtt_ms;
+    bt["announce_ms"] = bootTiming.announce_ms;
+    bt["fast_connect"] = bootTiming.fast;
+  }
   
-  String s; 
-  serializeJson(doc, s);
-  bool ok = mqtt.publish(topicStat().c_str(), s.c_str());
+  bool ok = publishJson(mqtt, topics.status.c_str(), doc);
   
   Serial.printf("[MQTT] Status %s (online=%d, rssi=%d)\n", 
                 ok ? "✓" : "✗", online, (int)WiFi.RSSI());
   
   if (ok) lastStatusMs = millis();
+  if (ok) bootTiming.reported = true;
+}
+
+#if MCP_METRICS
+// Compact snapshot of the /metrics counters (see Metrics::toJson for the layout)
+void publishMetrics() {
+  if (!mqtt.connected()) return;
+  DocLease lease(DOC_POOL_LARGE_BYTES);
+  JsonDocument& doc = lease.doc();
+  doc["type"] = "device.metrics";
+  doc["device_id"] = device_id;
+  doc["uptime_ms"] = millis();
+  Metrics::instance().toJson(doc.createNestedObject("m"));
+  bool ok = publishJson(mqtt, topics.metrics.c_str(), doc);
+  Serial.printf("[MQTT] Metrics %s%s\n", ok ? "✓" : "✗", doc.overflowed() ? " (truncated)" : "");
+  lastMetricsMs = millis();
+}
+
+// Gauges sampled when /metrics or device.metrics is rendered
+void registerGauges() {
+  Metrics& m = Metrics::instance();
+  m.gauge("mcp_heap_free_bytes",      [](){ return (float)ESP.getFreeHeap(); });
+  m.gauge("mcp_heap_min_free_bytes",  [](){ return (float)ESP.getMinFreeHeap(); });
+  m.gauge("mcp_heap_max_alloc_bytes", [](){ return (float)ESP.getMaxAllocHeap(); });
+  m.gauge("mcp_psram_free_bytes",     [](){ return (float)ESP.getFreePsram(); });
+  m.gauge("mcp_outbox_depth",         [](){ return outbox ? (float)outbox->pending() : 0.0f; });
+  m.gauge("mcp_runtime_cmd_depth",    [](){ return (float)runtime.pendingCmds(); });
+  m.gauge("mcp_runtime_obs_depth",    [](){ return (float)runtime.pendingObs(); });
+  m.gauge("mcp_json_pool_in_use",     [](){ return (float)DocPool::instance().stats().in_use; });
+  m.gauge("mcp_wifi_rssi_dbm",        [](){ return (float)WiFi.RSSI(); });
+}
+
+#endif
+
+// Print → chunked HTTP body, so /metrics and /trace are never built as one String
+class HttpChunkPrint : public Print {
+public:
+  size_t write(uint8_t c) override {
+    _buf[_n++] = (char)c;
+    if (_n == sizeof(_buf)) flush();
+    return 1;
+  }
+  void flush() { if (_n) { server.sendContent(_buf, _n); _n = 0; } }
+private:
+  char _buf[512];
+  size_t _n = 0;
+};
+
+// Start a chunked 200 response; body follows through HttpChunkPrint
+void beginChunked(const char* contentType) {
+  server.sendHeader("Cache-Control", "no-store");
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, contentType, "");
 }
 
 void clearRetainedMessages() {
   if (!mqtt.connected()) return;
   
-  mqtt.publish(topicAnn().c_str(), "", true);
-  mqtt.publish(topicStat().c_str(), "", true);
+  mqtt.publish(topics.announce.c_str(), "", true);
+  mqtt.publish(topics.status.c_str(), "", true);
   Serial.println("[MQTT] Cleared retained messages");
 }
 
 // ========= MQTT Callback =========
-void onMqttMessage(char* topic, byte* payload, unsigned int length) {
-  Serial.printf("[MQTT] RX %s (%u bytes)\n", topic, length);
-  
-  // DEBUG: Print raw payload
-  Serial.print("[DEBUG] Raw payload: ");
-  Serial.write(payload, length);
-  Serial.println();
-  
-  // Parse command
-  StaticJsonDocument<768> cmd;
-  DeserializationError err = deserializeJson(cmd, payload, length);
-  
-  if (err) {
-    Serial.printf("[MQTT] JSON parse error: %s\n", err.c_str());
-    return;
-  }
-  
-  // DEBUG: Print parsed JSON
-  Serial.print("[DEBUG] Parsed JSON: ");
-  serializeJson(cmd, Serial);
-  Serial.println();
-  
-  const char* cmdType = cmd["type"] | "unknown";
-  const char* toolName = cmd["tool"] | "unknown";
-  Serial.printf("[MQTT] Type=%s, Tool=%s\n", cmdType, toolName);
-  
-  // DEBUG: Check if args exists and what's in it
-  JsonVariantConst argsVariant = cmd["args"];
-  Serial.printf("[DEBUG] args isNull=%d\n", argsVariant.isNull());
-  if (!argsVariant.isNull()) {
-    Serial.print("[DEBUG] args content: ");
-    serializeJson(argsVariant, Serial);
-    Serial.println();
-  }
-  
-  // DEBUG: Show registered tools
-  Serial.print("[DEBUG] Registered tools: ");
-  for (auto* t : registry.list()) {
-    Serial.printf("'%s' ", t->name());
-  }
-  Serial.println();
-  
-  // Dispatch to tool registry
-  String eventsJson;
-  bool dispatched = registry.dispatch(cmd, eventsJson, http_base);
-  
-  if (!dispatched) {
-    Serial.println("[MQTT] Dispatch failed (tool not found or error)");
-    Serial.printf("[DEBUG] Events response: %s\n", eventsJson.c_str());
-    
-    // Still publish the error response
-    mqtt.publish(topicEvt().c_str(), eventsJson.c_str());
-    return;
-  }
-  
-  // Patch asset URLs (relative -> absolute)
-  StaticJsonDocument<2048> tmp;
-  DeserializationError err2 = deserializeJson(tmp, eventsJson);
-  
-  if (err2 == DeserializationError::Ok) {
-    JsonArray assets = tmp["result"]["assets"];
-    if (!assets.isNull()) {
-      for (JsonObject a : assets) {
-        const char* url = a["url"] | nullptr;
-        if (url && url[0] == '/') {
-          a["url"] = http_base + String(url);
-        }
-      }
-      serializeJson(tmp, eventsJson);
-    }
+void onMqttMessage(const char* topic, const uint8_t* payload, size_t length) {
+  MCP_TRACE_EVT(CmdRx, nullptr, nullptr, length);
+  MCP_LOGD("MQTT", "RX %s (%u bytes)", topic, (unsigned)length);
+  
+  // Wire format follows the topic: .../cmd.mp carries MessagePack, .../cmd JSON
+  size_t tlen = strlen(topic);
+  WireFormat fmt = (tlen > 3 && strcmp(topic + tlen - 3, ".mp") == 0) ? WireFormat::MsgPack : WireFormat::Json;
+  
+  // Bridge picked this encoding: async results/events follow it
+  if (mqttEmitter && mqttEmitter->format() != fmt) {
+    mqttEmitter->set_format(fmt);
+    Serial.printf("[MQTT] Events now %s\n", fmt == WireFormat::MsgPack ? "msgpack (events.mp)" : "json");
   }
   
-  // Publish response to events topic
-  bool pubOk = mqtt.publish(topicEvt().c_str(), eventsJson.c_str());
-  Serial.printf("[MQTT] Events %s (%u bytes)\n", pubOk ? "✓" : "✗", eventsJson.length());
+  // Parsing and dispatch happen on the tool side; the reply comes back through runtime.drain()
+  runtime.submitCommand(payload, length, fmt);
+}
+
+// Publish a command reply (or error) to the events topic in the command's encoding
+void publishReply(WireFormat fmt, const ObservationBuilder& reply) {
+  const String& evt = fmt == WireFormat::MsgPack ? topics.eventsMp : topics.events;
+  size_t bytes = fmt == WireFormat::MsgPack ? measureMsgPack(reply.doc) : measureJson(reply.doc);
+  bool pubOk = publishDoc(mqtt, evt.c_str(), reply.doc, fmt);
+#if MCP_TRACE
+  const char* fmtTag = fmt == WireFormat::MsgPack ? "mp" : "json";
+  if (pubOk) MCP_TRACE_EVT(Published, reply.doc["request_id"] | "", fmtTag, bytes);
+  else       MCP_TRACE_EVT(PublishFail, reply.doc["request_id"] | "", fmtTag, bytes);
+#endif
+  if (!pubOk && outbox) pubOk = outbox->emit(reply);   // queued; replayed after reconnect
+  MCP_LOGD("MQTT", "Events %s (%u bytes)", pubOk ? "✓" : "✗", (unsigned)bytes);
 }
 
 // ========= MQTT Connection =========
-bool mqttConnect() {
-  if (mqtt.connected()) return true;
+// Runs from mqtt.loop() on the network task after every (re)connect; the subscriptions are
+// already back (persistent session, resubscribed by the transport)
+void onMqttConnected() {
+  if (!bootTiming.mqtt_ms) bootTiming.mqtt_ms = millis();
+  const MqttTransport::Stats& st = mqtt.stats();
+  Serial.printf("[MQTT] Connected (connect #%u, %u failed attempts)\n",
+                (unsigned)st.connects, (unsigned)st.failures);
   
-  Serial.printf("[MQTT] Connecting to %s:%u...\n", CFG.mqtt_host.c_str(), CFG.mqtt_port);
+  // Publish initial messages
+  publishAnnounce();
+  publishStatus(true);
+}
+
+// Hand the broker settings to the transport; connecting and reconnecting (exponential
+// backoff) then happen on MqttTask and never block this task or the tools
+void startMqtt() {
+  Serial.printf("[MQTT] Broker %s:%u (background connect)\n", CFG.mqtt_host.c_str(), CFG.mqtt_port);
   
-  // Set Last Will & Testament
+  // Last Will & Testament: registered with every CONNECT, so it is built once
   StaticJsonDocument<256> will;
   will["type"] = "device.status";
   will["device_id"] = device_id;
@@ -204,40 +373,27 @@ bool mqttConnect() {
   will["uptime_ms"] = millis();
   will["ts"] = isoNow();
   
-  char willBuf[256];
+  static char willBuf[256];
   size_t willLen = serializeJson(will, willBuf, sizeof(willBuf));
   if (willLen >= sizeof(willBuf)) willBuf[sizeof(willBuf)-1] = '\0';
   else willBuf[willLen] = '\0';
   
-  // Connect with LWT
-  bool ok = mqtt.connect(
-    device_id.c_str(),      // client_id
-    nullptr,                // username
-    nullptr,                // password
-    topicStat().c_str(),    // will topic
-    0,                      // will qos
-    true,                   // will retain
-    willBuf                 // will message
-  );
-  
-  if (!ok) {
-    Serial.printf("[MQTT] Connect failed (state=%d)\n", mqtt.state());
-    return false;
-  }
-  
-  // Subscribe to command topic
-  String cmdTopic = topicCmd();
-  bool subOk = mqtt.subscribe(cmdTopic.c_str());
-  
-  Serial.printf("[MQTT] Connected & subscribed to '%s': %s\n", 
-                cmdTopic.c_str(), 
-                subOk ? "OK" : "FAILED");
-  
-  // Publish initial messages
-  publishAnnounce();
-  publishStatus(true);
-  
-  return true;
+  // Command topics (QoS1: redelivered until acked, kept by the broker while we are offline;
+  // duplicates hit the registry's result cache)
+  mqtt.subscribe(topics.cmd.c_str(), 1);
+  mqtt.subscribe(topics.cmdMp.c_str(), 1);
+  mqtt.onMessage(onMqttMessage);
+  mqtt.onConnect(onMqttConnected);
+  
+  MqttTransport::Config mc;
+  mc.host = CFG.mqtt_host.c_str();
+  mc.port = CFG.mqtt_port;
+  mc.client_id = device_id.c_str();
+  mc.will_topic = topics.status.c_str();
+  mc.will_payload = willBuf;
+  mc.will_retain = true;
+  mc.clean_session = false;
+  mqtt.begin(mc);
 }
 
 // ========= HTTP Handlers =========
@@ -248,6 +404,9 @@ void setupHttpHandlers() {
                  "  GET  /            - This help\n"
                  "  GET  /status_now  - Publish status immediately\n"
                  "  GET  /reannounce  - Re-publish announce (retain)\n"
+                 "  GET  /announce.json  - Full tool schema (ETag = schema_hash)\n"
+                 "  GET  /metrics     - Prometheus metrics\n"
+                 "  GET  /trace?since=N  - Recent trace events (JSON)\n"
                  "  GET  /clear_retained - Clear retained messages\n"
                  "  GET  /factory_reset  - Factory reset & reboot\n";
     
@@ -261,8 +420,8 @@ void setupHttpHandlers() {
       server.send(503, "text/plain", "MQTT not connected");
       return;
     }
-    publishStatus(true);
-    server.send(200, "text/plain", "Status published");
+    postHttpRequest(REQ_STATUS);
+    server.send(200, "text/plain", "Status publish queued");
   });
   
   server.on("/reannounce", HTTP_GET, [](){
@@ -270,34 +429,99 @@ void setupHttpHandlers() {
       server.send(503, "text/plain", "MQTT not connected");
       return;
     }
-    publishAnnounce();
-    server.send(200, "text/plain", "Announce re-published (retain)");
+    postHttpRequest(REQ_ANNOUNCE);
+    server.send(200, "text/plain", "Announce re-publish queued (retain)");
   });
   
+  server.on("/announce.json", HTTP_GET, [](){
+    if (!announceCache.ready()) {
+      server.send(200, "application/json", registry.buildAnnounce(device_id, http_base));
+      return;
+    }
+    String etag = String("\"") + announceCache.hash() + "\"";
+    server.sendHeader("ETag", etag);
+    server.sendHeader("Cache-Control", "no-cache");
+    if (server.header("If-None-Match") == etag) {
+      server.send(304);
+      return;
+    }
+    server.send(200, "application/json", announceCache.fullJson(device_id, http_base));
+  });
+  
+#if MCP_METRICS
+  server.on("/metrics", HTTP_GET, [](){
+    beginChunked("text/plain; version=0.0.4");
+    HttpChunkPrint out;
+    Metrics::instance().render(out);
+    out.flush();
+    server.sendContent("");   // terminating chunk
+  });
+#endif
+  
+#if MCP_TRACE
+  // Poll with since=<next from the previous dump> to get only new events
+  server.on("/trace", HTTP_GET, [](){
+    beginChunked("application/json");
+    HttpChunkPrint out;
+    Trace::instance().dump(out, (uint32_t)server.arg("since").toInt());
+    out.flush();
+    server.sendContent("");
+  });
+#endif
+  
   server.on("/clear_retained", HTTP_GET, [](){
     if (!mqtt.connected()) {
       server.send(503, "text/plain", "MQTT not connected");
       return;
     }
-    clearRetainedMessages();
-    server.send(200, "text/plain", "Retained messages cleared");
+    postHttpRequest(REQ_CLEAR_RETAINED);
+    server.send(200, "text/plain", "Retained messages clear queued");
   });
   
   server.on("/factory_reset", HTTP_GET, [](){
+    // runs on the net task (runHttpRequests): clears NVS, drops retained messages, reboots
+    postHttpRequest(REQ_FACTORY_RESET);
+    server.send(202, "text/plain", "Factory reset queued; the device reboots once it is done");
+  });
+  
+  // Let tools register their HTTP endpoints
+  for (auto* t : registry.list()) {
+    t->register_http(server);
+  }
+}
+
+// Serve runtime HTTP from a dedicated task so slow clients (asset downloads over weak
+// Wi-Fi) never stall mqtt.loop(); handlers keep the plain WebServer API.
+void startHttpTask() {
+#if defined(ESP32)
+  if (httpTask) return;
+  xTaskCreatePinnedToCore([](void*){
+    for (;;) {
+      server.handleClient();
+      vTaskDelay(1);
+    }
+  }, "HttpTask", HTTP_TASK_STACK, nullptr, 1, &httpTask, HTTP_TASK_CORE);
+  Serial.printf("[HTTP] Serving on core %d (task)\n", HTTP_TASK_CORE);
+#endif
+}
+
+void runHttpRequests() {
+  uint8_t r = takeHttpRequests();
+  if (!r) return;
+  if (r & REQ_FACTORY_RESET) {
     prov->clear();
+    AnnounceCache::clearNvs(prefs);
     if (mqtt.connected()) {
       clearRetainedMessages();
       mqtt.disconnect();
     }
-    server.send(200, "text/plain", "Factory reset done. Rebooting in 1s...");
     delay(1000);
     ESP.restart();
-  });
-  
-  // Let tools register their HTTP endpoints
-  for (auto* t : registry.list()) {
-    t->register_http(server);
   }
+  if (!mqtt.connected()) return;
+  if (r & REQ_STATUS) publishStatus(true);
+  if (r & REQ_ANNOUNCE) publishAnnounce();
+  if (r & REQ_CLEAR_RETAINED) clearRetainedMessages();
 }
 
 // ========= Provisioning Mode =========
@@ -319,29 +543,103 @@ void startRuntime() {
   // Configure NTP
   configTime(9*3600, 0, "pool.ntp.org", "time.google.com");
   
+  // Build the announce schema once (NVS-cached across boots of the same firmware)
+  announceCache.build(registry, FW_VERSION, &prefs);
+  
   // Setup HTTP server
   setupHttpHandlers();
+  static const char* kHeaderKeys[] = { "If-None-Match", "Range" };
+  server.collectHeaders(kHeaderKeys, 2);
   server.begin();
+  startHttpTask();
   Serial.printf("[HTTP] Server started on port %u\n", HTTP_PORT_NUM);
   
-  // Configure MQTT
-  mqtt.setBufferSize(2048);
-  mqtt.setServer(CFG.mqtt_host.c_str(), CFG.mqtt_port);
-  mqtt.setCallback(onMqttMessage);
-  mqtt.setKeepAlive(60);
+  // MQTT connects in the background (not blocking tool start-up)
+  startMqtt();
   
-  // Initial MQTT connection
-  if (!mqttConnect()) {
-    Serial.println("[RUN] MQTT initial connect failed, will retry...");
+  Serial.println("[RUN] Runtime mode ready");
+}
+
+// ========= Network side =========
+// Wi-Fi/MQTT upkeep, replies/events from the tool side, periodic status/announce.
+void networkStep(uint32_t now) {
+  // HTTP normally runs on HttpTask; inline only without FreeRTOS
+#if defined(ESP32)
+  if (!httpTask) server.handleClient();
+#else
+  server.handleClient();
+#endif
+  
+  // Wi-Fi reconnect logic (tools keep ticking; their events wait in the outbox)
+  if (WiFi.status() != WL_CONNECTED) {
+    wifiDown = true;
+    if (now - lastWifiTry >= WIFI_RECONNECT_INTERVAL) {
+      lastWifiTry = now;
+      Serial.println("[WIFI] Reconnecting...");
+      WiFi.reconnect();
+    }
+  } else if (wifiDown) {
+    wifiDown = false;
+    mqtt.retryNow();   // link is back: skip the rest of the broker backoff
   }
   
-  Serial.println("[RUN] Runtime mode ready");
+  // Received commands and the connect callback (the connection itself lives on MqttTask)
+  mqtt.loop(now);
+  
+  // MQTT work requested by HTTP handlers (status_now, reannounce, ...)
+  runHttpRequests();
+  
+  // Command replies and tool events (incl. finished long-running jobs)
+  runtime.drain([](ToolRuntime::Kind k, WireFormat fmt, const ObservationBuilder& ob){
+    pushMqttAssets(mqtt, topics, ob);   // transport:"mqtt" assets go out before the entry that names them
+    if (k == ToolRuntime::Kind::Reply) publishReply(fmt, ob);
+    else if (netEmitter) netEmitter->emit(ob);
+  });
+  
+  // Emitter housekeeping (batch flush window, outbox replay after reconnect)
+  if (netEmitter) netEmitter->poll(now);
+  
+  if (mqtt.connected()) {
+    // Periodic status publishing
+    if (now - lastStatusMs >= STATUS_PUBLISH_INTERVAL) {
+      publishStatus(true);
+    }
+    
+    // Periodic announce re-publishing (retain)
+    if (now - lastAnnounceMs >= ANNOUNCE_PUBLISH_INTERVAL) {
+      publishAnnounce();
+    }
+    
+#if MCP_METRICS
+    if (METRICS_PUBLISH_INTERVAL_MS > 0 && now - lastMetricsMs >= METRICS_PUBLISH_INTERVAL_MS) {
+      publishMetrics();
+    }
+#endif
+  }
+}
+
+void startNetTask() {
+#if defined(ESP32)
+  if (netTask) return;
+  xTaskCreatePinnedToCore([](void*){
+    for (;;) {
+      uint32_t t0 = micros();
+      networkStep(millis());
+      METRIC_OBSERVE("mcp_loop_us", "net", micros() - t0);
+      vTaskDelay(1);
+    }
+  }, "NetTask", NET_TASK_STACK, nullptr, 1, &netTask, NET_TASK_CORE);
+  Serial.printf("[RUN] Network task on core %d\n", NET_TASK_CORE);
+#endif
 }
 
 // ========= Setup =========
 void setup() {
   Serial.begin(115200);
   delay(300);
+#if defined(ESP32)
+  loopTask = xTaskGetCurrentTaskHandle();
+#endif
   Serial.println("\n╔════════════════════════════════════════╗");
   Serial.println("║     MCP-Lite Device Firmware v2.0     ║");
   Serial.println("║   Provisioning + Runtime + Events      ║");
@@ -353,6 +651,7 @@ void setup() {
   
   // Determine device ID
   device_id = CFG.device_id.length() ? CFG.device_id : macTailDeviceId();
+  topics = DeviceTopics(device_id);
   Serial.printf("[BOOT] Device ID: %s\n", device_id.c_str());
   
   // Register tools
@@ -364,6 +663,12 @@ void setup() {
                 registry.list().size(), 
                 initOk ? "OK" : "FAILED");
   
+  // Worker task for long-running tools (Motor, IMU window, ...)
+  if (executor.begin()) {
+    registry.setExecutor(&executor);
+    Serial.println("[BOOT] Tool executor started");
+  }
+  
   // List registered tools
   Serial.println("[BOOT] Registered tools:");
   for (auto* t : registry.list()) {
@@ -380,27 +685,59 @@ void setup() {
   // Try to connect to Wi-Fi
   Serial.printf("[BOOT] Connecting to Wi-Fi '%s'...\n", CFG.wifi_ssid.c_str());
   
-  if (!prov->connectSTA(CFG.wifi_ssid, CFG.wifi_pass, 20000)) {
+  // Cached BSSID/channel first (fast reboot path), full scan as fallback
+  if (!prov->connectSTA(CFG, 20000)) {
     Serial.println("[BOOT] Wi-Fi connect failed, starting provisioning...");
     startProvisioning();
     return;
   }
   
   // Connected successfully
+  bootTiming.wifi_ms = prov->lastConnect().assoc_ms;
+  bootTiming.ip_ms = prov->lastConnect().ip_ms;
+  bootTiming.fast = prov->lastConnect().fast;
   IPAddress ip = WiFi.localIP();
   http_base = String("http://") + ip.toString();
+  ObservationBuilder::setHttpBase(http_base);
   
-  Serial.printf("[WIFI] Connected! IP=%s, RSSI=%d dBm\n", 
+  Serial.printf("[WIFI] Connected! IP=%s, RSSI=%d dBm (%s, ip after %ums)\n", 
                 ip.toString().c_str(), 
-                (int)WiFi.RSSI());
+                (int)WiFi.RSSI(),
+                bootTiming.fast ? "fast" : "scan", (unsigned)bootTiming.ip_ms);
   
   // Setup MQTT observation emitter for EVENT tools
-  static MqttObservationEmitter emitter(mqtt, device_id, http_base);
-  set_global_emitter(&emitter);
-  Serial.println("[EVENT] Observation emitter registered");
+  static MqttObservationEmitter emitter(mqtt, topics, http_base);
+  mqttEmitter = &emitter;
+  static OutboxEmitter outboxEmitter(emitter);
+  outbox = &outboxEmitter;
+#if EVENT_BATCH_WINDOW_MS > 0
+  // Opt-in: coalesce events into device.observation_batch every EVENT_BATCH_WINDOW_MS
+  static BatchingEmitter batcher(outboxEmitter);
+  netEmitter = &batcher;
+  Serial.printf("[EVENT] Batching emitter registered (window=%ums, outbox=%u)\n",
+                (unsigned)EVENT_BATCH_WINDOW_MS, (unsigned)OUTBOX_SLOTS);
+#else
+  netEmitter = &outboxEmitter;
+  Serial.printf("[EVENT] Observation emitter registered (outbox=%u)\n", (unsigned)OUTBOX_SLOTS);
+#endif
+  
+  ObservationBuilder::defaultTransport() =
+      ObservationBuilder::parseTransport(ASSET_TRANSPORT_DEFAULT, ObservationBuilder::AssetTransport::Http);
+  
+#if MCP_METRICS
+  registerGauges();
+#endif
+  
+  // Tools only ever see the runtime's queue emitter (works from the tool task)
+  set_global_emitter(&runtime.toolEmitter());
+  runtime.setRules(&rules);
   
   // Start runtime
   startRuntime();
+  
+  // Dual core: tools on their own task, network on NET_TASK_CORE; loop() then idles.
+  // Single core (C3): both sides run cooperatively from loop().
+  if (runtime.begin()) startNetTask();
 }
 
 // ========= Loop =========
@@ -411,43 +748,22 @@ void loop() {
   if (RUN_MODE == MODE_PROVISION) {
     dnsServer.processNextRequest();
     server.handleClient();
+    prov->loop();   // background Wi-Fi scan for /networks.json
     return;
   }
   
-  // Runtime mode
-  server.handleClient();
-  
-  // Wi-Fi reconnect logic
-  if (WiFi.status() != WL_CONNECTED) {
-    if (now - lastWifiTry >= WIFI_RECONNECT_INTERVAL) {
-      lastWifiTry = now;
-      Serial.println("[WIFI] Reconnecting...");
-      WiFi.reconnect();
-    }
-    return; // Skip MQTT/events if no Wi-Fi
-  }
+#if defined(ESP32)
+  // Threaded runtime: NetTask + ToolTask do the work
+  if (netTask) { vTaskDelay(pdMS_TO_TICKS(1000)); return; }
+#endif
   
-  // MQTT connection management
-  if (!mqtt.connected()) {
-    if (now - lastMqttTry >= MQTT_RECONNECT_INTERVAL) {
-      lastMqttTry = now;
-      mqttConnect();
-    }
-  } else {
-    // Process MQTT messages
-    mqtt.loop();
-    
-    // Periodic status publishing
-    if (now - lastStatusMs >= STATUS_PUBLISH_INTERVAL) {
-      publishStatus(true);
-    }
-    
-    // Periodic announce re-publishing (retain)
-    if (now - lastAnnounceMs >= ANNOUNCE_PUBLISH_INTERVAL) {
-      publishAnnounce();
-    }
-  }
+  // Cooperative runtime (single core)
+  uint32_t t0 = micros();
+  networkStep(now);
+  runtime.step(now);
+  METRIC_OBSERVE("mcp_loop_us", "loop", micros() - t0);
   
-  // Tick all tools (especially EVENT tools)
-  registry_tick_all(registry, now);
-}
\ No newline at end of file
+  // Nothing due: sleep until the next deadline (bounded, so HTTP/MQTT stay responsive)
+  // instead of spinning; lets the idle task run and automatic light sleep kick in.
+  if (uint32_t idle = runtime.idleMs(millis())) delay(idle);
+}
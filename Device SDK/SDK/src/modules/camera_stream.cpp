@@ -0,0 +1,103 @@
+#include "camera_stream.h"
+
+#define STREAM_BOUNDARY "sabaframe"
+static const char* STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" STREAM_BOUNDARY;
+static const char* STREAM_PART_FMT = "\r\n--" STREAM_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %u\r\n\r\n";
+
+bool CameraStreamer::start(uint8_t fps, CameraAiThinker::Profile p){
+  _fps = constrain(fps, 1, 30);
+  _profile = p;
+  _enabled = true;
+  if (_httpd) return true;
+
+  httpd_config_t cfg = HTTPD_DEFAULT_CONFIG();
+  cfg.server_port = CAM_STREAM_PORT;
+  cfg.ctrl_port   = CAM_STREAM_PORT + 32768;
+  cfg.core_id     = CAM_STREAM_CORE;
+  cfg.max_open_sockets = 3;
+  if (httpd_start(&_httpd, &cfg) != ESP_OK) { _httpd = nullptr; _enabled = false; return false; }
+
+  httpd_uri_t uri = {};
+  uri.uri      = "/stream";
+  uri.method   = HTTP_GET;
+  uri.handler  = &_handler;
+  uri.user_ctx = this;
+  httpd_register_uri_handler(_httpd, &uri);
+  Serial.printf("[STREAM] server on :%u (core %d)\n", (unsigned)CAM_STREAM_PORT, (int)CAM_STREAM_CORE);
+  return true;
+}
+
+void CameraStreamer::stop(){
+  _enabled = false;
+}
+
+String CameraStreamer::url() const {
+  return ObservationBuilder::httpBase() + ":" + String(CAM_STREAM_PORT) + "/stream";
+}
+
+esp_err_t CameraStreamer::_handler(httpd_req_t* req){
+  CameraStreamer* self = static_cast<CameraStreamer*>(req->user_ctx);
+  if (!self->_enabled) {
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    return httpd_resp_send(req, "stream stopped", HTTPD_RESP_USE_STRLEN);
+  }
+  httpd_resp_set_type(req, STREAM_CONTENT_TYPE);
+  httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+  httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+
+  self->_clients++;
+  esp_err_t res = ESP_OK;
+  char part[96];
+  while (self->_enabled && res == ESP_OK) {
+    uint32_t t0 = millis();
+    camera_fb_t* fb = self->_cam.acquire(self->_profile);
+    if (!fb) { res = ESP_FAIL; break; }
+    int n = snprintf(part, sizeof(part), STREAM_PART_FMT, (unsigned)fb->len);
+    res = httpd_resp_send_chunk(req, part, n);
+    if (res == ESP_OK) res = httpd_resp_send_chunk(req, (const char*)fb->buf, fb->len);
+    self->_cam.releaseFb(fb);
+
+    uint32_t period = 1000 / self->_fps, spent = millis() - t0;
+    if (spent < period) vTaskDelay(pdMS_TO_TICKS(period - spent));
+  }
+  self->_clients--;
+  httpd_resp_send_chunk(req, nullptr, 0);
+  return res;
+}
+
+void CameraStreamTool::describe(JsonObject& tool){
+  tool["name"] = name();
+  if (!_start) {
+    tool["description"] = "Stop the MJPEG camera stream";
+    tool.createNestedObject("parameters")["type"] = "object";
+    return;
+  }
+  tool["description"] = "Start an MJPEG camera stream (quality: low|mid|high, fps: 1-30); returns the stream URL";
+  JsonObject params = tool.createNestedObject("parameters");
+  params["type"] = "object";
+  JsonObject props = params.createNestedObject("properties");
+  JsonArray qenum = props.createNestedObject("quality").createNestedArray("enum");
+  qenum.add("low"); qenum.add("mid"); qenum.add("high");
+  props["fps"]["type"] = "integer";
+}
+
+bool CameraStreamTool::invoke(JsonObjectConst args, ObservationBuilder& out){
+  if (!_start) {
+    _s.stop();
+    out.success("stream stopped");
+    return true;
+  }
+  String q = args["quality"] | "low";
+  uint8_t fps = args["fps"] | 10;
+  if (!_s.start(fps, CameraAiThinker::parseProfile(q))) { out.error("stream_error", "failed to start stream server"); return false; }
+
+  String u = _s.url();
+  String txt = "streaming at " + u;
+  out.success(txt);   // copied: txt is gone when the reply is serialized
+  JsonObject a = out.addAsset();
+  a["kind"] = "stream";
+  a["mime"] = "multipart/x-mixed-replace";
+  a["url"]  = u;
+  a["fps"]  = fps;
+  return true;
+}
@@ -0,0 +1,230 @@
+#include "dio_event_tool.h"
+#include <string.h>
+#include "mcp_log.h"
+
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+
+struct DioEventTool::Batch {
+  ObservationBuilder ob;
+  uint8_t n = 0;
+};
+
+DioEventTool::DioEventTool(const DioPins& pins, const char* name)
+: EventTool(name, "Digital input edges (rise/fall), interrupt-captured with microsecond timestamps") {
+  _npins = pins.n;
+  for (uint8_t i=0; i<_npins; i++) {
+    _track[i].self = this;
+    _track[i].idx = i;
+    _track[i].gpio = pins.gpio[i];
+  }
+}
+
+// Runs for every CHANGE on a watched pin: timestamp, level, push. Nothing else.
+void IRAM_ATTR DioEventTool::_isr(void* arg){
+  Track* k = static_cast<Track*>(arg);
+  DioEventTool* self = k->self;
+  Edge* e = self->_ring.beginPush();
+  if (!e) { self->_overflow = self->_overflow + 1; return; }
+  e->t_us = micros();
+  e->idx = k->idx;
+  e->level = (uint8_t)digitalRead(k->gpio);
+  self->_ring.commitPush();
+}
+
+void DioEventTool::buildExtraParameters(JsonObject& props){
+  props["pins"]["type"] = "array";              // default: every pin in signals.pins
+  props["pins"]["items"]["type"] = "integer";
+  props["edge"]["type"] = "string";
+  auto e = props["edge"].createNestedArray("enum");
+  e.add("rise"); e.add("fall"); e.add("both");
+  props["debounce_us"]["type"] = "integer";     // level must hold this long (default DIO_DEBOUNCE_US)
+  props["min_pulse_us"]["type"] = "integer";    // shorter pulses are dropped, both edges
+  props["max_per_sec"]["type"] = "integer";     // rate cap on reported edges (0 = none)
+  props["pull"]["type"] = "string";
+  auto p = props["pull"].createNestedArray("enum");
+  p.add("none"); p.add("up"); p.add("down");
+}
+
+void DioEventTool::buildSignals(JsonObject& signals){
+  auto ev = signals.createNestedArray("event_types");
+  ev.add("dio.rise");
+  ev.add("dio.fall");
+  auto pins = signals.createNestedArray("pins");
+  for (uint8_t i=0; i<_npins; i++) pins.add(_track[i].gpio);
+}
+
+void DioEventTool::_detachAll(){
+  for (uint8_t i=0; i<_npins; i++) {
+    if (_track[i].watched) detachInterrupt(_track[i].gpio);
+    _track[i].watched = false;
+  }
+  while (_ring.front()) _ring.pop();   // ISR is off: we may discard what it left
+}
+
+bool DioEventTool::onSubscribe(JsonObjectConst args, ObservationBuilder& out){
+  bool want[DIO_MAX_PINS] = {false};
+  JsonArrayConst pins = args["pins"];
+  if (pins.isNull() || pins.size() == 0) {
+    for (uint8_t i=0; i<_npins; i++) want[i] = true;
+  } else {
+    for (JsonVariantConst v : pins) {
+      int g = v | -1;
+      uint8_t i = 0;
+      while (i < _npins && _track[i].gpio != g) i++;
+      if (i == _npins) { out.error("bad_pin", "pin not available to this tool (see signals.pins)"); return false; }
+      want[i] = true;
+    }
+  }
+
+  const char* edge = args["edge"] | "both";
+  uint8_t edges = strcmp(edge, "rise") == 0 ? EdgeRise : strcmp(edge, "fall") == 0 ? EdgeFall
+                : strcmp(edge, "both") == 0 ? EdgeBoth : 0;
+  if (!edges) { out.error("bad_request", "edge must be rise, fall or both"); return false; }
+
+  const char* pull = args["pull"] | "none";
+  uint8_t mode = strcmp(pull, "up") == 0 ? INPUT_PULLUP : strcmp(pull, "down") == 0 ? INPUT_PULLDOWN : INPUT;
+
+  const uint32_t debounce = args["debounce_us"] | (uint32_t)DIO_DEBOUNCE_US;
+  const uint32_t minPulse = args["min_pulse_us"] | 0u;
+  const uint32_t perSec = args["max_per_sec"] | 0u;
+
+  // re-subscribe replaces the previous filters
+  _detachAll();
+  _edges = edges;
+  _hold_us = debounce > minPulse ? debounce : minPulse;
+  _max_per_sec = perSec > 0xFFFF ? 0xFFFF : (uint16_t)perSec;
+  _tokens = (uint32_t)_max_per_sec * 1000u;
+  _refill_ms = millis();
+  _limited = 0;
+  _overflowSeen = _overflow;
+
+  const uint32_t now_us = micros();
+  auto a = out.addAsset();
+  a["kind"] = "subscription";
+  a["hold_us"] = _hold_us;
+  auto levels = a.createNestedObject("levels");   // starting point for counting
+  for (uint8_t i=0; i<_npins; i++) {
+    if (!want[i]) continue;
+    Track& k = _track[i];
+    pinMode(k.gpio, mode);
+    k.level = (uint8_t)digitalRead(k.gpio);
+    k.pending = false;
+    k.lastUs = now_us;
+    k.rises = k.falls = 0;
+    k.watched = true;
+    // attached from the tool task, so the GPIO ISR (and every push) runs on the same core
+    attachInterruptArg(k.gpio, &DioEventTool::_isr, &k, CHANGE);
+    char key[4];
+    snprintf(key, sizeof(key), "%u", (unsigned)k.gpio);
+    levels[key] = k.level;
+  }
+  _active = true;
+  MCP_LOGI("DIO", "subscribed edge=%s hold=%luus cap=%u/s", edge, (unsigned long)_hold_us, (unsigned)_max_per_sec);
+  out.success("subscribed (dio edges)");
+  return true;
+}
+
+bool DioEventTool::onUnsubscribe(JsonObjectConst /*args*/, ObservationBuilder& out){
+  // final totals, then stop the interrupts
+  for (uint8_t i=0; i<_npins; i++) {
+    const Track& k = _track[i];
+    if (!k.watched) continue;
+    auto a = out.addAsset();
+    a["kind"] = "count";
+    a["pin"] = k.gpio;
+    a["rises"] = k.rises;
+    a["falls"] = k.falls;
+  }
+  _detachAll();
+  _active = false;
+  out.success("unsubscribed");
+  return true;
+}
+
+bool DioEventTool::_admit(){
+  if (!_max_per_sec) return true;
+  if (_tokens < 1000u) { _limited++; return false; }
+  _tokens -= 1000u;
+  return true;
+}
+
+void DioEventTool::_accept(Track& k, uint32_t t_us, Batch& b){
+  k.level ^= 1;
+  k.pending = false;
+  const uint32_t width = t_us - k.lastUs;
+  k.lastUs = t_us;
+  const bool rise = k.level;
+  const uint32_t count = rise ? ++k.rises : ++k.falls;
+  if (!(_edges & (rise ? EdgeRise : EdgeFall))) return;
+  if (!_admit()) return;
+
+  auto a = b.ob.addAsset();
+  a["kind"] = "event";
+  a["event_type"] = rise ? "dio.rise" : "dio.fall";
+  a["pin"] = k.gpio;
+  a["value"] = k.level;
+  a["t_us"] = t_us;
+  a["width_us"] = width;
+  a["count"] = count;
+  if (++b.n >= DIO_BATCH_MAX) _flush(b);
+}
+
+// Stability debounce on the raw stream: a change is only accepted once nothing has
+// moved it back for _hold_us; a bounce back to the debounced level cancels it.
+void DioEventTool::_raw(const Edge& e, Batch& b){
+  Track& k = _track[e.idx];
+  if (!k.watched) return;
+  if (k.pending && e.t_us - k.pendUs >= _hold_us) _accept(k, k.pendUs, b);
+  if (e.level == k.level) { k.pending = false; return; }
+  k.pending = true;
+  k.pendUs = e.t_us;             // repeated level (missed opposite edge) restarts the hold
+  if (!_hold_us) _accept(k, e.t_us, b);
+}
+
+void DioEventTool::_flush(Batch& b){
+  const uint32_t ovf = _overflow;
+  const bool stats = ovf != _overflowSeen || _limited;
+  if (!b.n && !stats) return;
+  if (stats) {
+    auto a = b.ob.addAsset();
+    a["kind"] = "stats";
+    a["overflow"] = ovf - _overflowSeen;   // raw edges lost (ring full): counts may be short
+    a["rate_limited"] = _limited;
+    _overflowSeen = ovf;
+    _limited = 0;
+  }
+  char txt[24];
+  snprintf(txt, sizeof(txt), "%u dio edge(s)", (unsigned)b.n);
+  b.ob.success(txt);
+  b.ob.setDelivery(ObservationBuilder::Delivery::Urgent);
+  emitNow(b.ob);                 // serialized here, before txt goes out of scope
+  b.ob.reset();
+  b.n = 0;
+}
+
+void DioEventTool::tick(uint32_t now_ms){
+  if (!_active) return;
+  if (_max_per_sec) {
+    const uint32_t cap = (uint32_t)_max_per_sec * 1000u;
+    const uint32_t dt = now_ms - _refill_ms;
+    const uint32_t add = (dt >= 1000u ? 1000u : dt) * _max_per_sec;   // a full second refills the bucket
+    _tokens = _tokens + add >= cap ? cap : _tokens + add;
+    _refill_ms = now_ms;
+  }
+
+  // now first: every edge stamped before it is already in the ring
+  const uint32_t now_us = micros();
+  bool work = _ring.front() || _overflow != _overflowSeen;
+  for (uint8_t i=0; i<_npins && !work; i++) work = _track[i].pending;
+  if (!work) return;             // quiet line: no pooled doc taken
+
+  Batch b;
+  while (Edge* e = _ring.front()) { _raw(*e, b); _ring.pop(); }
+  for (uint8_t i=0; i<_npins; i++) {
+    Track& k = _track[i];
+    if (k.watched && k.pending && (int32_t)(now_us - k.pendUs) >= (int32_t)_hold_us) _accept(k, k.pendUs, b);
+  }
+  _flush(b);
+}
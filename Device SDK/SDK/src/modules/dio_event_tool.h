@@ -0,0 +1,97 @@
+#pragma once
+#include <Arduino.h>
+#include <initializer_list>
+#include "event_tool.h"
+#include "spsc_queue.h"
+
+#ifndef DIO_MAX_PINS
+#define DIO_MAX_PINS 4          // inputs one tool instance can watch
+#endif
+#ifndef DIO_RING
+#define DIO_RING 256            // raw edges buffered between drains (power of two)
+#endif
+#ifndef DIO_DRAIN_MS
+#define DIO_DRAIN_MS 5          // tick period while subscribed: reporting latency, not timestamp accuracy
+#endif
+#ifndef DIO_BATCH_MAX
+#define DIO_BATCH_MAX 8         // edge assets per observation (fits DOC_POOL_LARGE_BYTES / RUNTIME_OBS_BYTES)
+#endif
+#ifndef DIO_DEBOUNCE_US
+#define DIO_DEBOUNCE_US 1000    // default settle time; 0 for clean push-pull signals
+#endif
+
+// GPIOs a DioEventTool may attach to (fixed at build time; a subscription picks a subset):
+//   static ToolTable<..., DioEventTool> table(..., DioPins{4, 5});
+struct DioPins {
+  uint8_t gpio[DIO_MAX_PINS] = {0};
+  uint8_t n = 0;
+  DioPins(std::initializer_list<uint8_t> pins){ for (uint8_t p : pins) if (n < DIO_MAX_PINS) gpio[n++] = p; }
+};
+
+// Interrupt-driven digital inputs: every edge is captured, none is polled for.
+// - a CHANGE interrupt per pin stores {micros(), level} in an SPSC ring and returns; all pins
+//   share the one GPIO interrupt, so the ISR side is a single producer
+// - tick() drains the ring every DIO_DRAIN_MS on the tool task and debounces there: an edge is
+//   accepted once its level has held for max(debounce_us, min_pulse_us), so contact chatter and
+//   pulses shorter than min_pulse_us disappear as a pair. Accepted edges keep the ISR timestamp.
+// - subscribe args: pins, edge (rise|fall|both), debounce_us, min_pulse_us, max_per_sec, pull
+// - accepted edges go out in batches of up to DIO_BATCH_MAX assets per observation:
+//     {"kind":"event","event_type":"dio.rise","pin":4,"value":1,"t_us":..,"width_us":..,"count":..}
+//   width_us: how long the previous level lasted; count: accepted edges of that type on that pin
+//   since subscribe. count also advances for edges withheld by the edge filter or rate cap, so
+//   totals stay exact; withheld/overflowed edges are reported in a {"kind":"stats"} asset.
+// There is no hardware glitch filter on the classic ESP32; put an RC on noisy contacts and use
+// debounce_us for the rest. Tool task only (subscribe, tick); the ISR touches only the ring.
+class DioEventTool : public EventTool {
+public:
+  explicit DioEventTool(const DioPins& pins, const char* name = "digital_event");
+
+  void buildExtraParameters(JsonObject& props) override;
+  void buildSignals(JsonObject& signals) override;
+  bool onSubscribe(JsonObjectConst args, ObservationBuilder& out) override;
+  bool onUnsubscribe(JsonObjectConst args, ObservationBuilder& out) override;
+
+  uint32_t nextTickMs(uint32_t now_ms) override { return _active ? now_ms + DIO_DRAIN_MS : TICK_IDLE; }
+  void tick(uint32_t now_ms) override;
+
+private:
+  enum : uint8_t { EdgeRise = 1, EdgeFall = 2, EdgeBoth = 3 };
+
+  struct Edge { uint32_t t_us; uint8_t idx; uint8_t level; };
+
+  // Per pin: gpio/idx/self are read by the ISR, the rest is tool-task state
+  struct Track {
+    DioEventTool* self = nullptr;
+    uint8_t idx = 0;
+    uint8_t gpio = 0;
+    bool watched = false;
+    uint8_t level = 0;          // debounced level
+    bool pending = false;       // raw level differs from `level` since pendUs
+    uint32_t pendUs = 0;
+    uint32_t lastUs = 0;        // last accepted edge (start of width_us)
+    uint32_t rises = 0, falls = 0;
+  };
+
+  struct Batch;
+
+  static void _isr(void* arg);
+  void _detachAll();
+  void _raw(const Edge& e, Batch& b);
+  void _accept(Track& k, uint32_t t_us, Batch& b);
+  bool _admit();
+  void _flush(Batch& b);
+
+  Track _track[DIO_MAX_PINS];
+  uint8_t _npins = 0;
+  SpscQueue<Edge, DIO_RING> _ring;
+  volatile uint32_t _overflow = 0;   // ISR: ring full
+  uint32_t _overflowSeen = 0;
+
+  bool _active = false;
+  uint8_t _edges = EdgeBoth;
+  uint32_t _hold_us = DIO_DEBOUNCE_US;
+  uint16_t _max_per_sec = 0;         // 0 = no cap
+  uint32_t _tokens = 0;              // in 1/1000 of an edge
+  uint32_t _refill_ms = 0;
+  uint32_t _limited = 0;             // withheld by the rate cap since the last report
+};
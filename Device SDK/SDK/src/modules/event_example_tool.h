@@ -45,6 +45,11 @@ public:
     return true;
   }
 
+  // TickScheduler: only woken when the next event is due
+  uint32_t nextTickMs(uint32_t /*now_ms*/) override {
+    return active_ ? last_emit_ms_ + interval_ms_ : TICK_IDLE;
+  }
+
   void tick(uint32_t now_ms) override {
     if (!active_) return;
     if (now_ms - last_emit_ms_ < interval_ms_) return;
@@ -1,27 +1,13 @@
 #pragma once
 #include <Arduino.h>
 #include <FastLED.h>
+#include "led_bus.h"   // 스트립 소유/전송은 LedBus가 전담
 
 #if defined(ESP32)
   #include "freertos/FreeRTOS.h"
   #include "freertos/task.h"
 #endif
-
-#ifndef LED_PIN
-#define LED_PIN     6
-#endif
-#ifndef NUM_LEDS
-#define NUM_LEDS    12
-#endif
-#ifndef LED_TYPE
-#define LED_TYPE    WS2812B
-#endif
-#ifndef COLOR_ORDER
-#define COLOR_ORDER GRB
-#endif
-
-// 전역 LED 버퍼
-static CRGB leds[NUM_LEDS];
+#include <math.h>
 
 class EyeController {
 public:
@@ -36,7 +22,7 @@ public:
     uint16_t holdMs        =  80;   // 유지
     uint16_t openMs        = 160;   // 뜨기
     uint8_t  baseBrightness= 100;   // 기본 밝기
-    uint16_t tickMs        = 16;    // 태스크 주기(~60fps)
+    uint16_t tickMs        = 16;    // 애니메이션 중 프레임 주기(~60fps), Idle에선 다음 블링크까지 잠듦
 
     // 연출 옵션
     bool     eyelidSweep   = true;  // true면 눈꺼풀 스윕 사용
@@ -56,10 +42,10 @@ public:
 
   void begin() {
     if (_inited) return;
-    FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
-    FastLED.setBrightness(cfg.baseBrightness);
-    FastLED.clear(true);
-    setMood(Mood::Neutral, /*immediateShow=*/true);
+    LedBus::instance().begin();
+    _buildHeightLut();
+    setMood(Mood::Neutral);
+    _renderOpen();
 
     randomSeed((uint32_t)micros());
     _scheduleNextBlink(millis(), /*immediate=*/false);
@@ -67,8 +53,9 @@ public:
     _startBackgroundTask();
   }
 
-  void update() {
-    if (!_inited) return;
+  // 한 스텝 진행 후, 다음 호출까지 기다려도 되는 시간(ms)을 돌려줌
+  uint32_t update() {
+    if (!_inited) return cfg.tickMs;
     const uint32_t now = millis();
 
     switch (_phase) {
@@ -76,7 +63,8 @@ public:
         if ((int32_t)(now - _nextDue) >= 0) {
           _startPhase(BlinkPhase::Closing, now);
         } else {
-          _renderOpen();
+          _renderOpen();   // 무드 변경시에만 실제 제출/전송
+          return (uint32_t)(_nextDue - now);
         }
         break;
 
@@ -114,16 +102,25 @@ public:
         }
       } break;
     }
+    return cfg.tickMs;
   }
 
+  // MQTT 콜백 등 다른 태스크에서 호출 가능: 색만 바꾸고 렌더는 블링크 태스크가 담당
   void setMood(Mood m, bool immediateShow = false) {
-    _mood = m;
+    CRGB c;
     switch (m) {
-      case Mood::Neutral:  _color = CRGB(0, 255, 0);   break; // 초록
-      case Mood::Annoyed:  _color = CRGB(255, 255, 0); break; // 노랑
-      case Mood::Angry:    _color = CRGB(255, 0, 0);   break; // 빨강
+      case Mood::Neutral:  c = CRGB(0, 255, 0);   break; // 초록
+      case Mood::Annoyed:  c = CRGB(255, 255, 0); break; // 노랑
+      case Mood::Angry:    c = CRGB(255, 0, 0);   break; // 빨강
     }
-    if (immediateShow && _phase == BlinkPhase::Idle) _renderOpen();
+    _lock();
+    _mood = m;
+    _color = c;
+    _unlock();
+#if defined(ESP32)
+    if (_taskHandle) { xTaskNotifyGive(_taskHandle); return; }  // 잠든 태스크 깨워 바로 반영
+#endif
+    if (immediateShow && _inited && _phase == BlinkPhase::Idle) _renderOpen();
   }
 
   Mood currentMood() const { return _mood; }
@@ -132,8 +129,10 @@ private:
   EyeController() {}
   bool _inited = false;
 
-  Mood _mood = Mood::Neutral;
-  CRGB _color = CRGB(0, 255, 0);
+  volatile Mood _mood = Mood::Neutral;
+  CRGB _color = CRGB(0, 255, 0);       // _mux 보호 (setMood ↔ 렌더 태스크)
+  uint8_t _heightLut[NUM_LEDS] = {0};  // LED별 세로 높이 (255=맨 위, 0=맨 아래), begin()에서 계산
+  CRGB _px[NUM_LEDS];                  // 눈 레이어 (LedBus z=0에 제출)
 
   BlinkPhase _phase = BlinkPhase::Idle;
   uint32_t _phaseStart = 0;
@@ -142,8 +141,16 @@ private:
 
 #if defined(ESP32)
   TaskHandle_t _taskHandle = nullptr;
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+  void _lock()   { portENTER_CRITICAL(&_mux); }
+  void _unlock() { portEXIT_CRITICAL(&_mux); }
+#else
+  void _lock()   {}
+  void _unlock() {}
 #endif
 
+  CRGB _currentColor() { _lock(); CRGB c = _color; _unlock(); return c; }
+
   // ---- 타이밍 ----
   void _startPhase(BlinkPhase p, uint32_t now) { _phase = p; _phaseStart = now; }
 
@@ -175,77 +182,82 @@ private:
   }
 
   // ---- 렌더링 (양쪽 눈꺼풀) ----
-  void _renderOpen() { _renderBothLids(/*openRatio=*/1.0f); }
+  void _renderOpen() { _renderBothLids(/*openQ8=*/255); }
 
   void _renderByPhase(uint8_t scale /*0..255*/) {
     if (!cfg.eyelidSweep) { // 전체 페이드로 되돌리고 싶을 때
-      CRGB c = _color; c.nscale8_video(scale);
-      fill_solid(leds, NUM_LEDS, c);
-      FastLED.show();
+      CRGB c = _currentColor(); c.nscale8_video(scale);
+      bool dirty = false;
+      for (uint8_t i = 0; i < NUM_LEDS; ++i) {
+        if (_px[i] != c) { _px[i] = c; dirty = true; }
+      }
+      if (dirty) _submit();
       return;
     }
-    float openRatio = scale / 255.0f; // 0.0 닫힘 ~ 1.0 열림
-    _renderBothLids(openRatio);
+    _renderBothLids(scale); // 0 닫힘 ~ 255 열림
+  }
+
+  // 인덱스 → 각도(위=0 rad, 아래=π rad) → 높이 h = (cos θ + 1)/2, 0..255로 양자화
+  void _buildHeightLut() {
+    for (uint8_t i = 0; i < NUM_LEDS; ++i) {
+      int16_t di = (int16_t)i - (int16_t)cfg.topIndex;
+      di %= (int16_t)NUM_LEDS; if (di < 0) di += NUM_LEDS;
+      float theta = (2.0f * PI) * ((float)di / (float)NUM_LEDS);
+      _heightLut[i] = (uint8_t)lroundf((cosf(theta) + 1.0f) * 0.5f * 255.0f);
+    }
   }
 
   /**
-   * 양쪽 눈꺼풀 스윕:
-   * - 각 LED의 "세로 높이" h ∈ [0..1] 계산 (1=맨 위, 0=맨 아래)
-   * - 열림 비율 openRatio에 따라 가운데 띠 [low, high]만 보이게 함.
-   *   low  = (1 - openRatio) / 2
-   *   high = 1 - low
+   * 양쪽 눈꺼풀 스윕 (정수 연산, 높이는 _heightLut):
+   * - 열림 비율 openQ8(0..255)에 따라 가운데 띠 [low, high]만 보이게 함.
+   *   low  = (255 - openQ8) / 2
+   *   high = 255 - low
    * - featherLEDs로 low/high 경계를 부드럽게.
+   * - 픽셀 값이 실제로 바뀐 경우에만 _submit() (WS2812B 전송 중엔 인터럽트가 막힘)
    */
-  void _renderBothLids(float openRatio) {
-    const float low  = (1.0f - openRatio) * 0.5f;
-    const float high = 1.0f - low;
+  void _renderBothLids(uint8_t openQ8) {
+    const int16_t low  = (255 - openQ8) / 2;
+    const int16_t high = 255 - low;
 
-    // feather를 'LED 개수'에서 '높이 스케일(0..1)'로 변환
-    const float feather = (cfg.featherLEDs > 0) ? (float)cfg.featherLEDs / (float)NUM_LEDS : 0.0f;
+    // feather를 'LED 개수'에서 '높이 스케일(0..255)'로 변환
+    const int16_t feather = (int16_t)((cfg.featherLEDs * 255U) / NUM_LEDS);
+    const CRGB color = _currentColor();
 
+    bool dirty = false;
     for (uint8_t i = 0; i < NUM_LEDS; ++i) {
-      // 인덱스 → 각도(위=0 rad, 아래=π rad)
-      int16_t di = (int16_t)i - (int16_t)cfg.topIndex;
-      // 모듈러 정규화
-      di %= (int16_t)NUM_LEDS; if (di < 0) di += NUM_LEDS;
-      float theta = (2.0f * PI) * ((float)di / (float)NUM_LEDS); // 0..2π, 위=0
-
-      // 세로 높이 h: 1(위) ↔ 0(아래)
-      float h = (cosf(theta) + 1.0f) * 0.5f;
+      const int16_t h = _heightLut[i];
 
       // 가운데 띠 [low, high] 안이면 켜짐, 바깥이면 꺼짐, feather로 스무딩
-      float lit = 0.0f;
+      uint8_t lit = 0;
       if (h >= (low + feather) && h <= (high - feather)) {
-        lit = 1.0f; // 완전 켜짐
-      } else if (feather > 0.0f) {
+        lit = 255; // 완전 켜짐
+      } else if (feather > 0) {
         // 아래 경계 스무딩
-        if (h > low && h < (low + feather)) {
-          float t = (h - low) / feather; // 0..1
-          if (t < 0) t = 0; if (t > 1) t = 1;
-          lit = t;
-        }
-        // 위 경계 스무딩
+        if (h > low && h < (low + feather)) lit = (uint8_t)(((h - low) * 255) / feather);
+        // 위 경계 스무딩 (양쪽 경계가 겹치면 더 밝은 쪽 사용)
         if (h < high && h > (high - feather)) {
-          float t = (high - h) / feather; // 0..1
-          if (t < 0) t = 0; if (t > 1) t = 1;
-          // 양쪽 경계가 겹치면 더 낮은 쪽 사용
-          lit = max(lit, t);
+          uint8_t t = (uint8_t)(((high - h) * 255) / feather);
+          if (t > lit) lit = t;
         }
       }
 
-      CRGB c = _color;
-      c.nscale8_video((uint8_t)(lit * 255.0f));
-      leds[i] = c;
+      CRGB c = color;
+      c.nscale8_video(lit);
+      if (_px[i] != c) { _px[i] = c; dirty = true; }
     }
-    FastLED.show();
+    if (dirty) _submit();
   }
 
+  // 픽셀이 바뀐 경우에만 LedBus에 레이어 제출 (전송은 LedBus 태스크가 1프레임 1회)
+  void _submit() { LedBus::instance().pixels("eyes", /*z=*/0, _px, cfg.baseBrightness); }
+
   // ---- 백그라운드 태스크 ----
   static void _taskLoop(void* pv) {
     EyeController* self = static_cast<EyeController*>(pv);
     for (;;) {
-      self->update();
-      vTaskDelay(pdMS_TO_TICKS(self->cfg.tickMs));
+      uint32_t waitMs = self->update();
+      // 다음 블링크(또는 다음 프레임)까지 잠듦; setMood(immediateShow)가 알림으로 깨움
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs ? waitMs : 1));
     }
   }
 
@@ -1,14 +1,21 @@
 #include "hooks.h"
 #include "registry.h"
+#include "tool_table.h"
 #include "modules/express_emotion_tool.h"
+#if defined(DIO_PINS)
+#include "modules/dio_event_tool.h"      // 실제 GPIO 인터럽트 (-D DIO_PINS=4,5)
+#else
 #include "modules/event_example_tool.h"  // ← 추가
+#endif
 
 void register_tools(ToolRegistry& reg, const ToolConfig& cfg){
-  // ACTION tool
-  auto* emotion = new ExpressEmotionTool();
-  reg.add(emotion);
-  
-  // EVENT tool (pin은 사용 안 하지만 생성자 요구)
-  auto* digitalEvent = new ExampleDigitalEvent(0);
-  reg.add(digitalEvent);
+  // 정적 저장소에 툴 배치 (new 없음)
+  //  - ACTION: ExpressEmotionTool
+  //  - EVENT : DioEventTool (DIO_PINS 지정 시), 아니면 ExampleDigitalEvent (pin은 사용 안 하지만 생성자 요구)
+#if defined(DIO_PINS)
+  static ToolTable<ExpressEmotionTool, DioEventTool> table(ExpressEmotionTool(), DioPins{DIO_PINS});
+#else
+  static ToolTable<ExpressEmotionTool, ExampleDigitalEvent> table(ExpressEmotionTool(), 0);
+#endif
+  table.registerAll(reg);
 }
\ No newline at end of file
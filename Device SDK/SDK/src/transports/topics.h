@@ -3,4 +3,21 @@
 inline String topicAnnounce(const String& id){ return String("mcp/dev/")+id+ "/announce"; }
 inline String topicStatus  (const String& id){ return String("mcp/dev/")+id+ "/status"; }
 inline String topicCmd     (const String& id){ return String("mcp/dev/")+id+ "/cmd"; }
-inline String topicEvents  (const String& id){ return String("mcp/dev/")+id+ "/events"; }
\ No newline at end of file
+inline String topicEvents  (const String& id){ return String("mcp/dev/")+id+ "/events"; }
+// MessagePack variants (same messages, binary encoding)
+inline String topicCmdMp   (const String& id){ return topicCmd(id)   + ".mp"; }
+inline String topicEventsMp(const String& id){ return topicEvents(id)+ ".mp"; }
+// Binary asset chunks (asset transport "mqtt"): mcp/dev/<id>/assets/<asset_id>
+inline String topicAsset   (const String& id, const char* asset_id){ return String("mcp/dev/")+id+ "/assets/" + asset_id; }
+inline String topicMetrics (const String& id){ return String("mcp/dev/")+id+ "/metrics"; }
+
+// All of a device's topics, built once (the hot paths publish without building Strings).
+// Asset topics are <assets><asset_id>.
+struct DeviceTopics {
+  String announce, status, cmd, cmdMp, events, eventsMp, metrics, assets;
+  DeviceTopics() {}
+  explicit DeviceTopics(const String& id)
+  : announce(topicAnnounce(id)), status(topicStatus(id)), cmd(topicCmd(id)), cmdMp(topicCmdMp(id)),
+    events(topicEvents(id)), eventsMp(topicEventsMp(id)), metrics(topicMetrics(id)),
+    assets(String("mcp/dev/")+id+ "/assets/") {}
+};
@@ -50,7 +50,7 @@ public:
     doc["mood"] = moodStr;
     String payload;
     serializeJson(doc, payload);
-    out.success(payload.c_str());
+    out.success(payload);   // String overload: copied, the reply is serialized after invoke()
     return true;
   }
 };
@@ -2,24 +2,16 @@
 #include <Arduino.h>
 #include <FastLED.h>
 #include "tool.h"
+#include "led_bus.h"   // 공용 스트립 (LED_PIN/NUM_LEDS 설정도 여기)
 
-// LED 설정
-#define LED_PIN     6
-#define NUM_LEDS    12
-#define LED_TYPE    WS2812B
-#define COLOR_ORDER GRB
-
-static CRGB leds[NUM_LEDS];  // 공용 버퍼
+// LED_On/LED_Off가 쓰는 LedBus 레이어 (눈 레이어 z=0 위에 덮음)
+#define LED_TOOL_LAYER "led_tool"
+#define LED_TOOL_Z     10
 
 // ==================== LED ON Tool ====================
 class LedOnTool : public ITool {
 public:
-  bool init() override {
-    FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
-    FastLED.clear();
-    FastLED.show();
-    return true;
-  }
+  bool init() override { return LedBus::instance().begin(); }
 
   const char* name() const override { return "LED_On"; }
 
@@ -34,6 +26,10 @@ public:
     props["g"]["type"] = "string";
     props["b"]["type"] = "string";
     props["brightness"]["type"] = "string";
+    props["mode"]["type"] = "string";        // solid(기본) | blink | fade
+    auto modes = props["mode"].createNestedArray("enum");
+    modes.add("solid"); modes.add("blink"); modes.add("fade");
+    props["period_ms"]["type"] = "string";   // blink 주기 / fade 시간 (기본 1000)
   }
 
   bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
@@ -46,10 +42,17 @@ public:
     int g = atoi(gStr);
     int b = atoi(bStr);
     int br = constrain(atoi(brStr), 0, 255);
+    const char* mode = args["mode"] | "solid";
+    uint16_t period = (uint16_t)constrain(atoi(args["period_ms"] | "1000"), 0, 60000);
 
-    fill_solid(leds, NUM_LEDS, CRGB(r, g, b));
-    FastLED.setBrightness(br);
-    FastLED.show();
+    // 렌더/전송은 LedBus 태스크가 담당 (여기서 show() 안 함)
+    LedBus& bus = LedBus::instance();
+    CRGB c(r, g, b);
+    bool ok;
+    if      (strcmp(mode, "blink") == 0) ok = bus.blink(LED_TOOL_LAYER, LED_TOOL_Z, c, period, br);
+    else if (strcmp(mode, "fade")  == 0) ok = bus.fade(LED_TOOL_LAYER, LED_TOOL_Z, CRGB::Black, c, period, br);
+    else                                 ok = bus.solid(LED_TOOL_LAYER, LED_TOOL_Z, c, br);
+    if (!ok) { out.error("busy", "no free LED layer"); return false; }
     out.success("LED 켜짐");
     return true;
   }
@@ -58,11 +61,7 @@ public:
 // ==================== LED OFF Tool ====================
 class LedOffTool : public ITool {
 public:
-  bool init() override {
-    FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS);
-    FastLED.show();
-    return true;
-  }
+  bool init() override { return LedBus::instance().begin(); }
 
   const char* name() const override { return "LED_Off"; }
 
@@ -74,8 +73,8 @@ public:
   }
 
   bool invoke(JsonObjectConst /*args*/, ObservationBuilder& out) override {
-    FastLED.clear();
-    FastLED.show();
+    // LED_On 레이어만 내림 (다른 툴 레이어, 예: 눈은 유지)
+    LedBus::instance().remove(LED_TOOL_LAYER);
     out.success("LED 끔");
     return true;
   }
@@ -0,0 +1,212 @@
+#pragma once
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_MPU6050.h>
+#include <math.h>
+#include <atomic>
+#include "spsc_queue.h"
+
+#if defined(ESP32)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+#endif
+
+#ifndef IMU_RATE_HZ
+#define IMU_RATE_HZ 200          // MPU6050 샘플레이트 (FIFO에 고정 주기로 적재)
+#endif
+#ifndef IMU_RING_SAMPLES
+#define IMU_RING_SAMPLES 2048    // 2의 거듭제곱, 200Hz면 약 10초
+#endif
+#ifndef IMU_DRAIN_MS
+#define IMU_DRAIN_MS 20          // FIFO 비우는 주기 (1024B FIFO라 여유 충분)
+#endif
+#ifndef IMU_IMPACT_QUEUE
+#define IMU_IMPACT_QUEUE 8       // 루프가 꺼내가기 전까지 보관할 충격 이벤트 수 (2의 거듭제곱)
+#endif
+
+// 히트 판정 (기존 6초 창 로직을 샘플 단위로 증분 실행)
+// - 변화량 dA는 10ms 전 샘플과 비교 (기존 100Hz 튜닝값 유지)
+// - 휘두름 속도는 중력 편차를 dt만큼 누적, 충돌 시 리셋
+struct ImpactDetector {
+  static constexpr float G = 9.81f;
+  static constexpr uint8_t LAG = (IMU_RATE_HZ / 100) ? (IMU_RATE_HZ / 100) : 1;
+
+  float hist[LAG] = {};
+  uint8_t pos = 0;
+  bool primed = false;
+  float swing = 0.0f;
+  bool inHit = false;
+
+  // true면 이 샘플에서 새 히트 시작, impact에 강도
+  bool step(float acc, float& impact){
+    if (!primed) { for (auto& h : hist) h = G; primed = true; }
+    const float dt = 1.0f / IMU_RATE_HZ;
+    float dev = fabsf(acc - G);
+    if (dev > 2.0f) swing += dev * dt;          // 작은 진동은 무시
+
+    float dA = fabsf(acc - hist[pos]);
+    hist[pos] = acc; pos = (pos + 1) % LAG;
+
+    if (!inHit && dA > 35.0f) {
+      inHit = true;
+      impact = dA + swing * 10.0f;              // 순간 변화량 + 휘두름 영향
+      swing = 0.0f;
+      return true;
+    }
+    if (inHit && dA < 12.0f) inHit = false;
+    return false;
+  }
+
+  static const char* intensity(float maxImpact){
+    return (maxImpact < 40.0f)  ? "gentle" :
+           (maxImpact < 80.0f)  ? "normal" :
+           (maxImpact < 150.0f) ? "hard"   : "brutal";
+  }
+  static const char* hitsLabel(int hits){
+    return (hits <= 0) ? "none" : (hits == 1) ? "single" : (hits <= 3) ? "few" : "flurry";
+  }
+};
+
+// MPU6050 백그라운드 샘플러
+// - 센서가 FIFO에 IMU_RATE_HZ로 가속도를 쌓고, 태스크가 IMU_DRAIN_MS마다 비움
+//   (태스크 지터와 무관하게 샘플 간격 고정)
+// - |a| 를 0.01 m/s² 단위로 링에 기록: 쓰는 쪽은 태스크 하나, 읽는 쪽은 head만 보고 복사 (lock-free,
+//   head는 release/acquire라 다른 코어에서도 공개된 샘플만 읽음)
+// - 같은 태스크에서 ImpactDetector를 돌려 충격을 SpscQueue에 넣음 → EventTool이 loop()에서 꺼내 emit
+// - 샘플 시각은 FIFO 안의 위치로 역산 (마지막 샘플 = 읽은 시각, 앞 샘플은 1/IMU_RATE_HZ씩 이전)
+class ImuSampler {
+public:
+  struct Impact { uint32_t t_ms; float strength; };
+  struct Summary { int hits = 0; float maxImpact = 0.0f; float peakAcc = 0.0f; uint32_t samples = 0; };
+
+  static ImuSampler& instance(){ static ImuSampler s; return s; }
+
+  bool begin(uint8_t sda, uint8_t scl){
+    if (_ok) return true;
+    Wire.begin(sda, scl);
+    delay(50);
+    if (!_mpu.begin()) return false;
+    _mpu.setAccelerometerRange(MPU6050_RANGE_8_G);
+    _mpu.setGyroRange(MPU6050_RANGE_500_DEG);
+    _mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);          // DLPF on → 내부 1kHz
+    _mpu.setSampleRateDivisor((uint8_t)(1000 / IMU_RATE_HZ - 1));
+    // FIFO: 가속도만 (6B/샘플)
+    _writeReg(REG_USER_CTRL, 0x04);   // FIFO reset
+    _writeReg(REG_FIFO_EN, 0x08);     // ACCEL_FIFO_EN
+    _writeReg(REG_USER_CTRL, 0x40);   // FIFO_EN
+    _ok = true;
+#if defined(ESP32)
+    xTaskCreate(&_taskLoop, "ImuSampler", 3072, this, 2, &_task);
+#endif
+    return true;
+  }
+
+  bool ready() const { return _ok; }
+  uint32_t total() const { return _head.load(std::memory_order_acquire); }   // 지금까지 기록된 샘플 수
+  uint32_t lastMs() const { return _lastMs.load(std::memory_order_relaxed); }
+
+  // 최근 windowMs 구간을 링에서 재생해 요약 (블로킹 없음)
+  Summary summarize(uint32_t windowMs) const {
+    Summary s;
+    uint32_t head = _head.load(std::memory_order_acquire);
+    uint32_t want = (uint32_t)((uint64_t)windowMs * IMU_RATE_HZ / 1000);
+    if (want > head) want = head;
+    if (want > IMU_RING_SAMPLES - IMU_RATE_HZ / 10) want = IMU_RING_SAMPLES - IMU_RATE_HZ / 10; // 덮어쓰기 여유
+    ImpactDetector det;
+    for (uint32_t i = head - want; i != head; ++i) {
+      float acc = _ring[i & (IMU_RING_SAMPLES - 1)] * 0.01f;
+      float impact;
+      if (det.step(acc, impact)) { s.hits++; if (impact > s.maxImpact) s.maxImpact = impact; }
+      if (acc > s.peakAcc) s.peakAcc = acc;
+    }
+    s.samples = want;
+    return s;
+  }
+
+  // 충격 이벤트 꺼내기 (단일 소비자: loop())
+  bool popImpact(Impact& out){
+    const Impact* imp = _impacts.front();
+    if (!imp) return false;
+    out = *imp;
+    _impacts.pop();
+    return true;
+  }
+  uint32_t droppedImpacts() const { return _impDropped.load(std::memory_order_relaxed); }
+
+private:
+  static constexpr uint8_t ADDR = 0x68;
+  static constexpr uint8_t REG_FIFO_EN = 0x23, REG_USER_CTRL = 0x6A, REG_FIFO_COUNT = 0x72, REG_FIFO_RW = 0x74;
+  static constexpr float LSB_PER_G = 4096.0f;          // ±8g
+
+  ImuSampler() {}
+
+  void _writeReg(uint8_t reg, uint8_t v){
+    Wire.beginTransmission(ADDR); Wire.write(reg); Wire.write(v); Wire.endTransmission();
+  }
+  size_t _readRegs(uint8_t reg, uint8_t* buf, size_t n){
+    Wire.beginTransmission(ADDR); Wire.write(reg);
+    if (Wire.endTransmission(false) != 0) return 0;
+    size_t got = Wire.requestFrom((int)ADDR, (int)n);
+    for (size_t i = 0; i < got; i++) buf[i] = Wire.read();
+    return got;
+  }
+
+  void _push(float acc, uint32_t t_ms){
+    float c = acc * 100.0f;
+    const uint32_t h = _head.load(std::memory_order_relaxed);
+    _ring[h & (IMU_RING_SAMPLES - 1)] = (uint16_t)(c > 65535.0f ? 65535.0f : c);
+    _head.store(h + 1, std::memory_order_release);   // 데이터를 쓴 뒤에 공개
+    _lastMs.store(t_ms, std::memory_order_relaxed);
+    float impact;
+    if (_det.step(acc, impact)) {
+      Impact* slot = _impacts.beginPush();
+      if (!slot) { _impDropped.fetch_add(1, std::memory_order_relaxed); return; }
+      *slot = { t_ms, impact };
+      _impacts.commitPush();
+    }
+  }
+
+  void _drain(){
+    uint8_t cnt[2];
+    if (_readRegs(REG_FIFO_COUNT, cnt, 2) != 2) return;
+    uint16_t n = ((uint16_t)cnt[0] << 8) | cnt[1];
+    if (n >= 1024) { _writeReg(REG_USER_CTRL, 0x44); return; }   // overflow: 정렬 깨짐 → reset
+    // FIFO의 마지막 샘플 ≈ 지금, k번째 샘플은 (남은 개수)/IMU_RATE_HZ 만큼 이전
+    const uint32_t now = millis();
+    uint32_t left = n / 6;
+    uint8_t buf[30];
+    while (n >= 6) {
+      size_t chunk = n >= sizeof(buf) ? sizeof(buf) : (n / 6) * 6;
+      if (_readRegs(REG_FIFO_RW, buf, chunk) != chunk) return;
+      for (size_t o = 0; o < chunk; o += 6) {
+        float ax = (int16_t)((buf[o]   << 8) | buf[o+1]) / LSB_PER_G;
+        float ay = (int16_t)((buf[o+2] << 8) | buf[o+3]) / LSB_PER_G;
+        float az = (int16_t)((buf[o+4] << 8) | buf[o+5]) / LSB_PER_G;
+        left--;
+        _push(sqrtf(ax*ax + ay*ay + az*az) * ImpactDetector::G, now - left * 1000u / IMU_RATE_HZ);
+      }
+      n -= chunk;
+    }
+  }
+
+#if defined(ESP32)
+  TaskHandle_t _task = nullptr;
+  static void _taskLoop(void* pv){
+    ImuSampler* self = static_cast<ImuSampler*>(pv);
+    TickType_t last = xTaskGetTickCount();
+    for (;;) {
+      self->_drain();
+      vTaskDelayUntil(&last, pdMS_TO_TICKS(IMU_DRAIN_MS));
+    }
+  }
+#endif
+
+  Adafruit_MPU6050 _mpu;
+  bool _ok = false;
+  uint16_t _ring[IMU_RING_SAMPLES] = {};
+  std::atomic<uint32_t> _head{0};
+  std::atomic<uint32_t> _lastMs{0};   // 가장 최근 샘플의 시각
+  ImpactDetector _det;
+  SpscQueue<Impact, IMU_IMPACT_QUEUE> _impacts;   // 생산: ImuSampler 태스크, 소비: 툴 (loop)
+  std::atomic<uint32_t> _impDropped{0};
+};
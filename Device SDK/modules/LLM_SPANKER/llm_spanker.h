@@ -1,111 +1,109 @@
 // modules/pain_receptor_hitme.h
 #pragma once
 #include <Arduino.h>
-#include <Wire.h>
-#include <Adafruit_MPU6050.h>
-#include <Adafruit_Sensor.h>
-#include "tool.h"  // ObservationBuilder, ITool 정의 포함
-
+#include "tool.h"        // ObservationBuilder, ITool 정의 포함
+#include "event_tool.h"  // EventTool (충격 이벤트)
+#include "imu_sampler.h" // 백그라운드 MPU6050 샘플링 + 링 버퍼
+
+#ifndef HITME_SDA_PIN
+#define HITME_SDA_PIN 5   // ESP32-C3 Mini 권장
+#endif
+#ifndef HITME_SCL_PIN
+#define HITME_SCL_PIN 4
+#endif
+
+// 즉시 조회 툴: 최근 N초를 링 버퍼에서 요약 (측정 창 대기 없음)
 class PainReceptor_HitMe : public ITool {
 public:
   // ===== 설정값 (필요 시 조정) =====
-  static constexpr uint32_t WINDOW_MS = 6000;   // 측정 창 (6초)
-  static constexpr uint8_t SDA_PIN    = 5;      // ESP32-C3 Mini 권장
-  static constexpr uint8_t SCL_PIN    = 4;
-
-  bool init() override {
-    Wire.begin(SDA_PIN, SCL_PIN);
-    delay(50);
-    if (!mpu.begin()) return false;
-    mpu.setAccelerometerRange(MPU6050_RANGE_8_G);
-    mpu.setGyroRange(MPU6050_RANGE_500_DEG);
-    mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
-    return true;
-  }
+  static constexpr uint32_t WINDOW_MS = 6000;   // 기본 조회 구간 (6초)
+
+  bool init() override { return ImuSampler::instance().begin(HITME_SDA_PIN, HITME_SCL_PIN); }
 
   const char* name() const override { return "PAIN_RECEPTOR_HITME"; }
 
   void describe(JsonObject& tool) override {
     tool["name"] = name();
     tool["description"] =
-      "Detects impact strength from motion and acceleration spikes (6s window).";
+      "Summarises impacts from motion and acceleration spikes over the last seconds (default 6s), instantly.";
     JsonObject params = tool.createNestedObject("parameters");
     params["type"] = "object";
-    params.createNestedObject("properties"); // 입력 없음
+    JsonObject props = params.createNestedObject("properties");
+    props["seconds"]["type"] = "integer";   // 조회 구간 (1..10, 링 크기 한도)
   }
 
-  bool invoke(JsonObjectConst /*args*/, ObservationBuilder& out) override {
-    sensors_event_t a, g, t;
-    const uint32_t start = millis();
-
-    int hits = 0;
-    float maxImpact = 0.0f;
-    float prevAcc = 9.81f;      // 중력 초기값
-    float swingSpeed = 0.0f;    // 휘두르는 속도 누적값
-    bool inHit = false;
-
-    while (millis() - start < WINDOW_MS) {
-      if (!mpu.getEvent(&a, &g, &t)) {
-        delay(10);
-        continue;
-      }
-
-      // 현재 가속도 벡터 크기
-      float ax = a.acceleration.x;
-      float ay = a.acceleration.y;
-      float az = a.acceleration.z;
-      float acc = sqrtf(ax*ax + ay*ay + az*az);
-
-      // (1) 휘두르는 속도 추정: 가속도의 편차를 누적
-      float deltaAcc = acc - 9.81f;
-      if (fabsf(deltaAcc) > 2.0f) {   // 작은 진동은 무시
-        swingSpeed += fabsf(deltaAcc) * 0.01f;  // dt ≈ 10ms
-      }
-
-      // (2) 충격 감지: 이전 프레임과의 변화량
-      float dA = fabsf(acc - prevAcc);
-      prevAcc = acc;
-
-      // 히트 시작
-      if (!inHit && dA > 35.0f) {
-        inHit = true;
-        hits++;
-
-        // 충격 강도 = 순간 변화량 + 휘두름 속도의 영향
-        float impact = dA + (swingSpeed * 10.0f);
-        if (impact > maxImpact) maxImpact = impact;
-
-        // 한 번 충돌 후 리셋
-        swingSpeed = 0.0f;
-
-      } else if (inHit && dA < 12.0f) {
-        inHit = false;
-      }
-
-      delay(10);
-    }
-
-    // === 결과 분류 ===
-    const char* hitsLabel =
-        (hits <= 0) ? "none" :
-        (hits == 1) ? "single" :
-        (hits <= 3) ? "few" : "flurry";
+  bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
+    ImuSampler& imu = ImuSampler::instance();
+    if (!imu.ready()) { out.error("sensor_unavailable", "MPU6050 not initialised"); return false; }
 
-    const char* intensity =
-        (maxImpact < 40.0f)  ? "gentle" :
-        (maxImpact < 80.0f)  ? "normal" :
-        (maxImpact < 150.0f) ? "hard"   : "brutal";
+    uint32_t windowMs = args.containsKey("seconds")
+                        ? (uint32_t)constrain(args["seconds"].as<int>(), 1, 10) * 1000u
+                        : WINDOW_MS;
+    ImuSampler::Summary s = imu.summarize(windowMs);
 
     // === 결과 텍스트 ===
     String txt = "impact_window_complete | hits=";
-    txt += hitsLabel;
+    txt += ImpactDetector::hitsLabel(s.hits);
     txt += " | intensity=";
-    txt += intensity;
+    txt += ImpactDetector::intensity(s.maxImpact);
+
+    out.success(txt);   // String overload: copied into the doc (txt dies before serialization)
+    auto a = out.addAsset();
+    a["kind"] = "summary";
+    a["window_ms"] = (uint32_t)(s.samples * 1000u / IMU_RATE_HZ);
+    a["hits"] = s.hits;
+    a["max_impact"] = s.maxImpact;
+    a["peak_acc"] = s.peakAcc;
+    return true;
+  }
+};
+
+// 이벤트 툴: 샘플러가 감지한 충격을 발생 즉시 emit (subscribe 필요)
+class PainReceptor_Impact : public EventTool {
+public:
+  PainReceptor_Impact() : EventTool("PAIN_RECEPTOR_IMPACT", "Emits an event for every detected hit/impact") {}
+
+  bool onInit() override { return ImuSampler::instance().begin(HITME_SDA_PIN, HITME_SCL_PIN); }
+
+  void buildSignals(JsonObject& signals) override {
+    auto ev = signals.createNestedArray("event_types");
+    ev.add("impact");
+  }
+
+  bool onSubscribe(JsonObjectConst /*args*/, ObservationBuilder& out) override {
+    ImuSampler::Impact skip;
+    while (ImuSampler::instance().popImpact(skip)) {}   // 구독 전 충격은 버림
+    _active = true;
+    out.success("subscribed (impact events)");
+    return true;
+  }
 
-    out.success(txt.c_str()); // ObservationBuilder 그대로 사용
+  bool onUnsubscribe(JsonObjectConst /*args*/, ObservationBuilder& out) override {
+    _active = false;
+    out.success("unsubscribed");
     return true;
   }
 
+  // 샘플러 드레인 주기에 맞춰 깨어남
+  uint32_t nextTickMs(uint32_t now_ms) override { return _active ? now_ms + IMU_DRAIN_MS : TICK_IDLE; }
+
+  void tick(uint32_t /*now_ms*/) override {
+    if (!_active) return;
+    ImuSampler::Impact imp;
+    while (ImuSampler::instance().popImpact(imp)) {
+      ObservationBuilder ob;
+      ob.setDelivery(ObservationBuilder::Delivery::Urgent);
+      ob.success(ImpactDetector::intensity(imp.strength));
+      auto a = ob.addAsset();
+      a["kind"] = "event";
+      a["event_type"] = "impact";
+      a["strength"] = imp.strength;
+      a["intensity"] = ImpactDetector::intensity(imp.strength);
+      a["t_ms"] = imp.t_ms;
+      emitNow(ob);
+    }
+  }
+
 private:
-  Adafruit_MPU6050 mpu;
+  bool _active = false;
 };
@@ -1,7 +1,9 @@
 
 #include "camera_ai_thinker.h"
+#include "img_converters.h"
+#include "metrics.h"
+#include "mcp_log.h"
 
-extern String http_base;
 #define PWDN_GPIO_NUM     32
 #define RESET_GPIO_NUM    -1
 #define XCLK_GPIO_NUM      0
@@ -44,53 +46,375 @@ bool CameraAiThinker::init(){
   config.pin_reset    = RESET_GPIO_NUM;
   config.xclk_freq_hz = 20000000;
   config.pixel_format = PIXFORMAT_JPEG;
-  config.frame_size   = FRAMESIZE_VGA;
   config.jpeg_quality = 12;
-  config.fb_count     = 1;
+  if (psramFound()) {
+    // Buffers are sized at init, so allocate for the largest profile ("high").
+    // Ring + hot slot are held outside the driver; one spare keeps it from starving.
+    config.frame_size  = FRAMESIZE_SVGA;
+    config.fb_location = CAMERA_FB_IN_PSRAM;
+    config.grab_mode   = CAMERA_GRAB_LATEST;
+    config.fb_count    = CAM_RING_SLOTS + 2;
+    _slots    = CAM_RING_SLOTS;
+    _zeroCopy = true;
+  } else {
+    config.frame_size  = FRAMESIZE_VGA;
+    config.fb_location = CAMERA_FB_IN_DRAM;
+    config.grab_mode   = CAMERA_GRAB_WHEN_EMPTY;
+    config.fb_count    = 1;
+    _slots    = 1;
+    _zeroCopy = false;
+  }
 
   esp_err_t err = esp_camera_init(&config);
   if (err != ESP_OK) { Serial.printf("[CAM] init failed: 0x%x\n", err); return false; }
+#if defined(ESP32)
+  if (!_camLock) _camLock = xSemaphoreCreateMutex();
+#endif
+  applyProfile(Profile::Mid);
+  AssetSources::add(this);
   pinMode(_flash, OUTPUT);
   digitalWrite(_flash, LOW);
-  Serial.println("[CAM] init OK");
+  Serial.printf("[CAM] init OK (ring=%u, %s)\n", (unsigned)_slots, _zeroCopy ? "zero-copy PSRAM" : "copy");
   return true;
 }
 
-void CameraAiThinker::setQuality(const String& q){
+CameraAiThinker::Profile CameraAiThinker::parseProfile(const String& q){
+  if (q=="low")  return Profile::Low;
+  if (q=="high") return Profile::High;
+  return Profile::Mid;
+}
+
+bool CameraAiThinker::applyProfile(Profile p){
+  if (p == _profile) return false;
   sensor_t* s = esp_camera_sensor_get();
-  if (!s) return;
-  if      (q=="low")  { s->set_framesize(s, FRAMESIZE_QVGA); s->set_quality(s,20); }
-  else if (q=="high") { s->set_framesize(s, FRAMESIZE_SVGA); s->set_quality(s,10); }
-  else                { s->set_framesize(s, FRAMESIZE_VGA);  s->set_quality(s,12); }
+  if (!s) return false;
+  switch (p) {
+    case Profile::Low:  s->set_framesize(s, FRAMESIZE_QVGA); s->set_quality(s,20); break;
+    case Profile::High: s->set_framesize(s, FRAMESIZE_SVGA); s->set_quality(s,10); break;
+    default:            s->set_framesize(s, FRAMESIZE_VGA);  s->set_quality(s,12); break;
+  }
+  _profile = p;
+  return true;
 }
 
 void CameraAiThinker::warmup(int count,int delayMs){
-  for(int i=0;i<count;i++){ if(auto fb=esp_camera_fb_get()){ esp_camera_fb_return(fb);} delay(delayMs); }
+  for(int i=0;i<count;i++){ if(auto fb=esp_camera_fb_get()){ esp_camera_fb_return(fb);} if(delayMs) delay(delayMs); }
+}
+
+const CameraAiThinker::Frame* CameraAiThinker::last() const {
+  if (_newest < 0) return nullptr;
+  const Frame& f = _ring[_newest];
+  return f.valid() ? &f : nullptr;
+}
+
+const CameraAiThinker::Frame* CameraAiThinker::find(const char* id) const {
+  if (!id || !id[0]) return nullptr;
+  for (uint8_t i=0; i<_slots; i++) if (_ring[i].valid() && strcmp(_ring[i].id, id)==0) return &_ring[i];
+  return nullptr;
+}
+
+#if defined(ESP32)
+  #define RING_LOCK()   portENTER_CRITICAL(&_ringMux)
+  #define RING_UNLOCK() portEXIT_CRITICAL(&_ringMux)
+#else
+  #define RING_LOCK()
+  #define RING_UNLOCK()
+#endif
+
+const CameraAiThinker::Frame* CameraAiThinker::pin(const char* id){
+  RING_LOCK();
+  Frame* f = const_cast<Frame*>((id && id[0]) ? find(id) : last());
+  if (f) f->readers++;
+  RING_UNLOCK();
+  return f;
+}
+
+void CameraAiThinker::unpin(const Frame* f){
+  if (!f) return;
+  RING_LOCK();
+  Frame* m = const_cast<Frame*>(f);
+  if (m->readers) m->readers--;
+  RING_UNLOCK();
+}
+
+bool CameraAiThinker::openAsset(const char* asset_id, AssetRef& ref){
+  char id[sizeof(Frame::id)];
+  strlcpy(id, asset_id, sizeof(id));
+  int v = -1;
+  if (char* dot = strstr(id, ".v")) { v = atoi(dot + 2); *dot = 0; }
+  const Frame* f = pin(id);
+  if (!f) return false;
+  if (v >= f->nvar) { unpin(f); return false; }
+  ref.data  = v < 0 ? f->data() : f->var[v].buf;
+  ref.len   = v < 0 ? f->len : f->var[v].len;
+  ref.token = f;
+  return true;
+}
+
+void CameraAiThinker::closeAsset(AssetRef& ref){
+  unpin(static_cast<const Frame*>(ref.token));
+  ref = AssetRef();
+}
+
+// Oldest slot not being served over HTTP. Its id is cleared under the lock, so it can no
+// longer be pinned while the new capture is written. nullptr if every slot is pinned.
+CameraAiThinker::Frame* CameraAiThinker::claimSlot(){
+  Frame* slot = nullptr;
+  RING_LOCK();
+  for (uint8_t k=0; k<_slots; k++) {
+    uint8_t i = (_head + k) % _slots;
+    if (_ring[i].readers) continue;
+    slot = &_ring[i];
+    _head = i;
+    slot->id[0] = 0;
+    if (_newest == (int8_t)i) _newest = -1;
+    break;
+  }
+  RING_UNLOCK();
+  return slot;
+}
+
+// Give the slot's framebuffer back to the driver; copy buffers are kept for reuse.
+void CameraAiThinker::release(Frame& f){
+  if (f.fb) { esp_camera_fb_return(f.fb); f.fb = nullptr; }
+  for (uint8_t i=0; i<f.nvar; i++) { free(f.var[i].buf); f.var[i] = Frame::Variant(); }
+  f.nvar = 0;
+  f.len = 0; f.id[0] = 0;
 }
 
-bool CameraAiThinker::capture(const String& quality, const String& flashMode){
-  setQuality(quality);
-  warmup(2,30);
+// ---- hot mode ----
+#if defined(ESP32)
+void CameraAiThinker::_hotLoop(void* pv){
+  CameraAiThinker* self = static_cast<CameraAiThinker*>(pv);
+  for (;;) {
+    if (!self->_hot) { ulTaskNotifyTake(pdTRUE, portMAX_DELAY); continue; }
+    xSemaphoreTake(self->_camLock, portMAX_DELAY);
+    camera_fb_t* fb = esp_camera_fb_get();
+    xSemaphoreGive(self->_camLock);
+    if (fb) {
+      camera_fb_t* old = fb;
+      portENTER_CRITICAL(&self->_hotMux);
+      // stopHot() may have run during the capture: then the frame goes straight back
+      if (self->_hot) { old = self->_hotFb; self->_hotFb = fb; }
+      portEXIT_CRITICAL(&self->_hotMux);
+      if (old) esp_camera_fb_return(old);
+    }
+    vTaskDelay(pdMS_TO_TICKS(CAM_HOT_PERIOD_MS));
+  }
+}
+
+camera_fb_t* CameraAiThinker::takeHot(){
+  portENTER_CRITICAL(&_hotMux);
+  camera_fb_t* fb = _hotFb; _hotFb = nullptr;
+  portEXIT_CRITICAL(&_hotMux);
+  return fb;
+}
+
+bool CameraAiThinker::startHot(){
+  if (!_zeroCopy) return false;   // needs spare PSRAM framebuffers
+  _hot = true;
+  if (!_hotTask) xTaskCreate(&_hotLoop, "CamHotTask", 4096, this, 1, &_hotTask);
+  else xTaskNotifyGive(_hotTask);
+  Serial.println("[CAM] hot mode on");
+  return _hotTask != nullptr;
+}
+#else
+camera_fb_t* CameraAiThinker::takeHot(){ return nullptr; }
+bool CameraAiThinker::startHot(){ return false; }
+#endif
+
+void CameraAiThinker::dropHot(){
+  if (camera_fb_t* fb = takeHot()) esp_camera_fb_return(fb);
+}
+
+void CameraAiThinker::stopHot(){
+  if (!_hot) return;
+#if defined(ESP32)
+  portENTER_CRITICAL(&_hotMux);   // after this no capture in flight can park its frame
+  _hot = false;
+  portEXIT_CRITICAL(&_hotMux);
+#else
+  _hot = false;
+#endif
+  dropHot();
+  Serial.println("[CAM] hot mode off");
+}
+
+camera_fb_t* CameraAiThinker::acquire(Profile p){
+#if defined(ESP32)
+  if (_camLock) xSemaphoreTake(_camLock, portMAX_DELAY);
+#endif
+  camera_fb_t* fb = nullptr;
+  if (applyProfile(p)) dropHot();
+  else if (_hot) fb = takeHot();
+  if (!fb) fb = esp_camera_fb_get();
+#if defined(ESP32)
+  if (_camLock) xSemaphoreGive(_camLock);
+#endif
+  return fb;
+}
+
+bool CameraAiThinker::capture(const String& quality, const String& flashMode, Timing& t){
+  // Oldest unpinned slot is recycled first so its buffer is free for the grab below.
+  // Without PSRAM there is a single slot: wait (bounded) for a running download of it.
+  Frame* sp = claimSlot();
+  for (uint32_t w = millis(); !sp && millis() - w < 2000; ) { delay(10); sp = claimSlot(); }
+  if (!sp) { Serial.println("[CAM] all slots busy (downloads in progress)"); return false; }
+  Frame& slot = *sp;
+  release(slot);
   bool on = String(flashMode).equalsIgnoreCase("on");
-  if (on) digitalWrite(_flash, HIGH);
-
-  camera_fb_t* fb = esp_camera_fb_get();
-  if(!fb){ if(on) digitalWrite(_flash, LOW); Serial.println("[CAM] capture failed"); return false; }
-  if(_last){ free(_last); _last=nullptr; _lastLen=0; }
-  _last=(uint8_t*)malloc(fb->len);
-  if(!_last){ esp_camera_fb_return(fb); if(on) digitalWrite(_flash, LOW); Serial.println("[CAM] malloc failed"); return false; }
-  memcpy(_last, fb->buf, fb->len);
-  _lastLen = fb->len;
-  _lastId = String(millis(),HEX) + String((uint32_t)esp_random(), HEX);
-  esp_camera_fb_return(fb);
-  if (on) digitalWrite(_flash, LOW);
-  Serial.printf("[CAM] captured %u bytes id=%s\n", (unsigned)_lastLen, _lastId.c_str());
+
+  camera_fb_t* fb = nullptr;
+  uint32_t t0 = micros();
+#if defined(ESP32)
+  if (_camLock) xSemaphoreTake(_camLock, portMAX_DELAY);
+#endif
+  bool reconfigured = applyProfile(parseProfile(quality));
+  uint32_t t1 = micros(); t.reconfig_us = t1 - t0;
+
+  if (reconfigured) {
+    dropHot();        // hot frame has the old framesize
+    warmup(2,30);     // let the sensor settle on the new profile
+  } else if (_hot && !on) {
+    fb = takeHot();   // freshest background frame, no sensor round-trip
+    t.hot = fb != nullptr;
+  } else if (on || !_zeroCopy) {
+    warmup(1,0);      // drop the frame exposed before flash / buffered since the last return
+  }
+  uint32_t t2 = micros(); t.warmup_us = t2 - t1;
+
+  if (!fb) {
+    if (on) digitalWrite(_flash, HIGH);
+    fb = esp_camera_fb_get();
+    if (on) digitalWrite(_flash, LOW);
+  }
+#if defined(ESP32)
+  if (_camLock) xSemaphoreGive(_camLock);
+#endif
+  uint32_t t3 = micros(); t.grab_us = t3 - t2;
+  if(!fb){ Serial.println("[CAM] capture failed"); return false; }
+
+  const size_t len = fb->len;
+  slot.w = fb->width; slot.h = fb->height;
+  if (_zeroCopy) {
+    slot.fb = fb;
+  } else {
+    if (slot.cap < fb->len) {
+      uint8_t* nb = (uint8_t*)realloc(slot.copy, fb->len);
+      if(!nb){ esp_camera_fb_return(fb); Serial.println("[CAM] alloc failed"); return false; }
+      slot.copy = nb; slot.cap = fb->len;
+    }
+    memcpy(slot.copy, fb->buf, fb->len);
+    esp_camera_fb_return(fb);
+  }
+  t.copy_us = micros() - t3;
+  slot.len = len;
+  char id[sizeof(slot.id)];
+  snprintf(id, sizeof(id), "%lx%08lx", (unsigned long)millis(), (unsigned long)esp_random());
+  RING_LOCK();
+  memcpy(slot.id, id, sizeof(id));     // publish: pin()/find() can see it from here on
+  _newest = (int8_t)(&slot - _ring);
+  _head = (_newest + 1) % _slots;
+  RING_UNLOCK();
+  METRIC_OBSERVE("mcp_camera_us", "reconfig", t.reconfig_us);
+  METRIC_OBSERVE("mcp_camera_us", "warmup", t.warmup_us);
+  METRIC_OBSERVE("mcp_camera_us", "grab", t.grab_us);
+  METRIC_OBSERVE("mcp_camera_us", "copy", t.copy_us);
+  MCP_LOGD("CAM", "captured %u bytes id=%s (reconfig=%lu warmup=%lu grab=%lu copy=%lu us%s)",
+           (unsigned)slot.len, slot.id, (unsigned long)t.reconfig_us, (unsigned long)t.warmup_us,
+           (unsigned long)t.grab_us, (unsigned long)t.copy_us, t.hot ? ", hot" : "");
+  return true;
+}
+
+// ---- variants ----
+static void* camAlloc(size_t n){
+#if defined(ESP32)
+  if (psramFound()) return ps_malloc(n);
+#endif
+  return malloc(n);
+}
+
+// "thumb" / "gray" shorthands, or {type, roi:[x,y,w,h] (0..1), width, gray, quality}
+bool CameraAiThinker::parseVariant(JsonVariantConst v, VariantSpec& spec){
+  spec = VariantSpec();
+  const char* type = v.is<const char*>() ? v.as<const char*>() : (v["type"] | "thumb");
+  if      (strcmp(type, "thumb") == 0) { spec.kind = "thumb"; spec.maxW = 160; }
+  else if (strcmp(type, "roi") == 0)   { spec.kind = "roi"; }
+  else if (strcmp(type, "gray") == 0)  { spec.kind = "gray"; spec.gray = true; }
+  else return false;
+  if (!v.is<JsonObjectConst>()) return true;
+
+  JsonArrayConst roi = v["roi"];
+  if (roi.size() == 4) {
+    spec.x  = constrain(roi[0].as<float>(), 0.0f, 1.0f);
+    spec.y  = constrain(roi[1].as<float>(), 0.0f, 1.0f);
+    spec.rw = constrain(roi[2].as<float>(), 0.0f, 1.0f - spec.x);
+    spec.rh = constrain(roi[3].as<float>(), 0.0f, 1.0f - spec.y);
+    if (spec.rw <= 0 || spec.rh <= 0) return false;
+  } else if (!strcmp(type, "roi")) {
+    return false;
+  }
+  spec.maxW    = v["width"] | spec.maxW;
+  spec.gray    = v["gray"] | spec.gray;
+  spec.quality = constrain((int)(v["quality"] | (int)spec.quality), 1, 100);
+  return true;
+}
+
+bool CameraAiThinker::makeVariant(Frame& f, const VariantSpec& spec){
+  if (f.nvar >= CAM_MAX_VARIANTS || !f.w || !f.h) return false;
+
+  // ROI in sensor pixels
+  const uint16_t cx = f.w * spec.x, cy = f.h * spec.y;
+  const uint16_t cw = max(1, (int)(f.w * spec.rw)), ch = max(1, (int)(f.h * spec.rh));
+
+  // Largest JPEG decode scale (1/2/4/8) that still leaves >= maxW pixels across the ROI:
+  // the decoder skips the work for the dropped resolution
+  uint8_t shift = 0;
+  if (spec.maxW) while (shift < 3 && (cw >> (shift + 1)) >= spec.maxW) shift++;
+
+  uint8_t* rgb = nullptr;
+  uint16_t dw = 0, dh = 0;
+  for (; shift <= 3; shift++) {   // no PSRAM: fall back to a smaller decode if allocation fails
+    dw = f.w >> shift; dh = f.h >> shift;
+    if ((rgb = (uint8_t*)camAlloc((size_t)dw * dh * 2))) break;
+  }
+  if (!rgb) return false;
+  if (!jpg2rgb565(f.data(), f.len, rgb, (jpg_scale_t)shift)) { free(rgb); return false; }
+
+  // Crop + nearest-neighbour resize (+ luma) into the encode buffer
+  const uint16_t sx = cx >> shift, sy = cy >> shift;
+  const uint16_t sw = max(1, cw >> shift), sh = max(1, ch >> shift);
+  const uint16_t ow = (spec.maxW && spec.maxW < sw) ? spec.maxW : sw;
+  const uint16_t oh = max(1, (int)((uint32_t)sh * ow / sw));
+  const uint8_t bpp = spec.gray ? 1 : 2;
+  uint8_t* px = (uint8_t*)camAlloc((size_t)ow * oh * bpp);
+  if (!px) { free(rgb); return false; }
+  for (uint16_t y=0; y<oh; y++) {
+    const uint8_t* row = rgb + ((size_t)(sy + (uint32_t)y * sh / oh) * dw + sx) * 2;
+    uint8_t* o = px + (size_t)y * ow * bpp;
+    for (uint16_t x=0; x<ow; x++) {
+      const uint8_t* p = row + ((uint32_t)x * sw / ow) * 2;
+      if (!spec.gray) { o[0] = p[0]; o[1] = p[1]; o += 2; continue; }
+      uint16_t c = ((uint16_t)p[0] << 8) | p[1];   // RGB565, high byte first
+      uint8_t r = (c >> 8) & 0xF8, g = (c >> 3) & 0xFC, b = (c << 3) & 0xF8;
+      *o++ = (uint8_t)((r * 77 + g * 150 + b * 29) >> 8);
+    }
+  }
+  free(rgb);
+
+  Frame::Variant& v = f.var[f.nvar];
+  bool ok = fmt2jpg(px, (size_t)ow * oh * bpp, ow, oh, spec.gray ? PIXFORMAT_GRAYSCALE : PIXFORMAT_RGB565,
+                    spec.quality, &v.buf, &v.len);
+  free(px);
+  if (!ok) { v = Frame::Variant(); return false; }
+  v.w = ow; v.h = oh;
+  f.nvar = f.nvar + 1;   // HTTP may serve it from here on
   return true;
 }
 
 void CameraAiThinker::describe(JsonObject& tool){
   tool["name"]=name();
-  tool["description"]="Capture image (quality: low|mid|high, flash: on|off)";
+  tool["description"]="Capture image (quality: low|mid|high, flash: on|off, hot: keep grabbing in background for instant captures)";
   JsonObject params=tool.createNestedObject("parameters");
   params["type"]="object";
   JsonObject props=params.createNestedObject("properties");
@@ -98,34 +422,149 @@ void CameraAiThinker::describe(JsonObject& tool){
   qenum.add("low"); qenum.add("mid"); qenum.add("high");
   JsonArray fenum=props.createNestedObject("flash").createNestedArray("enum");
   fenum.add("on"); fenum.add("off");
+  props["hot"]["type"]="boolean";
+  JsonObject vp=props.createNestedObject("variants");
+  vp["type"]="array";
+  vp["description"]="extra on-device images: \"thumb\", \"gray\" or {type: thumb|roi|gray, roi: [x,y,w,h] as 0..1 fractions, width, gray, quality}";
   JsonArray req=params.createNestedArray("required");
   req.add("quality"); req.add("flash");
 }
 
 bool CameraAiThinker::invoke(JsonObjectConst args, ObservationBuilder& out){
   String q=args["quality"]|"mid";
-  String f=args["flash"]|"off";
-  Serial.printf("[CAM] invoke quality=%s flash=%s\n", q.c_str(), f.c_str());
-  if(!capture(q,f)){ out.error("camera_error","failed to capture"); return false; }
+  String fl=args["flash"]|"off";
+  if (args.containsKey("hot")) { if (args["hot"].as<bool>()) startHot(); else stopHot(); }
+  MCP_LOGD("CAM", "invoke quality=%s flash=%s hot=%d", q.c_str(), fl.c_str(), (int)_hot);
+  Timing t;
+  if(!capture(q,fl,t)){ out.error("camera_error","failed to capture"); return false; }
 
   out.success("captured");
   JsonObject a = out.addAsset();
-  a["asset_id"] = _lastId;
+  const Frame* f = last();
+  a["asset_id"] = f->id;
   a["kind"]     = "image";
   a["mime"]     = "image/jpeg";
-  a["url"]      = http_base + String("/last.jpg?rid=") + _lastId;
+  out.setAssetData(a, String("/last.jpg?rid=") + f->id, f->data(), f->len);
+  JsonObject tm = a.createNestedObject("timing_us");
+  tm["reconfig"] = t.reconfig_us;
+  tm["warmup"]   = t.warmup_us;
+  tm["grab"]     = t.grab_us;
+  tm["copy"]     = t.copy_us;
+  a["source"]    = t.hot ? "hot" : "sensor";
+  a["width"]     = f->w;
+  a["height"]    = f->h;
+  a["bytes"]     = f->len;
+
+  // Derived images, each its own asset (smaller download than the full frame)
+  JsonArrayConst vars = args["variants"];
+  Frame& fr = const_cast<Frame&>(*f);
+  for (JsonVariantConst vv : vars) {
+    VariantSpec spec;
+    if (!parseVariant(vv, spec)) { MCP_LOGW("CAM", "bad variant spec, skipped"); continue; }
+    uint32_t t0 = micros();
+    if (!makeVariant(fr, spec)) { MCP_LOGW("CAM", "variant '%s' failed", spec.kind); continue; }
+    const uint8_t n = fr.nvar - 1;
+    const Frame::Variant& v = fr.var[n];
+    JsonObject va = out.addAsset();
+    va["asset_id"] = String(fr.id) + ".v" + n;
+    va["kind"]     = "image";
+    va["mime"]     = "image/jpeg";
+    va["variant"]  = spec.kind;
+    out.setAssetData(va, String("/last.jpg?rid=") + fr.id + "&v=" + n, v.buf, v.len);
+    va["width"]    = v.w;
+    va["height"]   = v.h;
+    va["bytes"]    = v.len;
+    if (spec.gray) va["gray"] = true;
+    if (spec.rw < 1 || spec.rh < 1) {
+      JsonArray roi = va.createNestedArray("roi");
+      roi.add(spec.x); roi.add(spec.y); roi.add(spec.rw); roi.add(spec.rh);
+    }
+    va["build_us"] = micros() - t0;
+    METRIC_OBSERVE("mcp_camera_us", "variant", va["build_us"].as<uint32_t>());
+    MCP_LOGD("CAM", "variant %u '%s' %ux%u %u bytes", (unsigned)n, spec.kind, v.w, v.h, (unsigned)v.len);
+  }
   return true;
 }
 
+// "bytes=a-b" / "bytes=a-" / "bytes=-n" (single range only). Anything else (multi-range,
+// other units, "bytes=-0", b < a) is ignored and gets the full body, as RFC 9110 allows;
+// only a start at or past the end is unsatisfiable (416)
+enum class RangeResult : uint8_t { Ignore, Partial, Unsatisfiable };
+static RangeResult parseRange(const String& h, size_t len, size_t& from, size_t& to){
+  if (!h.startsWith("bytes=") || h.indexOf(',') >= 0 || !len) return RangeResult::Ignore;
+  int dash = h.indexOf('-');
+  if (dash < 0) return RangeResult::Ignore;
+  String a = h.substring(6, dash), b = h.substring(dash + 1);
+  if (a.length()) {
+    from = (size_t)a.toInt();
+    if (from >= len) return RangeResult::Unsatisfiable;
+    to = b.length() ? (size_t)b.toInt() : len - 1;
+  } else {
+    size_t n = (size_t)b.toInt();
+    if (!n) return RangeResult::Ignore;
+    from = n >= len ? 0 : len - n;
+    to = len - 1;
+  }
+  if (to >= len) to = len - 1;
+  return from <= to ? RangeResult::Partial : RangeResult::Ignore;
+}
 
 void CameraAiThinker::register_http(WebServer& srv){
   srv.on("/last.jpg", HTTP_GET, [this,&srv](){
-    if (!this->hasLast()) { srv.send(404, "application/json", "{\"error\":\"no last image\"}"); return; }
-    srv.sendHeader("Cache-Control","no-store, no-cache, must-revalidate, max-age=0");
-    srv.sendHeader("Pragma","no-cache"); srv.sendHeader("Expires","0");
-    srv.setContentLength(this->lastLen());
-    srv.send(200, "image/jpeg", "");
+    // ?rid= selects an exact capture from the ring; without it the newest one is served.
+    // The frame is pinned for the whole transfer, so a capture meanwhile uses another slot.
+    const bool byId = srv.hasArg("rid");
+    const Frame* f = this->pin(byId ? srv.arg("rid").c_str() : nullptr);
+    if (!f) {
+      if (byId) srv.send(404, "application/json", "{\"error\":\"asset expired\"}");
+      else      srv.send(404, "application/json", "{\"error\":\"no last image\"}");
+      return;
+    }
+    // &v=<n>: one of the capture's variants instead of the full frame
+    const uint8_t* p = f->data();
+    size_t len = f->len;
+    String etag = String("\"") + f->id;
+    if (srv.hasArg("v")) {
+      int n = srv.arg("v").toInt();
+      if (n < 0 || n >= f->nvar) { srv.send(404, "application/json", "{\"error\":\"variant not found\"}"); this->unpin(f); return; }
+      p = f->var[n].buf; len = f->var[n].len;
+      etag += String(".v") + n;
+    }
+    // Frames are immutable once captured: the capture id is a strong validator
+    etag += "\"";
+    srv.sendHeader("ETag", etag);
+    srv.sendHeader("Accept-Ranges", "bytes");
+    if (byId) srv.sendHeader("Cache-Control", "private, max-age=300, immutable");
+    else { srv.sendHeader("Cache-Control","no-store, no-cache, must-revalidate, max-age=0");
+           srv.sendHeader("Pragma","no-cache"); srv.sendHeader("Expires","0"); }
+    if (srv.header("If-None-Match") == etag) { srv.send(304); this->unpin(f); return; }
+
+    size_t from = 0, to = len - 1;
+    int code = 200;
+    if (srv.hasHeader("Range") && srv.header("Range").length()) {
+      const RangeResult r = parseRange(srv.header("Range"), len, from, to);
+      if (r == RangeResult::Unsatisfiable) {
+        srv.sendHeader("Content-Range", String("bytes */") + len);
+        srv.send(416); this->unpin(f); return;
+      }
+      if (r == RangeResult::Partial) {
+        code = 206;
+        srv.sendHeader("Content-Range", String("bytes ") + from + "-" + to + "/" + len);
+      } else {
+        from = 0; to = len - 1;   // parseRange may have written them before giving up
+      }
+    }
+    srv.setContentLength(to - from + 1);
+    srv.send(code, "image/jpeg", "");
+
+    // Chunked straight from the frame buffer (no copy); stop if the client goes away
     WiFiClient c = srv.client();
-    c.write(this->lastBuf(), this->lastLen());
+    for (size_t off = from; off <= to && c.connected(); ) {
+      size_t n = to - off + 1; if (n > CAM_HTTP_CHUNK) n = CAM_HTTP_CHUNK;
+      size_t w = c.write(p + off, n);
+      if (!w) break;
+      off += w;
+    }
+    this->unpin(f);
   });
 }
@@ -4,8 +4,63 @@
 #include "esp_camera.h"
 #include "tool.h"
 
-class CameraAiThinker : public ITool {
+#if defined(ESP32)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+  #include "freertos/semphr.h"
+#endif
+
+#ifndef CAM_RING_SLOTS
+#define CAM_RING_SLOTS 3   // captures kept addressable via /last.jpg?rid=
+#endif
+#ifndef CAM_HOT_PERIOD_MS
+#define CAM_HOT_PERIOD_MS 40  // hot mode: min gap between background grabs
+#endif
+#ifndef CAM_HTTP_CHUNK
+#define CAM_HTTP_CHUNK 4096   // /last.jpg: bytes per write straight from the frame buffer
+#endif
+#ifndef CAM_MAX_VARIANTS
+#define CAM_MAX_VARIANTS 3    // derived JPEGs (thumbnail / ROI crop / grayscale) per capture
+#endif
+
+class CameraAiThinker : public ITool, public IAssetSource {
 public:
+  // One retained capture. With PSRAM the driver framebuffer itself is held (zero-copy);
+  // without PSRAM the JPEG is copied into a grow-only buffer reused across captures.
+  struct Frame {
+    // Re-encoded from this frame on request; served as /last.jpg?rid=<id>&v=<n>
+    struct Variant { uint8_t* buf = nullptr; size_t len = 0; uint16_t w = 0, h = 0; };
+
+    camera_fb_t* fb = nullptr;
+    uint8_t* copy = nullptr;
+    size_t cap = 0;
+    size_t len = 0;
+    uint16_t w = 0, h = 0;
+    char id[24] = {0};
+    volatile uint8_t readers = 0;   // HTTP responses streaming this frame (slot not recycled)
+    Variant var[CAM_MAX_VARIANTS];
+    volatile uint8_t nvar = 0;      // published after the variant buffer is complete
+    const uint8_t* data() const { return fb ? fb->buf : copy; }
+    bool valid() const { return len > 0 && id[0]; }
+  };
+
+  // One requested variant: optional ROI (fractions of the frame), target width, grayscale
+  struct VariantSpec {
+    const char* kind = "thumb";     // thumb | roi | gray (reported back as-is)
+    float x = 0, y = 0, rw = 1, rh = 1;
+    uint16_t maxW = 0;              // 0 = ROI at decode resolution
+    bool gray = false;
+    uint8_t quality = 70;           // re-encode quality, 1..100 (higher = better)
+  };
+
+  enum class Profile : uint8_t { None, Low, Mid, High };
+
+  // Per-capture latency breakdown, reported in the asset as timing_us
+  struct Timing {
+    uint32_t reconfig_us = 0, warmup_us = 0, grab_us = 0, copy_us = 0;
+    bool hot = false;   // frame came from the hot-mode slot
+  };
+
   explicit CameraAiThinker(int flashPin = 4);
   bool init() override;
   const char* name() const override { return "capture_image"; }
@@ -13,17 +68,61 @@ public:
   bool invoke(JsonObjectConst args, ObservationBuilder& out) override;
   void register_http(WebServer& srv) override;
 
-  bool hasLast() const { return _last && _lastLen>0; }
-  const uint8_t* lastBuf() const { return _last; }
-  size_t lastLen() const { return _lastLen; }
-  String lastId() const { return _lastId; }
+  // IAssetSource: "<id>" = full frame, "<id>.v<n>" = variant n (pinned until closeAsset)
+  bool openAsset(const char* asset_id, AssetRef& ref) override;
+  void closeAsset(AssetRef& ref) override;
+
+  bool hasLast() const { return last() != nullptr; }
+  const uint8_t* lastBuf() const { return hasLast() ? last()->data() : nullptr; }
+  size_t lastLen() const { return hasLast() ? last()->len : 0; }
+  String lastId() const { return hasLast() ? String(last()->id) : String(); }
+
+  const Frame* last() const;
+  const Frame* find(const char* id) const;
+  // Pinned access for other tasks (HTTP): capture() skips pinned slots until unpin()
+  const Frame* pin(const char* id);   // id==nullptr/"" → newest
+  void unpin(const Frame* f);
+
+  // Hot mode: a background task keeps the newest framebuffer ready (PSRAM boards only)
+  bool startHot();
+  void stopHot();
+  bool hot() const { return _hot; }
+
+  // Direct driver access for other consumers (e.g. CameraStreamer): the framebuffer is
+  // handed out as-is (no copy) and must be given back with releaseFb().
+  camera_fb_t* acquire(Profile p);
+  void releaseFb(camera_fb_t* fb){ if (fb) esp_camera_fb_return(fb); }
+  static Profile parseProfile(const String& q);
 
 private:
   int _flash;
-  uint8_t* _last = nullptr;
-  size_t _lastLen = 0;
-  String _lastId;
-  void setQuality(const String& q);
+  Frame _ring[CAM_RING_SLOTS];
+  uint8_t _slots = 1;      // active ring size (1 without PSRAM)
+  uint8_t _head = 0;       // next slot to overwrite
+  int8_t _newest = -1;     // slot of the latest capture
+#if defined(ESP32)
+  portMUX_TYPE _ringMux = portMUX_INITIALIZER_UNLOCKED;   // slot ownership: capture vs HTTP readers
+#endif
+  Frame* claimSlot();      // oldest unpinned slot, invalidated for writing
+  bool _zeroCopy = false;  // hold driver framebuffers instead of copying
+  Profile _profile = Profile::None;  // what the sensor is currently configured for
+
+  volatile bool _hot = false;
+  camera_fb_t* _hotFb = nullptr;     // newest frame grabbed by the hot task
+#if defined(ESP32)
+  TaskHandle_t _hotTask = nullptr;
+  SemaphoreHandle_t _camLock = nullptr;  // serialises driver access (grab/reconfig)
+  portMUX_TYPE _hotMux = portMUX_INITIALIZER_UNLOCKED;
+  static void _hotLoop(void* pv);
+#endif
+  camera_fb_t* takeHot();
+  void dropHot();
+
+  bool applyProfile(Profile p);      // true if the sensor was actually reconfigured
   static void warmup(int count=2, int delayMs=30);
-  bool capture(const String& quality, const String& flashMode);
-};
\ No newline at end of file
+  void release(Frame& f);
+  bool capture(const String& quality, const String& flashMode, Timing& t);
+  static bool parseVariant(JsonVariantConst v, VariantSpec& spec);
+  // Scaled JPEG decode of the ROI → (resize, gray) → JPEG re-encode into f.var[f.nvar]
+  bool makeVariant(Frame& f, const VariantSpec& spec);
+};
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include "esp_http_server.h"
+#include "camera_ai_thinker.h"
+
+#ifndef CAM_STREAM_PORT
+#define CAM_STREAM_PORT 81   // separate from the main-loop WebServer
+#endif
+#ifndef CAM_STREAM_CORE
+#define CAM_STREAM_CORE 0    // Arduino loop() runs on core 1
+#endif
+
+// MJPEG (multipart/x-mixed-replace) stream served by esp_http_server on its own task.
+// Frames go straight from the driver framebuffer to the socket; MQTT/loop() is never involved.
+class CameraStreamer {
+public:
+  explicit CameraStreamer(CameraAiThinker& cam) : _cam(cam) {}
+  bool start(uint8_t fps, CameraAiThinker::Profile p);
+  void stop();                 // open clients finish their current frame and disconnect
+  bool active() const { return _enabled; }
+  uint8_t clients() const { return _clients; }
+  String url() const;
+
+private:
+  CameraAiThinker& _cam;
+  httpd_handle_t _httpd = nullptr;
+  volatile bool _enabled = false;
+  volatile uint8_t _fps = 10;
+  volatile CameraAiThinker::Profile _profile = CameraAiThinker::Profile::Low;
+  volatile uint8_t _clients = 0;
+  static esp_err_t _handler(httpd_req_t* req);
+};
+
+// start_stream / stop_stream tools so the LLM side can bring the stream up on demand
+class CameraStreamTool : public ITool {
+public:
+  CameraStreamTool(CameraStreamer& s, bool start) : _s(s), _start(start) {}
+  bool init() override { return true; }
+  const char* name() const override { return _start ? "start_stream" : "stop_stream"; }
+  void describe(JsonObject& tool) override;
+  bool invoke(JsonObjectConst args, ObservationBuilder& out) override;
+private:
+  CameraStreamer& _s;
+  bool _start;
+};
@@ -1,7 +1,13 @@
 #include "hooks.h"
 #include "registry.h"
 #include "modules/camera_ai_thinker.h"
+#include "modules/camera_stream.h"
 void register_tools(ToolRegistry& reg, const ToolConfig& cfg){
   auto* cam = new CameraAiThinker(4);
   reg.add(cam);
+
+  // MJPEG stream on :81/stream, started/stopped on demand
+  auto* stream = new CameraStreamer(*cam);
+  reg.add(new CameraStreamTool(*stream, true));
+  reg.add(new CameraStreamTool(*stream, false));
 }
\ No newline at end of file
@@ -1,43 +1,120 @@
 #pragma once
 #include <Arduino.h>
-#include <ESP32Servo.h>
 #include "tool.h"
+#include "obs_emitter.h"
+#include "servo_motion.h"
 
 // 보드에 맞춰 바꿔도 됨
 #ifndef SERVO_PIN
 #define SERVO_PIN 6
 #endif
+#ifndef SERVO_REST_DEG
+#define SERVO_REST_DEG 10       // 출발/복귀 각도
+#endif
 
+// 서보 동작 툴: invoke는 동작을 큐에 넣고 즉시 motion_id를 돌려줌.
+// 실제 이동은 tick()에서 진행되고, 동작마다 완료(motion.done/motion.cancelled) 이벤트를 emit.
 class Motor_rotate : public ITool {
 public:
-  explicit Motor_rotate(int pin = SERVO_PIN) : _pin(pin) {}
+  explicit Motor_rotate(int pin = SERVO_PIN, int pin2 = -1, int pin3 = -1, int pin4 = -1)
+  : _pins{pin, pin2, pin3, pin4} {}
 
   bool init() override {
-    _servo.setPeriodHertz(50);      // SG90 표준
-    _servo.attach(_pin, 500, 2400); // 안전 범위
-    _servo.write(10);                // 출발 각도(0도)
-    return true;
+    bool ok = false;
+    for (uint8_t i = 0; i < 4 && i < SERVO_MAX; i++)
+      ok = _motion.attach(i, _pins[i], SERVO_REST_DEG) || ok;
+    _motion.onDone(&Motor_rotate::_onDone, this);
+    return ok;
   }
 
   const char* name() const override { return "Motor"; }
 
   void describe(JsonObject& tool) override {
     tool["name"] = name();
-    tool["description"] = "3초 회전 후 복귀";
+    tool["description"] = "서보 이동 (인자 없으면 3초 회전 후 복귀). 즉시 motion_id 반환, 완료는 이벤트로 통지";
     auto params = tool.createNestedObject("parameters");
-    params["type"] = "object";      // 파라미터 없음
+    params["type"] = "object";
+    auto props = params.createNestedObject("properties");
+    props["op"]["type"] = "string";              // move(기본) | cancel
+    auto ops = props["op"].createNestedArray("enum");
+    ops.add("move"); ops.add("cancel");
+    props["servo"]["type"] = "integer";          // 0..SERVO_MAX-1 (기본 0)
+    props["angle"]["type"] = "number";           // 목표 각도 0..180
+    props["duration_ms"]["type"] = "integer";    // 이동 시간 (기본 400)
+    props["hold_ms"]["type"] = "integer";        // 도착 후 유지
+    props["ease"]["type"] = "string";            // linear | ease | trapezoid
+    auto eases = props["ease"].createNestedArray("enum");
+    eases.add("linear"); eases.add("ease"); eases.add("trapezoid");
+    props["replace"]["type"] = "boolean";        // true면 대기 중 동작 취소 후 시작
+    props["motion_id"]["type"] = "integer";      // cancel 대상 (없으면 서보 전체)
   }
 
-  bool invoke(JsonObjectConst /*args*/, ObservationBuilder& out) override {
-    _servo.write(100);        
-    delay(3000);            
-    _servo.write(10);         
-    out.success("Done");
+  bool invoke(JsonObjectConst args, ObservationBuilder& out) override {
+    const char* op = args["op"] | "move";
+    uint8_t servo = args["servo"] | 0;
+
+    if (strcmp(op, "cancel") == 0) {
+      uint32_t id = args["motion_id"] | 0;
+      bool ok = id ? _motion.cancelById(id) : _motion.cancel(servo, 0);
+      if (!ok) { out.error("not_found", "no such motion"); return false; }
+      out.success("cancelled");
+      return true;
+    }
+
+    if (!_motion.attached(servo)) { out.error("bad_request", "no such servo"); return false; }
+
+    ServoMotion::Move m;
+    m.durMs  = (uint16_t)constrain(args["duration_ms"] | 400, 0, 60000);
+    m.holdMs = (uint16_t)constrain(args["hold_ms"] | 0, 0, 60000);
+    m.ease   = ServoMotion::parseEase(args["ease"] | "ease");
+    const bool replace = args["replace"] | false;
+
+    uint32_t id;
+    if (args.containsKey("angle")) {
+      m.target = constrain(args["angle"].as<float>(), 0.0f, 180.0f);
+      id = _motion.enqueue(servo, m, replace);
+    } else {
+      // 기존 동작: 100도로 회전, 3초 유지 후 복귀 (두 동작, 마지막 id 반환)
+      // 두 동작이 모두 들어갈 자리가 없으면 아무것도 넣지 않음 (첫 동작만 남지 않게)
+      id = 0;
+      if (replace || _motion.room(servo) >= 2) {
+        m.target = 100; m.holdMs = 3000;
+        id = _motion.enqueue(servo, m, replace);
+        m.target = SERVO_REST_DEG; m.holdMs = 0;
+        id = _motion.enqueue(servo, m, false);
+      }
+    }
+    if (!id) { out.error("busy", "motion queue full"); return false; }
+
+    char txt[32]; snprintf(txt, sizeof(txt), "queued motion %lu", (unsigned long)id);
+    out.success(String(txt));   // txt는 스택 버퍼: 응답 직렬화 전에 사라지므로 복사
+    auto a = out.addAsset();
+    a["kind"] = "motion";
+    a["motion_id"] = id;
+    a["servo"] = servo;
     return true;
   }
-  
+
+  // 동작 중엔 MOTION_STEP_MS마다, 아니면 잠듦
+  uint32_t nextTickMs(uint32_t now_ms) override { return _motion.busy() ? now_ms + MOTION_STEP_MS : TICK_IDLE; }
+
+  void tick(uint32_t now_ms) override { _motion.tick(now_ms); }
 
 private:
-  int _pin;
-  Servo _servo;
+  static void _onDone(void* ctx, uint8_t servo, uint32_t id, bool cancelled, float deg){
+    Motor_rotate* self = static_cast<Motor_rotate*>(ctx);
+    ObservationBuilder ob;
+    ob.success(cancelled ? "cancelled" : "Done");
+    ob.doc["source"] = self->name();
+    auto a = ob.addAsset();
+    a["kind"] = "event";
+    a["event_type"] = cancelled ? "motion.cancelled" : "motion.done";
+    a["motion_id"] = id;
+    a["servo"] = servo;
+    a["angle"] = deg;
+    if (auto* e = get_global_emitter()) e->emit(ob);
+  }
+
+  int _pins[4];
+  ServoMotion _motion;
 };
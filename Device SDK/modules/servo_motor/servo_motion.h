@@ -0,0 +1,167 @@
+#pragma once
+#include <Arduino.h>
+#include <ESP32Servo.h>
+
+#ifndef SERVO_MAX
+#define SERVO_MAX 4            // 디바이스당 서보 수
+#endif
+#ifndef MOTION_QUEUE
+#define MOTION_QUEUE 4         // 서보별 대기 가능한 동작 수
+#endif
+#ifndef MOTION_STEP_MS
+#define MOTION_STEP_MS 20      // 궤적 갱신 주기 (서보 50Hz 주기와 동일)
+#endif
+
+// tick 구동 서보 모션 엔진 (블로킹 없음)
+// - 서보마다 동작 큐: 현재 동작이 끝나면(hold 포함) 다음 동작 시작
+// - 궤적: linear / ease(cubic in-out) / trapezoid(가감속 25%)
+// - 동작이 끝나거나 취소되면 onDone 콜백 (loop()에서 호출됨)
+class ServoMotion {
+public:
+  enum class Ease : uint8_t { Linear, Smooth, Trapezoid };
+
+  struct Move {
+    uint32_t id = 0;
+    float    target = 0;      // deg
+    uint16_t durMs = 0;       // 이동 시간 (0 = 즉시)
+    uint16_t holdMs = 0;      // 도착 후 유지 시간 (이 동안 다음 동작 대기)
+    Ease     ease = Ease::Smooth;
+  };
+
+  using DoneFn = void (*)(void* ctx, uint8_t servo, uint32_t id, bool cancelled, float deg);
+
+  void onDone(DoneFn fn, void* ctx){ _done = fn; _ctx = ctx; }
+
+  bool attach(uint8_t idx, int pin, float startDeg){
+    if (idx >= SERVO_MAX || pin < 0) return false;
+    Channel& c = _ch[idx];
+    c.servo.setPeriodHertz(50);        // SG90 표준
+    c.servo.attach(pin, 500, 2400);    // 안전 범위
+    c.pos = startDeg;
+    _write(c, startDeg);
+    c.attached = true;
+    return true;
+  }
+
+  bool attached(uint8_t idx) const { return idx < SERVO_MAX && _ch[idx].attached; }
+
+  // 큐에 더 넣을 수 있는 동작 수 (여러 동작을 한꺼번에 넣기 전에 확인)
+  uint8_t room(uint8_t idx) const { return attached(idx) ? MOTION_QUEUE - _ch[idx].count : 0; }
+
+  // replace=true면 진행/대기 중 동작을 취소하고 바로 시작. 0 = 큐 가득/서보 없음
+  uint32_t enqueue(uint8_t idx, Move m, bool replace){
+    if (!attached(idx)) return 0;
+    Channel& c = _ch[idx];
+    if (replace) cancel(idx, 0);
+    if (c.count >= MOTION_QUEUE) return 0;
+    m.id = ++_nextId;
+    c.q[(c.head + c.count) % MOTION_QUEUE] = m;
+    c.count++;
+    return m.id;
+  }
+
+  // id=0이면 해당 서보의 모든 동작 취소. 현재 위치에서 정지
+  bool cancel(uint8_t idx, uint32_t id){
+    if (!attached(idx)) return false;
+    Channel& c = _ch[idx];
+    bool found = false;
+    uint8_t keep = 0;
+    Move kept[MOTION_QUEUE];
+    for (uint8_t i = 0; i < c.count; i++) {
+      const Move& m = c.q[(c.head + i) % MOTION_QUEUE];
+      if (id == 0 || m.id == id) {
+        found = true;
+        if (i == 0 && c.running) c.running = false;
+        if (_done) _done(_ctx, idx, m.id, true, c.pos);
+      } else {
+        kept[keep++] = m;
+      }
+    }
+    for (uint8_t i = 0; i < keep; i++) c.q[i] = kept[i];
+    c.head = 0; c.count = keep;
+    return found;
+  }
+
+  bool cancelById(uint32_t id){
+    for (uint8_t i = 0; i < SERVO_MAX; i++) if (cancel(i, id)) return true;
+    return false;
+  }
+
+  bool busy() const {
+    for (auto& c : _ch) if (c.count) return true;
+    return false;
+  }
+
+  float position(uint8_t idx) const { return idx < SERVO_MAX ? _ch[idx].pos : 0; }
+
+  void tick(uint32_t now){
+    for (uint8_t i = 0; i < SERVO_MAX; i++) {
+      Channel& c = _ch[i];
+      if (!c.attached || !c.count) continue;
+      Move& m = c.q[c.head];
+      if (!c.running) { c.running = true; c.start = now; c.from = c.pos; }
+
+      uint32_t el = now - c.start;
+      if (el < m.durMs) {
+        float s = _profile(m.ease, (float)el / (float)m.durMs);
+        c.pos = c.from + (m.target - c.from) * s;
+        _write(c, c.pos);
+        continue;
+      }
+      if (c.pos != m.target) { c.pos = m.target; _write(c, c.pos); }
+      if (el < (uint32_t)m.durMs + m.holdMs) continue;
+
+      // 완료 → 다음 동작
+      uint32_t id = m.id;
+      c.head = (c.head + 1) % MOTION_QUEUE;
+      c.count--;
+      c.running = false;
+      if (_done) _done(_ctx, i, id, false, c.pos);
+    }
+  }
+
+  static Ease parseEase(const char* s){
+    if (!s) return Ease::Smooth;
+    if (strcmp(s, "linear") == 0)    return Ease::Linear;
+    if (strcmp(s, "trapezoid") == 0) return Ease::Trapezoid;
+    return Ease::Smooth;
+  }
+
+private:
+  struct Channel {
+    Servo servo;
+    bool attached = false;
+    float pos = 0, from = 0;
+    bool running = false;
+    uint32_t start = 0;
+    Move q[MOTION_QUEUE];
+    uint8_t head = 0, count = 0;
+  };
+
+  // 진행률 u(0..1) → 위치 비율 s(0..1)
+  static float _profile(Ease e, float u){
+    switch (e) {
+      case Ease::Linear: return u;
+      case Ease::Trapezoid: {
+        const float ta = 0.25f, vmax = 1.0f / (1.0f - ta);
+        if (u < ta)        return 0.5f * vmax / ta * u * u;
+        if (u < 1.0f - ta) return 0.5f * vmax * ta + vmax * (u - ta);
+        float r = 1.0f - u;
+        return 1.0f - 0.5f * vmax / ta * r * r;
+      }
+      case Ease::Smooth:
+      default: return u * u * (3.0f - 2.0f * u);
+    }
+  }
+
+  // 각도 대신 펄스폭으로 써서 1도 미만 단계도 반영
+  static void _write(Channel& c, float deg){
+    deg = constrain(deg, 0.0f, 180.0f);
+    c.servo.writeMicroseconds(500 + (int)(deg * (2400 - 500) / 180.0f + 0.5f));
+  }
+
+  Channel _ch[SERVO_MAX];
+  uint32_t _nextId = 0;
+  DoneFn _done = nullptr;
+  void* _ctx = nullptr;
+};
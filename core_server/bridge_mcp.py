@@ -16,11 +16,16 @@ MQTT <-> MCP Bridge (웹 인터페이스 제거, MCP SSE 전용)
       - bridge://projections
 - SSE endpoint for MCP: /sse (포트 8083)
 """
-import os, sys, json, time, uuid, threading, queue, requests, logging, socket, base64, io
+import os, sys, json, time, uuid, threading, queue, requests, logging, socket, base64, io, struct, hashlib
 from datetime import datetime, timezone
 from typing import Any, Dict, Optional, List, Union
 from pathlib import Path
 
+try:
+    import msgpack  # optional: binary cmd/events for devices advertising it
+except ImportError:
+    msgpack = None
+
 # FastMCP and MCP types
 from mcp.server.fastmcp import FastMCP, Context
 from mcp.types import ImageContent, TextContent, Resource
@@ -38,12 +43,20 @@ MQTT_PORT = int(os.getenv("MQTT_PORT", "1883"))
 KEEPALIVE = int(os.getenv("KEEPALIVE", "60"))
 API_PORT  = int(os.getenv("API_PORT", "8083"))       # MCP SSE 전용
 CMD_TIMEOUT_MS = int(os.getenv("CMD_TIMEOUT_MS", "8000"))
+JOB_TIMEOUT_MS = int(os.getenv("JOB_TIMEOUT_MS", "30000"))  # after device.ack (long-running tools)
+CMD_QOS        = int(os.getenv("CMD_QOS", "1"))        # device subscribes cmd with QoS1
+CMD_RETRIES    = int(os.getenv("CMD_RETRIES", "1"))    # re-sends with the same request_id; device dedupes
+ASSET_TRANSPORT = os.getenv("ASSET_TRANSPORT", "http")  # mqtt: device pushes assets as chunks (NAT/VLAN)
+ASSET_WAIT_MS   = int(os.getenv("ASSET_WAIT_MS", "5000"))
+WIRE_FORMAT    = os.getenv("WIRE_FORMAT", "auto")  # auto: msgpack when the device announces it, json: always JSON
 SUB_ALL        = os.getenv("DEBUG_SUB_ALL", "0") == "1"
 PROJECTION_CONFIG_PATH = os.getenv("PROJECTION_CONFIG_PATH", "./projection_config.json")
 
 TOPIC_ANN  = "mcp/dev/+/announce"
 TOPIC_STAT = "mcp/dev/+/status"
 TOPIC_EV   = "mcp/dev/+/events"
+TOPIC_EV_MP = "mcp/dev/+/events.mp"
+TOPIC_ASSETS = "mcp/dev/+/assets/#"
 
 def now_iso() -> str:
     return datetime.now(timezone.utc).strftime("%Y-%m-%dT%H:%M:%SZ")
@@ -270,12 +283,28 @@ class DeviceStore:
         self._by_id: Dict[str, Dict[str, Any]] = {}
         self._lock = threading.Lock()
 
+    def schema_hash(self, device_id: str) -> Optional[str]:
+        with self._lock:
+            d = self._by_id.get(device_id)
+            return d.get("schema_hash") if d and d.get("tools") else None
+
+    def touch_announce(self, device_id: str, msg: Dict[str, Any]):
+        """Announce with an unchanged schema_hash: refresh metadata, keep parsed tools"""
+        with self._lock:
+            d = self._by_id.setdefault(device_id, {"device_id": device_id})
+            d["http_base"] = msg.get("http_base", d.get("http_base"))
+            d["encodings"] = msg.get("encodings", ["json"])
+            d["last_announce"] = msg
+            d["last_seen"] = now_iso()
+
     def upsert_announce(self, device_id: str, msg: Dict[str, Any]):
         with self._lock:
             d = self._by_id.setdefault(device_id, {"device_id": device_id})
             d["name"] = msg.get("name")
             d["version"] = msg.get("version")
             d["http_base"] = msg.get("http_base")
+            d["schema_hash"] = msg.get("schema_hash")
+            d["encodings"] = msg.get("encodings", ["json"])
             d["tools"] = msg.get("tools", [])
             d["last_announce"] = msg
             d["last_seen"] = now_iso()
@@ -330,13 +359,15 @@ class CommandWaiter:
 
     def register(self, rid: str) -> queue.Queue:
         with self._lock:
-            q = queue.Queue(maxsize=1)
+            q = queue.Queue(maxsize=4)
             self._qmap[rid] = q
             return q
 
     def resolve(self, rid: str, payload: Dict[str, Any]):
+        # device.ack is an intermediate message; keep waiting for the observation
+        is_ack = payload.get("type") == "device.ack"
         with self._lock:
-            q = self._qmap.pop(rid, None)
+            q = self._qmap.get(rid) if is_ack else self._qmap.pop(rid, None)
         if q:
             try:
                 q.put_nowait(payload)
@@ -348,6 +379,69 @@ cmd_waiter = CommandWaiter()
 # ========= MQTT Client (thread) =========
 import paho.mqtt.client as mqtt
 
+# ========= MQTT asset reassembly =========
+class AssetStore:
+    """Reassembles chunked assets from mcp/dev/<id>/assets/<asset_id>.
+
+    Every chunk: b"MCPA" | seq u16 | count u16 | offset u32 | total u32 (little endian) | data.
+    count == 0 means the device no longer holds the asset. Chunks may arrive in any order;
+    the asset entry of the observation carries size and sha256 for verification.
+    """
+    HDR = struct.Struct("<4sHHII")
+    TTL_S = 120
+
+    def __init__(self):
+        self._lock = threading.Condition()
+        self._parts: Dict[str, Dict[str, Any]] = {}
+
+    def on_chunk(self, asset_id: str, payload: bytes):
+        if len(payload) < self.HDR.size:
+            return
+        magic, seq, count, offset, total = self.HDR.unpack_from(payload)
+        if magic != b"MCPA":
+            return
+        now = time.time()
+        with self._lock:
+            for k in [k for k, v in self._parts.items() if now - v["ts"] > self.TTL_S]:
+                del self._parts[k]
+            e = self._parts.get(asset_id)
+            if e is None or e["total"] != total or e["count"] != count:
+                e = {"buf": bytearray(total), "seen": set(), "count": count, "total": total, "ts": now}
+                self._parts[asset_id] = e
+            data = payload[self.HDR.size:]
+            if count and offset + len(data) <= total:
+                e["buf"][offset:offset + len(data)] = data
+                e["seen"].add(seq)
+            e["ts"] = now
+            self._lock.notify_all()
+
+    def wait(self, asset_id: str, size: int, sha256: Optional[str], timeout_ms: int) -> Optional[bytes]:
+        deadline = time.time() + timeout_ms / 1000.0
+        with self._lock:
+            while True:
+                e = self._parts.get(asset_id)
+                if e and e["count"] == 0:
+                    log(f"[ASSET] {asset_id} expired on device")
+                    return None
+                if e and len(e["seen"]) == e["count"]:
+                    data = bytes(e.pop("buf"))
+                    del self._parts[asset_id]
+                    break
+                left = deadline - time.time()
+                if left <= 0:
+                    log(f"[ASSET] {asset_id} incomplete after {timeout_ms}ms")
+                    return None
+                self._lock.wait(left)
+        if size and len(data) != size:
+            log(f"[ASSET] {asset_id} size mismatch ({len(data)} != {size})")
+            return None
+        if sha256 and hashlib.sha256(data).hexdigest() != sha256:
+            log(f"[ASSET] {asset_id} sha256 mismatch")
+            return None
+        return data
+
+asset_store = AssetStore()
+
 def parse_topic(topic: str):
     parts = topic.split("/")
     if len(parts) >= 4:
@@ -372,21 +466,32 @@ def mqtt_thread():
             c.subscribe(TOPIC_ANN); log(f"[mqtt] subscribe {TOPIC_ANN}")
             c.subscribe(TOPIC_STAT); log(f"[mqtt] subscribe {TOPIC_STAT}")
             c.subscribe(TOPIC_EV); log(f"[mqtt] subscribe {TOPIC_EV}")
+            if msgpack:
+                c.subscribe(TOPIC_EV_MP); log(f"[mqtt] subscribe {TOPIC_EV_MP}")
+            c.subscribe(TOPIC_ASSETS); log(f"[mqtt] subscribe {TOPIC_ASSETS}")
 
     def on_message(c, userdata, msg):
         log(f"[mqtt] RX {msg.topic} {len(msg.payload)}B")
         dev_id, leaf = parse_topic(msg.topic)
         if not dev_id or not leaf:
             return
+        if leaf == "assets":
+            asset_store.on_chunk(msg.topic.split("/", 4)[-1], msg.payload)
+            return
         try:
-            payload = json.loads(msg.payload.decode("utf-8"))
+            if leaf.endswith(".mp"):
+                if not msgpack:
+                    return
+                payload = msgpack.unpackb(msg.payload, raw=False)
+                leaf = leaf[:-3]
+            else:
+                payload = json.loads(msg.payload.decode("utf-8"))
         except Exception:
-            log("[mqtt] JSON parse error from broker")
+            log(f"[mqtt] {'MsgPack' if leaf.endswith('.mp') else 'JSON'} parse error from broker")
             return
 
         if leaf == "announce":
-            device_store.upsert_announce(dev_id, payload)
-            register_dynamic_tools_for_device(dev_id)
+            handle_announce(dev_id, payload)
         elif leaf == "status":
             device_store.update_status(dev_id, payload)
         elif leaf == "events":
@@ -400,13 +505,47 @@ def mqtt_thread():
     client.connect(MQTT_HOST, MQTT_PORT, keepalive=KEEPALIVE)
     client.loop_forever(retry_first_connection=True)
 
+def fetch_announce_schema(dev_id: str, msg: Dict[str, Any]):
+    """Pull the full schema from the device's /announce.json (off the MQTT thread)"""
+    url = msg.get("schema_url") or f"{msg.get('http_base', '')}/announce.json"
+    try:
+        r = requests.get(url, timeout=5)
+        r.raise_for_status()
+        full = r.json()
+    except Exception as e:
+        log(f"[ANNOUNCE] schema fetch failed for {dev_id} ({url}): {e}")
+        return
+    full.setdefault("schema_hash", msg.get("schema_hash"))
+    device_store.upsert_announce(dev_id, full)
+    register_dynamic_tools_for_device(dev_id)
+    log(f"[ANNOUNCE] {dev_id} schema {full.get('schema_hash')} ({len(full.get('tools', []))} tools)")
+
+def handle_announce(dev_id: str, payload: Dict[str, Any]):
+    if not payload:
+        return  # retained announce cleared
+    h = payload.get("schema_hash")
+    if "tools" in payload or not h:
+        # legacy / inline announce
+        device_store.upsert_announce(dev_id, payload)
+        register_dynamic_tools_for_device(dev_id)
+    elif device_store.schema_hash(dev_id) == h:
+        device_store.touch_announce(dev_id, payload)
+    else:
+        threading.Thread(target=fetch_announce_schema, args=(dev_id, payload), daemon=True).start()
+
 threading.Thread(target=mqtt_thread, daemon=True).start()
 
 # ========= Publish helper =========
+def wire_format(device_id: str) -> str:
+    """msgpack if enabled here, installed, and announced by the device; else json"""
+    if WIRE_FORMAT != "auto" or not msgpack:
+        return "json"
+    d = device_store.get(device_id) or {}
+    return "msgpack" if "msgpack" in (d.get("encodings") or []) else "json"
+
 def publish_cmd(device_id: str, tool: str, args: Any,
                 request_id: Optional[str]=None, timeout_ms: int=CMD_TIMEOUT_MS):
     rid = request_id or uuid.uuid4().hex
-    topic = f"mcp/dev/{device_id}/cmd"
     
     if isinstance(args, str):
         parsed_args = {}
@@ -423,6 +562,15 @@ def publish_cmd(device_id: str, tool: str, args: Any,
         args = args["kwargs"]
     
     payload = {"type":"device.command","tool":tool,"args":args,"request_id":rid}
+    if ASSET_TRANSPORT == "mqtt":
+        payload["asset_transport"] = "mqtt"
+    return publish_request(device_id, payload, timeout_ms)
+
+def publish_request(device_id: str, payload: Dict[str, Any], timeout_ms: int=CMD_TIMEOUT_MS):
+    """Publish any request (device.command, device.rules, ...) on the cmd topic and wait for
+    the event carrying its request_id"""
+    rid = payload.setdefault("request_id", uuid.uuid4().hex)
+    topic = f"mcp/dev/{device_id}/cmd"
     log(f"[DEBUG] Publishing to {topic}: {json.dumps(payload, indent=2)}")
     
     q = cmd_waiter.register(rid)
@@ -444,19 +592,85 @@ def publish_cmd(device_id: str, tool: str, args: Any,
                                               "message": f"cannot connect to broker {MQTT_HOST}:{MQTT_PORT} ({e})"},
                        "request_id": rid}
 
-    c.loop_start()
-    c.publish(topic, json.dumps(payload), qos=0, retain=False)
-    c.loop_stop()
-    c.disconnect()
+    def send():
+        c.loop_start()
+        if wire_format(device_id) == "msgpack":
+            info = c.publish(topic + ".mp", msgpack.packb(payload, use_bin_type=True), qos=CMD_QOS, retain=False)
+        else:
+            info = c.publish(topic, json.dumps(payload), qos=CMD_QOS, retain=False)
+        if CMD_QOS > 0:
+            try: info.wait_for_publish(timeout=timeout_ms/1000.0)
+            except Exception as e: log(f"[CMD] {rid} publish not acknowledged: {e}")
+        c.loop_stop()
+        c.disconnect()
 
     try:
-        resp = q.get(timeout=timeout_ms/1000.0)
+        send()
+        for attempt in range(CMD_RETRIES + 1):
+            try:
+                resp = q.get(timeout=timeout_ms/1000.0)
+                break
+            except queue.Empty:
+                if attempt == CMD_RETRIES:
+                    raise
+                # same request_id: the device answers from its result cache or attaches
+                # to the running job instead of invoking the tool again
+                log(f"[CMD] {rid} no reply within {timeout_ms}ms, retrying ({attempt + 1}/{CMD_RETRIES})")
+                try:
+                    c.connect(MQTT_HOST, MQTT_PORT, keepalive=KEEPALIVE)
+                    send()
+                except Exception as e:
+                    log(f"[CMD] {rid} retry publish failed: {e}")
+        while resp.get("type") == "device.ack":
+            log(f"[CMD] {rid} acked ({resp.get('status')}), waiting up to {JOB_TIMEOUT_MS}ms")
+            timeout_ms = JOB_TIMEOUT_MS
+            resp = q.get(timeout=timeout_ms/1000.0)
         return True, resp
     except queue.Empty:
         return False, {"ok": False, "error": {"code":"timeout",
                                               "message": f"no event for request_id={rid} within {timeout_ms}ms"},
                        "request_id": rid}
 
+def publish_batch(device_id: str, steps: List[Dict[str, Any]], mode: str = "sequential",
+                  stop_on_error: Optional[bool] = None, timeout_ms: int = CMD_TIMEOUT_MS):
+    """Several tool calls in one device.command_batch (one broker round trip).
+    Steps the device queued on its executor (parallel mode) report as "<rid>/<n>"; their
+    observations are awaited here and merged into result.steps / result.assets."""
+    rid = uuid.uuid4().hex
+    payload = {"type": "device.command_batch", "request_id": rid, "mode": mode,
+               "steps": [{"tool": st.get("tool"), "args": st.get("args") or {}} for st in steps]}
+    if stop_on_error is not None:
+        payload["stop_on_error"] = bool(stop_on_error)
+    if ASSET_TRANSPORT == "mqtt":
+        payload["asset_transport"] = "mqtt"
+    subs = {f"{rid}/{i}": cmd_waiter.register(f"{rid}/{i}") for i in range(len(steps))} if mode == "parallel" else {}
+    ok, resp = publish_request(device_id, payload, timeout_ms)
+    result = resp.get("result") or {}
+    for i, st in enumerate(result.get("steps") or []):
+        q = subs.get(st.get("request_id", ""))
+        if not st.get("queued") or q is None:
+            continue
+        try:
+            sub = q.get(timeout=JOB_TIMEOUT_MS/1000.0)
+            while sub.get("type") == "device.ack":
+                sub = q.get(timeout=JOB_TIMEOUT_MS/1000.0)
+        except queue.Empty:
+            st.update(ok=False, error={"code": "timeout", "message": f"no result for {st['request_id']}"})
+            continue
+        sres = sub.get("result") or {}
+        st.update(ok=bool(sub.get("ok")), text=sres.get("text", ""))
+        if sub.get("error"):
+            st["error"] = sub["error"]
+        for asset in sres.get("assets") or []:
+            result.setdefault("assets", []).append(dict(asset, step=i))
+        if sres.get("text"):
+            result["text"] = "\n".join(t for t in (result.get("text"), f"{st.get('tool')}: {sres['text']}") if t)
+    for q_rid in subs:
+        cmd_waiter.resolve(q_rid, {})   # drop waiters of steps that ran inline
+    if subs and result.get("steps"):
+        resp["ok"] = all(st.get("ok") for st in result["steps"])   # skipped steps carry no "ok"
+    return ok, resp
+
 # ========= Image processing helper =========
 def fetch_and_convert_to_base64(url: str, timeout: int = 10) -> Optional[str]:
     """Fetch image from URL and convert to base64"""
@@ -484,7 +698,13 @@ def convert_response_to_content_list(resp: Dict[str, Any]) -> List[Union[ImageCo
         mime = str(asset.get("mime", "application/octet-stream")).lower()
         url = asset.get("url")
         
-        if kind == "image" and mime.startswith("image/") and url:
+        if kind == "image" and mime.startswith("image/") and asset.get("transport") == "mqtt":
+            data = asset_store.wait(str(asset.get("asset_id", "")), int(asset.get("size") or 0),
+                                    asset.get("sha256"), ASSET_WAIT_MS)
+            if data:
+                content.append(ImageContent(type="image", mimeType=mime,
+                                            data=base64.b64encode(data).decode("utf-8")))
+        elif kind == "image" and mime.startswith("image/") and url:
             b64_data = fetch_and_convert_to_base64(url)
             if b64_data:
                 content.append(ImageContent(
@@ -654,6 +874,18 @@ def invoke(device_id: str, tool: str, args: dict | None = None) -> List[Union[Im
     
     return convert_response_to_content_list(resp)
 
+@mcp.tool()
+def invoke_batch(device_id: str, steps: List[Dict[str, Any]], mode: str = "sequential",
+                 stop_on_error: bool = True) -> List[Union[ImageContent, TextContent]]:
+    """Run several device tools in one round trip. steps: [{"tool": name, "args": {...}}, ...] in order.
+    mode "sequential" runs them one after another (stop_on_error skips the rest after a failure);
+    "parallel" does not wait between steps."""
+    ok, resp = publish_batch(device_id, steps, mode, stop_on_error if mode != "parallel" else None)
+    if not ok:
+        error_msg = resp.get("error", {}).get("message", "Unknown error")
+        return [TextContent(type="text", text=f"Error: {error_msg}")]
+    return convert_response_to_content_list(resp)
+
 @mcp.tool()
 def list_devices() -> List[TextContent]:
     """List devices from announce/status cache with projection info (ACTION/EVENT counts)."""
@@ -858,6 +1090,34 @@ def invoke_api(payload: dict):
     
     return {"ok": True, "response": resp}
 
+@app.post("/devices/{device_id}/batch")
+def batch_api(device_id: str, payload: dict):
+    """Several tool calls in one device.command_batch.
+    Body: {"steps": [{"tool": .., "args": {..}}, ..], "mode": "sequential"|"parallel", "stop_on_error": true}"""
+    steps = payload.get("steps")
+    if not isinstance(steps, list) or not steps:
+        raise HTTPException(HTTPStatus.BAD_REQUEST, "steps is required")
+    log(f"[API] Batch request: device={device_id}, steps={len(steps)}, mode={payload.get('mode', 'sequential')}")
+    ok, resp = publish_batch(device_id, steps, payload.get("mode", "sequential"), payload.get("stop_on_error"))
+    if not ok:
+        return {"ok": False, "error": resp.get("error", {}).get("message", "Unknown error"), "response": resp}
+    return {"ok": bool(resp.get("ok")), "response": resp}
+
+@app.post("/devices/{device_id}/rules")
+def rules_api(device_id: str, payload: dict):
+    """Load on-device reflex rules (device.rules); the device replies with the active table.
+    Body: {"rules": [...], "replace": true} or {"remove": ["id", ...]}; {} lists the rules.
+    Rules live in device RAM: send them again after the device re-announces."""
+    req = {"type": "device.rules"}
+    for key in ("rules", "replace", "remove"):
+        if key in payload:
+            req[key] = payload[key]
+    log(f"[API] Rules request: device={device_id}, rules={len(req.get('rules') or [])}")
+    ok, resp = publish_request(device_id, req)
+    if not ok:
+        return {"ok": False, "error": resp.get("error", {}).get("message", "Unknown error"), "response": resp}
+    return {"ok": bool(resp.get("ok")), "response": resp}
+
 # Mount MCP SSE endpoint - 모든 초기화 후에 실행
 try:
     sse_app = mcp.sse_app()
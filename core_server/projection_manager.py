@@ -89,16 +89,25 @@ class MQTTEventCollector:
                 device_id = parts[2]
                 payload = json.loads(msg.payload.decode('utf-8'))
                 
+                # device.observation_batch: one monitor entry per batched event
+                if payload.get("type") == "device.observation_batch":
+                    entries = [{"type": "device.observation", "ok": True, "source": a.get("source"),
+                                "ts_ms": a.get("ts_ms"), "result": {"text": a.get("text", ""), "assets": [a]}}
+                               for a in payload.get("result", {}).get("assets", [])]
+                else:
+                    entries = [payload]
+                
                 with self._lock:
                     if device_id not in self.events:
                         self.events[device_id] = deque(maxlen=self.max_events)
                     
-                    event_entry = {
-                        "timestamp": now_iso(),
-                        "device_id": device_id,
-                        "payload": payload
-                    }
-                    self.events[device_id].append(event_entry)
+                    for p in entries:
+                        event_entry = {
+                            "timestamp": now_iso(),
+                            "device_id": device_id,
+                            "payload": p
+                        }
+                        self.events[device_id].append(event_entry)
                     
                 log(f"[MQTT] Event from {device_id}: {payload.get('type', 'unknown')}")
         except Exception as e: